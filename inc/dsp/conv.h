@@ -30,6 +30,65 @@ extern "C" {
 #endif
 
 #include <dsp/dsp.h>
+#include <dsp/fft.h>
+
+/*
+ * User defines
+ */
+#ifndef CONV_FFT_MIN
+#define  CONV_FFT_MIN         (320)
+   //!< conv() uses the FFT path when both sizes are at least this ...
+#endif
+#ifndef CONV_FFT_MIN_OPS
+#define  CONV_FFT_MIN_OPS     (100000L)
+   //!< ... and their product is at least this (host measured crossover)
+#endif
+#ifndef CONV_OLS_RATIO
+#define  CONV_OLS_RATIO       (8)
+   //!< Overlap-save block size, as a multiple of the shorter signal size
+#endif
+#ifndef CONV_STREAM_BLK
+#define  CONV_STREAM_BLK      (256)
+   //!< Input samples per block of the direct conv_stream backend
+#endif
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * Streaming convolution backend
+ */
+typedef enum {
+   CONV_STREAM_AUTO=0,  //!< FFT when the kernel size is at least CONV_FFT_MIN
+   CONV_STREAM_DIRECT,  //!< Blocked direct form
+   CONV_STREAM_FFT      //!< FFT overlap-save
+}conv_stream_en;
+
+/*!
+ * Streaming convolution.
+ * Holds a kernel and the last sh-1 input samples, so a signal can be
+ * filtered in blocks of any size. Each block of n inputs gives exactly
+ * the next n outputs of the full convolution, without latency.
+ * The input buffer R keeps the sh-1 history samples followed by up to M
+ * new ones. The FFT backend transforms R when all M are there, and the
+ * outputs of a partially filled R are calculated with the direct form.
+ */
+typedef struct {
+   void           *h;      //!< Pointer to the kernel
+   void           *R;      //!< Pointer to the input buffer, sh-1+M items
+   void           *O;      //!< Pointer to the FFT block output, 2N items
+   void           *H;      //!< Pointer to the kernel spectrum, N complex items
+   void           *B;      //!< Pointer to the block spectrum, N complex items
+   fft_plan_t     p;       //!< The FFT plan
+   conv_stream_en type;    //!< The backend in use, DIRECT or FFT
+   uint32_t       it_size; //!< Each item size
+   uint32_t       sh;      //!< The kernel size
+   uint32_t       N;       //!< The FFT size
+   uint32_t       M;       //!< New samples per block
+   uint32_t       c;       //!< New samples in the input buffer
+   void           *blk;    //!< The owned memory block, NULL for caller supplied memory
+}conv_stream_t;
 
 /*
  * ================== Public API ====================
@@ -41,6 +100,22 @@ void conv_ci (complex_i_t *y, complex_i_t *h, int32_t sh, complex_i_t *x, int32_
 void conv_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_t sx) __O3__ ;
 void conv_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_t sx) __O3__ ;
 
+void conv_fft_f (float *y, float *h, int32_t sh, float *x, int32_t sx) __O3__ ;
+void conv_fft_d (double *y, double *h, int32_t sh, double *x, int32_t sx) __O3__ ;
+void conv_fft_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_t sx) __O3__ ;
+void conv_fft_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_t sx) __O3__ ;
+
+void conv_stream_deinit (conv_stream_t *s);
+uint32_t conv_stream_init_f (conv_stream_t *s, const float *h, uint32_t sh, conv_stream_en type);
+uint32_t conv_stream_init_d (conv_stream_t *s, const double *h, uint32_t sh, conv_stream_en type);
+size_t conv_stream_required_size_f (uint32_t sh, conv_stream_en type);
+size_t conv_stream_required_size_d (uint32_t sh, conv_stream_en type);
+uint32_t conv_stream_init_static_f (conv_stream_t *s, const float *h, uint32_t sh, conv_stream_en type, void *mem, size_t size);
+uint32_t conv_stream_init_static_d (conv_stream_t *s, const double *h, uint32_t sh, conv_stream_en type, void *mem, size_t size);
+void conv_stream_reset (conv_stream_t *s);
+void conv_stream_f (conv_stream_t *s, float *y, const float *x, uint32_t n) __O3__ ;
+void conv_stream_d (conv_stream_t *s, double *y, const double *x, uint32_t n) __O3__ ;
+
 
 #if __STDC_VERSION__ >= 201112L
 
@@ -73,6 +148,10 @@ void conv_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_
  *
  * \return none
  * \note We still have to implement all the functions
+ * \note
+ *    The floating point versions switch to the FFT path of conv_fft()
+ *    when both sizes are at least CONV_FFT_MIN and sh*sx is at least
+ *    CONV_FFT_MIN_OPS.
  */
 #define conv(y, h, sh, x, sx) _Generic((y),  int*: conv_i,   \
                                            float*: conv_f,   \
@@ -82,6 +161,84 @@ void conv_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_
                                      complex_d_t*: conv_cd,  \
                                           default: conv_d)(y, h, sh, x, sx)
 #endif   // #ifndef conv
+
+#ifndef conv_fft
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void conv_fft (T *y, T *h, uint32_t sh, T *x, uint32_t sx);
+ *
+ * \brief
+ *    Calculates the convolution of h and x using the FFT.
+ *    The longer signal is processed in overlap-save blocks of about
+ *    CONV_OLS_RATIO times the shorter one. When the sizes are comparable
+ *    this becomes a single whole-signal block. If the working memory can not
+ *    be allocated, the direct form is used.
+ *
+ * \param   y  Pointer to output vector, size sh+sx-1
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+#define conv_fft(y, h, sh, x, sx) _Generic((y), \
+                                           float*: conv_fft_f,  \
+                                          double*: conv_fft_d,  \
+                                     complex_f_t*: conv_fft_cf, \
+                                     complex_d_t*: conv_fft_cd, \
+                                          default: conv_fft_d)(y, h, sh, x, sx)
+#endif   // #ifndef conv_fft
+
+#ifndef conv_stream_init
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> uint32_t conv_stream_init (conv_stream_t *s, T *h, uint32_t sh, conv_stream_en type);
+ *
+ * \brief
+ *    Initialise a streaming convolution with the kernel h. The kernel is
+ *    copied, the history is cleared.
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \param   h     Pointer to the kernel
+ * \param  sh     Size of the kernel
+ * \param  type   The backend, CONV_STREAM_AUTO, _DIRECT or _FFT
+ *
+ * \return  The input buffer size on success, 0 on failure
+ */
+#define conv_stream_init(s, h, sh, type) _Generic((h), \
+                                           float*: conv_stream_init_f, \
+                                          double*: conv_stream_init_d, \
+                                          default: conv_stream_init_d)(s, h, sh, type)
+#endif   // #ifndef conv_stream_init
+
+#ifndef conv_stream
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void conv_stream (conv_stream_t *s, T *y, T *x, uint32_t n);
+ *
+ * \brief
+ *    Filter the next n input samples. The outputs are the next n points of
+ *    the convolution of the kernel with the whole input so far.
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \param   y     Pointer to output block, size n. It can be the same as x.
+ * \param   x     Pointer to input block
+ * \param   n     The block size, any
+ *
+ * \return none
+ */
+#define conv_stream(s, y, x, n) _Generic((y), \
+                                           float*: conv_stream_f, \
+                                          double*: conv_stream_d, \
+                                          default: conv_stream_d)(s, y, x, n)
+#endif   // #ifndef conv_stream
 #endif   // #if __STDC_VERSION__ >= 201112L
 
 #ifdef __cplusplus
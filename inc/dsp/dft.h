@@ -30,6 +30,58 @@ extern "C" {
 
 #include <dsp/dsp.h>
 #include <math/math.h>
+#include <sys/arena.h>
+#include <string.h>
+
+/*
+ * User defines
+ */
+#ifndef DFT_BINS_BLK
+#define  DFT_BINS_BLK         (32)
+   //!< The number of samples the partial DFT phasor runs before it is re-anchored
+#endif
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * Sliding DFT bin bank.
+ * Keeps K selected bins of the n point DFT of the last n samples current,
+ * updating them on every new sample with
+ *    X[k] = r*w[k] * (X[k] + x - r^n*x[-n]),   w[k] = e^(j2pi*bin[k]/n)
+ * at O(K) cost per sample.
+ */
+typedef struct {
+   complex_d_t *X;      //!< Pointer to the current bins
+   complex_d_t *w;      //!< Pointer to the bin rotation factors
+   double      *d;      //!< Pointer to the n sample delay line
+   double      r;       //!< Damping factor, 1 for the exact DFT
+   double      rn;      //!< r^n
+   uint32_t    n;       //!< The window length
+   uint32_t    K;       //!< The number of bins
+   uint32_t    c;       //!< Delay line cursor
+   void        *blk;    //!< The owned memory block, NULL for caller supplied memory
+}sdft_t;
+
+/*!
+ * Goertzel bin bank.
+ * Calculates K selected, possibly fractional, bins of the n point DFT
+ * of consecutive blocks of n samples, at one real multiplication per
+ * bin and sample.
+ */
+typedef struct {
+   complex_d_t *X;      //!< Pointer to the bins of the last complete block
+   complex_d_t *w;      //!< Pointer to e^(-jw) factors
+   complex_d_t *p;      //!< Pointer to e^(-jw(n-1)) phase factors
+   double      *cf;     //!< Pointer to 2cos(w) coefficients
+   double      *s1;     //!< Pointer to the first state of each bin
+   double      *s2;     //!< Pointer to the second state of each bin
+   uint32_t    n;       //!< The block length
+   uint32_t    K;       //!< The number of bins
+   uint32_t    cnt;     //!< Samples of the current block
+   void        *blk;    //!< The owned memory block, NULL for caller supplied memory
+}goertzel_t;
 
 /*
  * ================== Public API ====================
@@ -113,6 +165,93 @@ void idft_cf (complex_f_t *X, complex_f_t *x, uint32_t n) __O3__ ;
 void idft_r (complex_d_t *X, double *x, uint32_t n) __O3__ ;
 void idft_rf (complex_f_t *X, float *x, uint32_t n) __O3__ ;
 
+
+// Partial spectrum DFT
+#if __STDC_VERSION__ >= 201112L
+
+#ifndef dft_bins
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void dft_bins (T *x, T *X, uint32_t n, const uint32_t *bins, uint32_t K);
+ *
+ * \brief
+ *    Calculate only a list of K bins of the n point DFT. The inner loop
+ *    is a pure multiply-accumulate with a rotating phasor, re-anchored
+ *    every DFT_BINS_BLK samples from a double precision anchor, so the
+ *    trigonometric functions are called only twice per bin.
+ *
+ * \param   x     Pointer to size n time domain array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin[i]
+ * \param   n     Number of points
+ * \param   bins  Pointer to the K bin indexes
+ * \param   K     Number of bins
+ * \return        None
+ */
+#define dft_bins(x, X, n, bins, K)  _Generic((x),  \
+       complex_d_t*: dft_bins_c,                   \
+       complex_f_t*: dft_bins_cf,                  \
+            double*: dft_bins_r,                   \
+             float*: dft_bins_rf,                  \
+            default: dft_bins_r)(x, X, n, bins, K)
+#endif   // #ifndef dft_bins
+
+#ifndef dft_range
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void dft_range (T *x, T *X, uint32_t n, uint32_t k0, uint32_t K);
+ *
+ * \brief
+ *    Calculate only the K consecutive bins [k0..k0+K) of the n point DFT,
+ *    the same way as dft_bins().
+ *
+ * \param   x     Pointer to size n time domain array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin k0+i
+ * \param   n     Number of points
+ * \param   k0    The first bin
+ * \param   K     Number of bins
+ * \return        None
+ */
+#define dft_range(x, X, n, k0, K)   _Generic((x),  \
+       complex_d_t*: dft_range_c,                  \
+       complex_f_t*: dft_range_cf,                 \
+            double*: dft_range_r,                  \
+             float*: dft_range_rf,                 \
+            default: dft_range_r)(x, X, n, k0, K)
+#endif   // #ifndef dft_range
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+void dft_bins_c (complex_d_t *x, complex_d_t *X, uint32_t n, const uint32_t *bins, uint32_t K) __O3__ ;
+void dft_bins_cf (complex_f_t *x, complex_f_t *X, uint32_t n, const uint32_t *bins, uint32_t K) __O3__ ;
+void dft_bins_r (double *x, complex_d_t *X, uint32_t n, const uint32_t *bins, uint32_t K) __O3__ ;
+void dft_bins_rf (float *x, complex_f_t *X, uint32_t n, const uint32_t *bins, uint32_t K) __O3__ ;
+
+void dft_range_c (complex_d_t *x, complex_d_t *X, uint32_t n, uint32_t k0, uint32_t K) __O3__ ;
+void dft_range_cf (complex_f_t *x, complex_f_t *X, uint32_t n, uint32_t k0, uint32_t K) __O3__ ;
+void dft_range_r (double *x, complex_d_t *X, uint32_t n, uint32_t k0, uint32_t K) __O3__ ;
+void dft_range_rf (float *x, complex_f_t *X, uint32_t n, uint32_t k0, uint32_t K) __O3__ ;
+
+/*
+ * Sliding DFT bin bank
+ */
+void sdft_deinit (sdft_t *s);
+uint32_t sdft_init (sdft_t *s, uint32_t n, const uint32_t *bins, uint32_t K, double r);
+size_t sdft_required_size (uint32_t n, uint32_t K);
+uint32_t sdft_init_static (sdft_t *s, uint32_t n, const uint32_t *bins, uint32_t K, double r, void *mem, size_t size);
+complex_d_t *sdft (sdft_t *s, double x) __O3__ ;
+
+/*
+ * Goertzel bin bank
+ */
+void goertzel_deinit (goertzel_t *g);
+uint32_t goertzel_init (goertzel_t *g, uint32_t n, const double *bins, uint32_t K);
+size_t goertzel_required_size (uint32_t K);
+uint32_t goertzel_init_static (goertzel_t *g, uint32_t n, const double *bins, uint32_t K, void *mem, size_t size);
+int goertzel (goertzel_t *g, double x) __O3__ ;
+
 #ifdef __cplusplus
 }
 #endif
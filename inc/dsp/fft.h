@@ -31,10 +31,69 @@ extern "C" {
 
 #include <dsp/dsp.h>
 #include <math/math.h>
+#include <sys/arena.h>
+#include <string.h>
+
+/*
+ * User defines
+ */
+#ifndef FFT_BITREV_BLOCKED_N
+#define  FFT_BITREV_BLOCKED_N    (65536)
+   //!< From this number of points and up, the cache blocked bit reversal is used
+#endif
+#ifndef FFT_BATCH_CH
+#define  FFT_BATCH_CH            (8)
+   //!< The number of channels gathered together by the strided batch transforms
+#endif
+
 /*
  * General Defines
  */
 
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * FFT plan types, selected by the number of points
+ */
+typedef enum {
+   FFT_RADIX2 = 0,      //!< Power of 2 points, radix-2/4 kernels
+   FFT_MIXED_RADIX,     //!< 2^a * 3^b * 5^c points, mixed radix kernels
+   FFT_BLUESTEIN        //!< Any other number of points, Bluestein's algorithm
+}fft_ptype_en;
+
+/*!
+ * FFT plan.
+ * Holds the precomputed twiddle factors and the bit reversal permutation
+ * for a given number of points, so they can be reused across transforms.
+ * \note
+ *    A power of 2 plan of n points serves the n point complex transforms and
+ *    the n point real transforms (which use the n/2 point complex one inside).
+ *    Any other plan serves only the n point transforms.
+ *    A fixed point plan, from fft_plan_fixed_init(), holds only the integer
+ *    tables and serves only the fixed point transforms.
+ *    The *_init_static() variants place the tables in caller supplied memory
+ *    of *_required_size() bytes instead of the heap.
+ */
+typedef struct fft_plan {
+   complex_d_t *w;   //!< Pointer to double precision twiddle table, w[k] = e^(-j2pik/n),
+                     //!< k:[0..3n/4) for radix-2, k:[0..n) for mixed radix.
+                     //!< For Bluestein the chirp, w[k] = e^(-jpik^2/n), k:[0..n)
+   complex_f_t *wf;  //!< Pointer to single precision twiddle table
+   complex_q31_t *wq31; //!< Pointer to Q31 twiddle table, k:[0..n/2) (fixed point plans)
+   complex_q15_t *wq15; //!< Pointer to Q15 twiddle table, k:[0..n/2) (fixed point plans)
+   uint32_t    *r;   //!< Pointer to bit reversal permutation table
+   uint32_t    *f;   //!< Pointer to the mixed radix radix/sub-length pairs
+   complex_d_t *t;   //!< Pointer to scratch array for the not in-place algorithms
+   complex_d_t *k;   //!< Pointer to Bluestein's chirp filter spectrum
+   struct fft_plan *bp; //!< Pointer to Bluestein's inner power of 2 plan
+   fft_ptype_en type;   //!< The plan type
+   uint32_t    n;    //!< The number of points
+   uint32_t    m;    //!< log2(n), the number of stages
+   void        *blk; //!< The owned memory block, NULL for caller supplied memory
+}fft_plan_t;
+
 /*
  * ========= Public API ============
  */
@@ -59,6 +118,11 @@ extern "C" {
  *    - Not in-place.   Use pointers to different arrays for time and frequency
  *    - In-place        Use the same pointer for time and frequency
  *
+ * \note
+ *    Any number of points is supported. For non power of 2 points a temporary
+ *    plan is created and destroyed on each call, so for repeated transforms
+ *    use fftp() instead.
+ *
  * \param   x     Pointer to size n time domain array
  * \param   X     Pointer to size n frequency domain array
  * \param   n     Number of points
@@ -110,6 +174,9 @@ void fft_ri (int *x, complex_f_t *X, uint32_t n) __O3__ ;
  *    case or real inverse fft the real time domain pointers MUST point to arrays
  *    with size 2*n
  *
+ * \note
+ *    As with fft(), any number of points is supported.
+ *
  * \param   X     Pointer to size n frequency domain array
  * \param   x     Pointer to time domain array. size n for complex, size 2*n for real signals
  * \param   n     Number of points
@@ -129,6 +196,256 @@ void ifft_cf (complex_f_t *X, complex_f_t *x, uint32_t n) __O3__ ;
 void ifft_r (complex_d_t *X, double *x, uint32_t n) __O3__ ;
 void ifft_rf (complex_f_t *X, float *x, uint32_t n) __O3__ ;
 
+
+/*
+ * FFT plan API
+ */
+void fft_plan_deinit (fft_plan_t *p);
+uint32_t fft_plan_init (fft_plan_t *p, uint32_t n);
+size_t fft_plan_required_size (uint32_t n);
+uint32_t fft_plan_init_static (fft_plan_t *p, uint32_t n, void *mem, size_t size);
+
+// Forward FFT using plan
+#if __STDC_VERSION__ >= 201112L
+
+#ifndef fftp
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void fftp (fft_plan_t *p, T *x, T *X);
+ *
+ * \brief
+ *    Calculate the forward FFT for complex and real signals using a
+ *    precomputed plan. The number of points is the plan's size.
+ *    The in-place/not in-place rules of fft() apply here too.
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     Pointer to size n time domain array
+ * \param   X     Pointer to size n frequency domain array
+ * \return        None
+ */
+#define fftp(p, x, X)      _Generic((x),  \
+       complex_d_t*: fftp_c,              \
+       complex_f_t*: fftp_cf,             \
+       complex_i_t*: fftp_ci,             \
+            double*: fftp_r,              \
+             float*: fftp_rf,             \
+               int*: fftp_ri,             \
+            default: fftp_r)(p, x, X)
+#endif   // #ifndef fftp
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+void fftp_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X) __O3__ ;
+void fftp_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X) __O3__ ;
+void fftp_ci (fft_plan_t *p, complex_i_t *x, complex_f_t *X) __O3__ ;
+void fftp_r (fft_plan_t *p, double *x, complex_d_t *X) __O3__ ;
+void fftp_rf (fft_plan_t *p, float *x, complex_f_t *X) __O3__ ;
+void fftp_ri (fft_plan_t *p, int *x, complex_f_t *X) __O3__ ;
+
+// Inverse FFT using plan
+#if __STDC_VERSION__ >= 201112L
+
+#ifndef ifftp
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void ifftp (fft_plan_t *p, T *X, T *x);
+ *
+ * \brief
+ *    Calculate the inverse FFT for complex and real signals using a
+ *    precomputed plan. The number of points is the plan's size.
+ *    The in-place/not in-place rules and the real signal size warning
+ *    of ifft() apply here too.
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   X     Pointer to size n frequency domain array
+ * \param   x     Pointer to time domain array. size n for complex, size 2*n for real signals
+ * \return        None
+ */
+#define ifftp(p, X, x)     _Generic((x),  \
+       complex_d_t*: ifftp_c,             \
+       complex_f_t*: ifftp_cf,            \
+            double*: ifftp_r,             \
+             float*: ifftp_rf,            \
+            default: ifftp_r)(p, X, x)
+#endif   // #ifndef ifftp
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+void ifftp_c (fft_plan_t *p, complex_d_t *X, complex_d_t *x) __O3__ ;
+void ifftp_cf (fft_plan_t *p, complex_f_t *X, complex_f_t *x) __O3__ ;
+void ifftp_r (fft_plan_t *p, complex_d_t *X, double *x) __O3__ ;
+void ifftp_rf (fft_plan_t *p, complex_f_t *X, float *x) __O3__ ;
+
+// Batched FFT
+#if __STDC_VERSION__ >= 201112L
+
+#ifndef fft_batch
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> uint32_t fft_batch (T *x, T *X, uint32_t n, uint32_t ch, uint32_t stride, uint32_t dist);
+ *
+ * \brief
+ *    Calculate the forward FFT of ch equal length signals in one call,
+ *    sharing one twiddle table. Sample i of channel c is at x[c*dist + i*stride]
+ *    and its spectrum bin i at X[c*dist + i*stride].
+ *    - Contiguous channels.  stride = 1, dist = n
+ *    - Interleaved channels. stride = ch, dist = 1
+ *    Strided channels are gathered FFT_BATCH_CH at a time to a temporary buffer,
+ *    so each input cache line is used by all the channels it holds.
+ *
+ * \note
+ *    The complex transforms can be in-place. The real ones can not.
+ *
+ * \param   x        Pointer to the time domain arrays
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   n        Number of points
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \return           The number of channels on success, 0 on failure
+ */
+#define fft_batch(x, X, n, ch, stride, dist)    _Generic((x),  \
+       complex_d_t*: fft_batch_c,                              \
+       complex_f_t*: fft_batch_cf,                             \
+            double*: fft_batch_r,                              \
+             float*: fft_batch_rf,                             \
+            default: fft_batch_r)(x, X, n, ch, stride, dist)
+#endif   // #ifndef fft_batch
+
+#ifndef fftp_batch
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> uint32_t fftp_batch (fft_plan_t *p, T *x, T *X, uint32_t ch, uint32_t stride, uint32_t dist, void *ws);
+ *
+ * \brief
+ *    Calculate the forward FFT of ch equal length signals using a precomputed
+ *    plan. The number of points is the plan's size. The layout rules of
+ *    fft_batch() apply here too. Strided channels are gathered to the
+ *    workspace ws of fftp_batch_required_size() bytes, which can be NULL
+ *    for stride = 1.
+ */
+#define fftp_batch(p, x, X, ch, stride, dist, ws) _Generic((x), \
+       complex_d_t*: fftp_batch_c,                             \
+       complex_f_t*: fftp_batch_cf,                            \
+            double*: fftp_batch_r,                             \
+             float*: fftp_batch_rf,                            \
+            default: fftp_batch_r)(p, x, X, ch, stride, dist, ws)
+#endif   // #ifndef fftp_batch
+
+#ifndef ifftp_batch
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> uint32_t ifftp_batch (fft_plan_t *p, T *X, T *x, uint32_t ch, uint32_t stride, uint32_t dist, void *ws);
+ *
+ * \brief
+ *    Calculate the inverse complex FFT of ch equal length spectra using a
+ *    precomputed plan. The layout and workspace rules of fftp_batch() apply
+ *    here too.
+ */
+#define ifftp_batch(p, X, x, ch, stride, dist, ws) _Generic((x), \
+       complex_d_t*: ifftp_batch_c,                            \
+       complex_f_t*: ifftp_batch_cf,                           \
+            default: ifftp_batch_c)(p, X, x, ch, stride, dist, ws)
+#endif   // #ifndef ifftp_batch
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+uint32_t fft_batch_c (complex_d_t *x, complex_d_t *X, uint32_t n, uint32_t ch, uint32_t stride, uint32_t dist) __O3__ ;
+uint32_t fft_batch_cf (complex_f_t *x, complex_f_t *X, uint32_t n, uint32_t ch, uint32_t stride, uint32_t dist) __O3__ ;
+uint32_t fft_batch_r (double *x, complex_d_t *X, uint32_t n, uint32_t ch, uint32_t stride, uint32_t dist) __O3__ ;
+uint32_t fft_batch_rf (float *x, complex_f_t *X, uint32_t n, uint32_t ch, uint32_t stride, uint32_t dist) __O3__ ;
+
+size_t fftp_batch_required_size (uint32_t n);
+uint32_t fftp_batch_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) __O3__ ;
+uint32_t fftp_batch_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) __O3__ ;
+uint32_t fftp_batch_r (fft_plan_t *p, double *x, complex_d_t *X, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) __O3__ ;
+uint32_t fftp_batch_rf (fft_plan_t *p, float *x, complex_f_t *X, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) __O3__ ;
+uint32_t ifftp_batch_c (fft_plan_t *p, complex_d_t *X, complex_d_t *x, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) __O3__ ;
+uint32_t ifftp_batch_cf (fft_plan_t *p, complex_f_t *X, complex_f_t *x, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) __O3__ ;
+
+// Split (SoA) complex FFT using plan
+#if __STDC_VERSION__ >= 201112L
+
+#ifndef fftp_split
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename S> uint32_t fftp_split (fft_plan_t *p, S x, S X, void *ws);
+ *
+ * \brief
+ *    Calculate the forward complex FFT of a split (SoA) complex signal, with
+ *    the real and imaginary parts in separate arrays, using a precomputed plan.
+ *    The in-place/not in-place rules of fft() apply here too.
+ *    Power of 2 plans work directly on the split arrays. The other plans
+ *    need a workspace of fftp_split_required_size() bytes.
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     The size n time domain split arrays
+ * \param   X     The size n frequency domain split arrays
+ * \param   ws    Pointer to the workspace, NULL for power of 2 plans
+ * \return        The number of points on success, 0 on failure
+ */
+#define fftp_split(p, x, X, ws)  _Generic((x),  \
+          split_d_t: fftp_split_d,              \
+          split_f_t: fftp_split_f,              \
+            default: fftp_split_d)(p, x, X, ws)
+#endif   // #ifndef fftp_split
+
+#ifndef ifftp_split
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename S> uint32_t ifftp_split (fft_plan_t *p, S X, S x, void *ws);
+ *
+ * \brief
+ *    Calculate the inverse complex FFT of a split (SoA) complex spectrum
+ *    using a precomputed plan.
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   X     The size n frequency domain split arrays
+ * \param   x     The size n time domain split arrays
+ * \param   ws    Pointer to the workspace, NULL for power of 2 plans
+ * \return        The number of points on success, 0 on failure
+ */
+#define ifftp_split(p, X, x, ws) _Generic((x),  \
+          split_d_t: ifftp_split_d,             \
+          split_f_t: ifftp_split_f,             \
+            default: ifftp_split_d)(p, X, x, ws)
+#endif   // #ifndef ifftp_split
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+size_t fftp_split_required_size (uint32_t n);
+uint32_t fftp_split_d (fft_plan_t *p, split_d_t x, split_d_t X, void *ws) __O3__ ;
+uint32_t fftp_split_f (fft_plan_t *p, split_f_t x, split_f_t X, void *ws) __O3__ ;
+uint32_t ifftp_split_d (fft_plan_t *p, split_d_t X, split_d_t x, void *ws) __O3__ ;
+uint32_t ifftp_split_f (fft_plan_t *p, split_f_t X, split_f_t x, void *ws) __O3__ ;
+
+/*
+ * Fixed point FFT using plan
+ *
+ * Block floating point radix-2 transforms for FPU-less targets. The data
+ * are scaled down by 2 before any stage that could overflow, and the total
+ * scaling is returned as a block exponent e, so the true result is the
+ * output times 2^e.
+ */
+uint32_t fft_plan_fixed_init (fft_plan_t *p, uint32_t n);
+size_t fft_plan_fixed_required_size (uint32_t n);
+uint32_t fft_plan_fixed_init_static (fft_plan_t *p, uint32_t n, void *mem, size_t size);
+
+int fftp_q15 (fft_plan_t *p, complex_q15_t *x, complex_q15_t *X) __O3__ ;
+int fftp_q31 (fft_plan_t *p, complex_q31_t *x, complex_q31_t *X) __O3__ ;
+int ifftp_q15 (fft_plan_t *p, complex_q15_t *X, complex_q15_t *x) __O3__ ;
+int ifftp_q31 (fft_plan_t *p, complex_q31_t *X, complex_q31_t *x) __O3__ ;
+
 #ifdef __cplusplus
 }
 #endif
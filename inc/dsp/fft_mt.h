@@ -0,0 +1,108 @@
+/*
+ * \file fft_mt.h
+ * \brief
+ *    Multithreaded four-step FFT for very large transforms on host builds
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2015 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __fft_mt_h__
+#define __fft_mt_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <dsp/fft.h>
+
+#ifdef TBX_THREADS
+#include <pthread.h>
+#include <unistd.h>
+
+/*
+ * User defines
+ */
+#ifndef FFT_MT_MIN_N
+#define  FFT_MT_MIN_N         (1UL<<16)
+   //!< Below this number of points the plan runs the plain single threaded transform
+#endif
+#ifndef FFT_MT_TR_BLK
+#define  FFT_MT_TR_BLK        (32)
+   //!< The tile size of the blocked transposes
+#endif
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * Multithreaded FFT plan.
+ * A n = n1*n2 point transform is calculated as n1 transforms of n2 points
+ * and n2 transforms of n1 points, with blocked transposes in between, so
+ * each sub-transform fits in cache. Every step is split in bands over
+ * a pool of worker threads, owned by the plan.
+ */
+typedef struct {
+   fft_plan_t  p1;      //!< Plan of the n1 point transforms (of all n points for small n)
+   fft_plan_t  p2;      //!< Plan of the n2 point transforms
+   complex_d_t *t;      //!< Pointer to n point scratch array
+   complex_d_t *wh;     //!< Pointer to coarse twiddle table, wh[k] = e^(-j2pik*2^h/n), k:[0..n/2^h)
+   complex_d_t *wl;     //!< Pointer to fine twiddle table, wl[k] = e^(-j2pik/n), k:[0..2^h)
+   uint32_t    n;       //!< The number of points
+   uint32_t    n1;      //!< The length of the second step transforms
+   uint32_t    n2;      //!< The length of the first step transforms
+   uint32_t    h;       //!< log2 of the fine twiddle table size
+
+   // Worker pool
+   pthread_t   *th;     //!< Pointer to the worker threads
+   pthread_mutex_t mx;  //!< Pool lock
+   pthread_cond_t go;   //!< New job signal
+   pthread_cond_t done; //!< Job done signal
+   uint32_t    nt;      //!< The number of threads, including the caller
+   uint32_t    ids;     //!< Worker id counter
+   uint32_t    gen;     //!< Job generation counter
+   uint32_t    busy;    //!< The number of workers still running the current job
+   uint8_t     quit;    //!< Pool termination flag
+
+   // Current job
+   void        *x;      //!< Pointer to the input of the current transform
+   void        *X;      //!< Pointer to the output of the current transform
+   uint8_t     step;    //!< The current step
+   uint8_t     sgl;     //!< Single precision transform flag
+   uint8_t     inv;     //!< Inverse transform flag
+}fft_mt_plan_t;
+
+/*
+ * ========= Public API ============
+ */
+void fft_mt_plan_deinit (fft_mt_plan_t *p);
+uint32_t fft_mt_plan_init (fft_mt_plan_t *p, uint32_t n, uint32_t threads);
+
+void fftp_mt_c (fft_mt_plan_t *p, complex_d_t *x, complex_d_t *X);
+void fftp_mt_cf (fft_mt_plan_t *p, complex_f_t *x, complex_f_t *X);
+void ifftp_mt_c (fft_mt_plan_t *p, complex_d_t *X, complex_d_t *x);
+void ifftp_mt_cf (fft_mt_plan_t *p, complex_f_t *X, complex_f_t *x);
+
+#endif   // #ifdef TBX_THREADS
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // #ifndef __fft_mt_h__
@@ -0,0 +1,91 @@
+/*!
+ * \file filter_cic.h
+ * \brief
+ *    An exact integer CIC (cascaded integrator-comb) filter implementation.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2015 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __filter_cic_h__
+#define __filter_cic_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <dsp/dsp.h>
+#include <sys/arena.h>
+#include <string.h>
+
+/*
+ * User defines
+ */
+#ifndef FILTER_CIC_MAX_STAGES
+#define  FILTER_CIC_MAX_STAGES      (8)
+   //!< The maximum number of integrator-comb stages
+#endif
+
+#ifndef FILTER_CIC_INPUT_BITS
+#define  FILTER_CIC_INPUT_BITS      (32)
+   //!< The significant bits of the input samples. The gain (R*M)^N
+   //!< must fit in the remaining 64 - FILTER_CIC_INPUT_BITS bits.
+#endif
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * CIC filter, or cascaded moving average.
+ * N integrators run at the input rate, followed by a decimation by R and
+ * N combs of differential delay M at the output rate. The response is
+ * N cascaded moving averages of R*M samples, with a DC gain of (R*M)^N.
+ * The registers are 64 bit modulo integers, so the integrators can wrap
+ * and the outputs are still exact, with no drift on any run length.
+ *  - Cascaded moving average     R = 1, M = window length
+ *  - Decimator                   R > 1, M = 1 or 2
+ */
+typedef struct {
+   uint64_t *c;      //!< Pointer to the comb delay lines, M items per stage
+   uint64_t i[FILTER_CIC_MAX_STAGES]; //!< The integrators
+   uint64_t G;       //!< The DC gain, (R*M)^N
+   uint32_t N;       //!< The number of stages
+   uint32_t R;       //!< The decimation factor
+   uint32_t M;       //!< The differential delay
+   uint32_t r;       //!< Inputs since the last output
+   uint32_t ci;      //!< Comb delay line cursor
+   void     *blk;    //!< The owned memory block, NULL for caller supplied memory
+}filter_cic_t;
+
+
+/* =================== Public API ===================== */
+void filter_cic_deinit (filter_cic_t *f);
+uint32_t filter_cic_init (filter_cic_t *f, uint32_t N, uint32_t R, uint32_t M);
+size_t filter_cic_required_size (uint32_t N, uint32_t M);
+uint32_t filter_cic_init_static (filter_cic_t *f, uint32_t N, uint32_t R, uint32_t M, void *mem, size_t size);
+void filter_cic_reset (filter_cic_t *f);
+uint32_t filter_cic_outputs (filter_cic_t *f, uint32_t n);
+
+uint32_t filter_cic (filter_cic_t *f, const int32_t *in, uint32_t n, int64_t *out) __O3__ ;
+uint32_t filter_cic_d (filter_cic_t *f, const int32_t *in, uint32_t n, double *out) __O3__ ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // #ifndef __filter_cic_h__
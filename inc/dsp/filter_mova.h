@@ -30,8 +30,17 @@ extern "C" {
 #endif
 
 #include <dsp/dsp.h>
+#include <sys/arena.h>
 #include <string.h>
 
+/*
+ * User defines
+ */
+#ifndef FILTER_MOVA_BANK_BLK
+#define  FILTER_MOVA_BANK_BLK    (16)
+   //!< The channels filter_mova_bank() updates in lock-step
+#endif
+
 /*
  * General defines
  */
@@ -50,6 +59,7 @@ typedef struct
    byte_t   last[FILTER_MOVA_LAST_SIZE];  //!< Allocated space for the last output
    uint32_t N;       //!< The number of samples / cut-off frequency
    uint32_t c;       //!< Buffer cursor
+   void     *blk;    //!< The owned memory block, NULL for caller supplied memory
 }filter_mova_t;
 
 
@@ -69,6 +79,8 @@ void filter_mova_set_fc (filter_mova_t *f, double fc);
  */
 void filter_mova_deinit (filter_mova_t* f);
 uint32_t filter_mova_init (filter_mova_t* f);
+size_t filter_mova_required_size (filter_mova_t* f);
+uint32_t filter_mova_init_static (filter_mova_t* f, void *mem, size_t size);
 
 double filter_mova_d (filter_mova_t* f, double in) __O3__ ;
 float filter_mova_f (filter_mova_t* f, float in) __O3__ ;
@@ -77,6 +89,20 @@ complex_d_t filter_mova_cd (filter_mova_t* f, complex_d_t in) __O3__ ;
 complex_f_t filter_mova_cf (filter_mova_t* f, complex_f_t in) __O3__ ;
 complex_f_t filter_mova_ci (filter_mova_t* f, complex_i_t in) __O3__ ;
 
+void filter_mova_block_d (filter_mova_t* f, double *in, double *out, uint32_t n) __O3__ ;
+void filter_mova_block_f (filter_mova_t* f, float *in, float *out, uint32_t n) __O3__ ;
+void filter_mova_block_i (filter_mova_t* f, int *in, float *out, uint32_t n) __O3__ ;
+void filter_mova_block_cd (filter_mova_t* f, complex_d_t *in, complex_d_t *out, uint32_t n) __O3__ ;
+void filter_mova_block_cf (filter_mova_t* f, complex_f_t *in, complex_f_t *out, uint32_t n) __O3__ ;
+void filter_mova_block_ci (filter_mova_t* f, complex_i_t *in, complex_f_t *out, uint32_t n) __O3__ ;
+
+void filter_mova_bank_d (filter_mova_t* f, uint32_t ch, double *in, double *out, uint32_t n) __O3__ ;
+void filter_mova_bank_f (filter_mova_t* f, uint32_t ch, float *in, float *out, uint32_t n) __O3__ ;
+void filter_mova_bank_i (filter_mova_t* f, uint32_t ch, int *in, float *out, uint32_t n) __O3__ ;
+void filter_mova_bank_cd (filter_mova_t* f, uint32_t ch, complex_d_t *in, complex_d_t *out, uint32_t n) __O3__ ;
+void filter_mova_bank_cf (filter_mova_t* f, uint32_t ch, complex_f_t *in, complex_f_t *out, uint32_t n) __O3__ ;
+void filter_mova_bank_ci (filter_mova_t* f, uint32_t ch, complex_i_t *in, complex_f_t *out, uint32_t n) __O3__ ;
+
 #if __STDC_VERSION__ >= 201112L
 #ifndef filter_mova
 /*!
@@ -103,6 +129,59 @@ complex_f_t filter_mova_ci (filter_mova_t* f, complex_i_t in) __O3__ ;
                    int: filter_mova_i,          \
                 default: filter_mova_d)(f, in)
 #endif   // #ifndef filter_mova
+
+#ifndef filter_mova_block
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T1, typename T2> void filter_mova_block (filter_mova_t *f, T1 *in, T2 *out, uint32_t n);
+ *
+ * \brief
+ *    Recursive Moving Average filter of a block.
+ *    Output = Moving_Average (Input)
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block
+ * \param  n      The block size
+ */
+#define filter_mova_block(f, in, out, n)    _Generic((in),    \
+           complex_d_t*: filter_mova_block_cd,         \
+           complex_f_t*: filter_mova_block_cf,         \
+           complex_i_t*: filter_mova_block_ci,         \
+                double*: filter_mova_block_d,          \
+                 float*: filter_mova_block_f,          \
+                   int*: filter_mova_block_i,          \
+                default: filter_mova_block_d)(f, in, out, n)
+#endif   // #ifndef filter_mova_block
+
+#ifndef filter_mova_bank
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T1, typename T2> void filter_mova_bank (filter_mova_t *f, uint32_t ch, T1 *in, T2 *out, uint32_t n);
+ *
+ * \brief
+ *    Recursive Moving Average filter bank of ch interleaved channels.
+ *    Output = Moving_Average (Input), for each channel
+ *
+ * \param  f      Pointer to an array of ch filters
+ * \param  ch     The number of channels
+ * \param  in     Pointer to the input frames
+ * \param  out    Pointer to the output frames
+ * \param  n      The number of frames
+ */
+#define filter_mova_bank(f, ch, in, out, n)    _Generic((in),    \
+           complex_d_t*: filter_mova_bank_cd,          \
+           complex_f_t*: filter_mova_bank_cf,          \
+           complex_i_t*: filter_mova_bank_ci,          \
+                double*: filter_mova_bank_d,          \
+                 float*: filter_mova_bank_f,          \
+                   int*: filter_mova_bank_i,          \
+                default: filter_mova_bank_d)(f, ch, in, out, n)
+#endif   // #ifndef filter_mova_bank
 #endif   // #if __STDC_VERSION__ >= 201112L
 
 #ifdef __cplusplus
@@ -39,6 +39,14 @@ extern "C" {
  * User defines
  */
 #define  FIR_WSINC_MIN_TAPS       (5)
+#ifndef FIR_WSINC_CACHE_SIZE
+#define  FIR_WSINC_CACHE_SIZE     (16)
+   //!< The number of designed kernels kept for reuse by fir_wsinc_init()
+#endif
+#ifndef FIR_WSINC_CONV_BLK
+#define  FIR_WSINC_CONV_BLK       (256)
+   //!< The stack buffer samples of a block call in the other filter precision
+#endif
 
 /*
  * General defines
@@ -69,6 +77,12 @@ typedef enum {
    FIR_WSINC_HANNING
 }fir_wtype_en;
 
+typedef enum {
+   FIR_WSINC_DOUBLE = 0,      // Default choice
+   FIR_WSINC_FLOAT,           // Single precision kernel, scratch and streaming
+   FIR_WSINC_Q15              // Q15 kernel spectrum and block filter
+}fir_wsinc_prec_en;
+
 
 
 typedef struct {
@@ -79,18 +93,50 @@ typedef struct {
    uint32_t casc;          //!< Number of cascade filters to implement
    double tb;              //!< transition bandwith
    double fc1, fc2;        //!< The transition frequencies
+   fir_wtype_en wtype;     //!< The window type
+   fir_wsinc_prec_en prec; //!< The kernel storage and processing precision
 
    /*
     * Inner filter data
     */
-   double         *k;   //!< Pointer to filter kernel
-   double         *t;   //!< Pointer to temporary array
+   void           *k;   //!< Pointer to the kernel spectrum, N complex points of the
+                        //!< precision's type. Read-only as it can be shared
+   void           *t;   //!< Pointer to temporary array, 2N reals (N complex for Q15)
+   int            ke;   //!< The block exponent of a Q15 kernel spectrum
+   fft_plan_t     p;    //!< The fixed point plan of a Q15 filter
+   double         *h;   //!< Pointer to the cascaded time domain kernel, T taps
+   void           *kc;  //!< Pointer to the kernel cache entry, NULL for a private kernel
+   void           *d;   //!< Pointer to the per-sample delay line, 2T complex items
+   uint32_t       di;   //!< Delay line cursor, the newest sample
+   conv_stream_t  s;    //!< The overlap-save state of the block streaming
+   void           *blk; //!< The owned memory block, NULL for caller supplied memory
    uint32_t       T;    //!< The number of taps after cascade the filters in time domain
    uint32_t       N;    //!< The number of kernel points in frequncy complex domain
    window_pt      W;    //!< Pointer to window function
    wsinc_taps_pt  tp;   //!< Pointer to number of taps calculation function
 }fir_wsinc_t;
 
+/*!
+ * Polyphase windowed sinc filter for sample rate conversion by L/M.
+ * The low pass kernel of the L times upsampled signal is split to L phases
+ * of P taps, so each output is computed from the input samples directly,
+ * without the zero stuffed samples and without the discarded outputs.
+ *  - Decimator       L = 1
+ *  - Interpolator    M = 1
+ *  - Resampler       Any L/M
+ */
+typedef struct {
+   double         *h;   //!< Pointer to the polyphase kernel, h[p*P + j] = kernel[p + j*L]
+   double         *d;   //!< Pointer to the input delay line, 2P items
+   uint32_t       di;   //!< Delay line cursor, the newest sample
+   uint32_t       o;    //!< Offset of the next output from the next input, in 1/L input samples
+   uint32_t       L;    //!< The interpolation factor
+   uint32_t       M;    //!< The decimation factor
+   uint32_t       P;    //!< The number of taps per phase
+   uint32_t       T;    //!< The number of taps of the kernel
+   void           *blk; //!< The owned memory block, NULL for caller supplied memory
+}fir_poly_t;
+
 
 /* =================== Public API ===================== */
 /*
@@ -105,12 +151,15 @@ void fir_wsinc_set_wtype (fir_wsinc_t *f, fir_wtype_en t);
 void fir_wsinc_set_fc (fir_wsinc_t *f, double fc1, double fc2);
 void fir_wsinc_set_tb (fir_wsinc_t *f, double tb);
 void fir_wsic_set_cascade (fir_wsinc_t *f, uint32_t c);
+void fir_wsinc_set_prec (fir_wsinc_t *f, fir_wsinc_prec_en p);
 
 /*
  * User Functions
  */
 void fir_wsinc_deinit (fir_wsinc_t* f);
 uint32_t fir_wsinc_init (fir_wsinc_t* f);
+size_t fir_wsinc_required_size (fir_wsinc_t* f);
+uint32_t fir_wsinc_init_static (fir_wsinc_t* f, void *mem, size_t size);
 
 double fir_wsinc_d (fir_wsinc_t* f, double in) __O3__ ;
 float fir_wsinc_f (fir_wsinc_t* f, float in) __O3__ ;
@@ -119,34 +168,81 @@ complex_d_t fir_wsinc_cd (fir_wsinc_t* f, complex_d_t in) __O3__ ;
 complex_f_t fir_wsinc_cf (fir_wsinc_t* f, complex_f_t in) __O3__ ;
 complex_f_t fir_wsinc_ci (fir_wsinc_t* f, complex_i_t in) __O3__ ;
 
+void fir_wsinc_reset (fir_wsinc_t* f);
+void fir_wsinc_cache_clear (void);
+uint32_t fir_wsinc_save (fir_wsinc_t *f, void *buf, uint32_t size);
+uint32_t fir_wsinc_load (fir_wsinc_t *f, const void *buf, uint32_t size);
+void fir_wsinc_block_d (fir_wsinc_t *f, double *in, double *out, uint32_t n) __O3__ ;
+void fir_wsinc_block_f (fir_wsinc_t *f, float *in, float *out, uint32_t n) __O3__ ;
+
 void fir_wsinc (fir_wsinc_t *f, double *in, double *out, uint32_t n);
+void fir_wsinc_rf (fir_wsinc_t *f, float *in, float *out, uint32_t n) __O3__ ;
+void fir_wsinc_q15 (fir_wsinc_t *f, int16_t *in, int16_t *out, uint32_t n) __O3__ ;
+
+/*
+ * Polyphase decimator, interpolator and resampler
+ */
+#define  fir_decim_init(f, M, w, tb)     fir_poly_init (f, 1, M, w, tb)
+#define  fir_interp_init(f, L, w, tb)    fir_poly_init (f, L, 1, w, tb)
+
+void fir_poly_deinit (fir_poly_t *f);
+uint32_t fir_poly_init (fir_poly_t *f, uint32_t L, uint32_t M, fir_wtype_en w, double tb);
+size_t fir_poly_required_size (uint32_t L, uint32_t M, fir_wtype_en w, double tb);
+uint32_t fir_poly_init_static (fir_poly_t *f, uint32_t L, uint32_t M, fir_wtype_en w, double tb, void *mem, size_t size);
+void fir_poly_reset (fir_poly_t *f);
+uint32_t fir_poly_outputs (fir_poly_t *f, uint32_t n);
+uint32_t fir_poly_d (fir_poly_t *f, double *in, uint32_t n, double *out) __O3__ ;
 
 #if __STDC_VERSION__ >= 201112L
-#ifndef fir_mova
+#ifndef fir_wsinc_sample
 /*!
  * A pseudo type-polymorphism mechanism using _Generic macro
  * to simulate:
  *
- * template<typename T1, typename T2> T2 filter_mova (filter_mova_t *f, T1 in);
+ * template<typename T1, typename T2> T2 fir_wsinc_sample (fir_wsinc_t *f, T1 in);
  *
  * \brief
- *    Recursive Moving Average filter.
- *    Output = Moving_Average (Input)
+ *    Streaming windowed sinc filter, one sample per call.
+ *    Output = Kernel * Input, using a direct form delay line.
  *
  * \param  f      Which filter to use
  * \param  in     The input value.
  *
  * \return        Filtered value
  */
-#define fir_mova(f, in)    _Generic((in),    \
-           complex_d_t: fir_mova_cd,         \
-           complex_f_t: fir_mova_cf,         \
-           complex_i_t: fir_mova_ci,         \
-                double: fir_mova_d,          \
-                 float: fir_mova_f,          \
-                   int: fir_mova_i,          \
-                default: fir_mova_d)(f, in)
-#endif   // #ifndef fir_mova
+#define fir_wsinc_sample(f, in)    _Generic((in),    \
+           complex_d_t: fir_wsinc_cd,         \
+           complex_f_t: fir_wsinc_cf,         \
+           complex_i_t: fir_wsinc_ci,         \
+                double: fir_wsinc_d,          \
+                 float: fir_wsinc_f,          \
+                   int: fir_wsinc_i,          \
+                default: fir_wsinc_d)(f, in)
+#endif   // #ifndef fir_wsinc_sample
+
+#ifndef fir_wsinc_block
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void fir_wsinc_block (fir_wsinc_t *f, T *in, T *out, uint32_t n);
+ *
+ * \brief
+ *    Streaming windowed sinc filter on blocks of any size. Each call
+ *    outputs exactly n samples, using the overlap-save history of the
+ *    previous calls.
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block, size n. It can be the same as in.
+ * \param  n      The block size
+ *
+ * \return        None
+ */
+#define fir_wsinc_block(f, in, out, n)    _Generic((in),    \
+               double*: fir_wsinc_block_d,    \
+                float*: fir_wsinc_block_f)(f, in, out, n)
+#endif   // #ifndef fir_wsinc_block
 #endif   // #if __STDC_VERSION__ >= 201112L
 
 #ifdef __cplusplus
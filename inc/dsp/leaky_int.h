@@ -31,6 +31,13 @@ extern "C" {
 
 #include <dsp/dsp.h>
 
+/*
+ * User defines
+ */
+#ifndef LEAKY_INT_BANK_BLK
+#define  LEAKY_INT_BANK_BLK      (16)
+   //!< The channels leaky_int_bank() updates in lock-step
+#endif
 
 /* =================== Data types ===================== */
 
@@ -46,6 +53,8 @@ typedef volatile struct
 void leaky_int_deinit (leaky_int_t* li);
 void leaky_int_init (leaky_int_t* li, double l);
 double leaky_int (leaky_int_t* li, double value) __O3__ ;
+void leaky_int_block (leaky_int_t* li, double *in, double *out, uint32_t n) __O3__ ;
+void leaky_int_bank (leaky_int_t* li, uint32_t ch, double *in, double *out, uint32_t n) __O3__ ;
 
 #ifdef __cplusplus
 }
@@ -31,6 +31,14 @@ extern "C" {
 
 #include <dsp/dsp.h>
 
+/*
+ * User defines
+ */
+#ifndef VEC_PW_BLK
+#define  VEC_PW_BLK     (256)
+   //!< Block size of the pairwise summation in vdot_pw(), vnorm_pw()
+#endif
+
 /*
  * ================== Public API ====================
  */
@@ -193,6 +201,192 @@ int vediv_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) __O3__
 #endif   // #if __STDC_VERSION__ >= 201112L
 
 
+void vaxpy_i (int *y, int a, int *x, int length) __O3__ ;
+void vaxpy_f (float *y, float a, float *x, int length) __O3__ ;
+void vaxpy_d (double *y, double a, double *x, int length) __O3__ ;
+void vaxpy_ci (complex_i_t *y, complex_i_t a, complex_i_t *x, int length) __O3__ ;
+void vaxpy_cf (complex_f_t *y, complex_f_t a, complex_f_t *x, int length) __O3__ ;
+void vaxpy_cd (complex_d_t *y, complex_d_t a, complex_d_t *x, int length) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+#ifndef vaxpy
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void vaxpy (T *y, T a, T *x, int length);
+ *
+ * \brief
+ *    Adds a scaled vector to y, in place
+ *
+ *   y[n] += a * x[n]
+ *
+ * \param      y  Pointer to input/output vector
+ * \param      a  The scale factor
+ * \param      x  Pointer to vector x
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define vaxpy(y, a, x, length) _Generic((y), \
+               int*: vaxpy_i,                \
+             float*: vaxpy_f,                \
+            double*: vaxpy_d,                \
+       complex_i_t*: vaxpy_ci,               \
+       complex_f_t*: vaxpy_cf,               \
+       complex_d_t*: vaxpy_cd,               \
+            default: vaxpy_d)(y, a, x, length)
+#endif   // #ifndef vaxpy
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+
+void vscale_i (int *y, int *x, int a, int b, int length) __O3__ ;
+void vscale_f (float *y, float *x, float a, float b, int length) __O3__ ;
+void vscale_d (double *y, double *x, double a, double b, int length) __O3__ ;
+void vscale_ci (complex_i_t *y, complex_i_t *x, complex_i_t a, complex_i_t b, int length) __O3__ ;
+void vscale_cf (complex_f_t *y, complex_f_t *x, complex_f_t a, complex_f_t b, int length) __O3__ ;
+void vscale_cd (complex_d_t *y, complex_d_t *x, complex_d_t a, complex_d_t b, int length) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+#ifndef vscale
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void vscale (T *y, T *x, T a, T b, int length);
+ *
+ * \brief
+ *    Scales and offsets a vector in one pass
+ *
+ *   y[n] = a * x[n] + b
+ *
+ * \param      y  Pointer to output vector, can be the same as x
+ * \param      x  Pointer to vector x
+ * \param      a  The scale factor
+ * \param      b  The offset
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define vscale(y, x, a, b, length) _Generic((y), \
+               int*: vscale_i,               \
+             float*: vscale_f,               \
+            double*: vscale_d,               \
+       complex_i_t*: vscale_ci,              \
+       complex_f_t*: vscale_cf,              \
+       complex_d_t*: vscale_cd,              \
+            default: vscale_d)(y, x, a, b, length)
+#endif   // #ifndef vscale
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+
+void vmac_i (int *y, int *a, int *b, int length) __O3__ ;
+void vmac_f (float *y, float *a, float *b, int length) __O3__ ;
+void vmac_d (double *y, double *a, double *b, int length) __O3__ ;
+void vmac_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) __O3__ ;
+void vmac_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) __O3__ ;
+void vmac_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+#ifndef vmac
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void vmac (T *y, T *a, T *b, int length);
+ *
+ * \brief
+ *    Element-wise multiply-accumulate
+ *
+ *   y[n] += a[n] .* b[n]
+ *
+ * \param      y  Pointer to input/output vector
+ * \param      a  Pointer to vector a
+ * \param      b  Pointer to vector b
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define vmac(y, a, b, length) _Generic((y),  \
+               int*: vmac_i,                 \
+             float*: vmac_f,                 \
+            double*: vmac_d,                 \
+       complex_i_t*: vmac_ci,                \
+       complex_f_t*: vmac_cf,                \
+       complex_d_t*: vmac_cd,                \
+            default: vmac_d)(y, a, b, length)
+#endif   // #ifndef vmac
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+
+void vcmac_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) __O3__ ;
+void vcmac_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) __O3__ ;
+void vcmac_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+#ifndef vcmac
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void vcmac (T *y, T *a, T *b, int length);
+ *
+ * \brief
+ *    Element-wise complex conjugate multiply-accumulate, as in
+ *    cross-spectrum averaging
+ *
+ *   y[n] += a'[n] .* b[n]
+ *
+ * \param      y  Pointer to input/output vector
+ * \param      a  Pointer to vector a, used conjugated
+ * \param      b  Pointer to vector b
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define vcmac(y, a, b, length) _Generic((y), \
+       complex_i_t*: vcmac_ci,               \
+       complex_f_t*: vcmac_cf,               \
+       complex_d_t*: vcmac_cd,               \
+            default: vcmac_cd)(y, a, b, length)
+#endif   // #ifndef vcmac
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+
+void vclamp_i (int *y, int *x, int lo, int hi, int length) __O3__ ;
+void vclamp_f (float *y, float *x, float lo, float hi, int length) __O3__ ;
+void vclamp_d (double *y, double *x, double lo, double hi, int length) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+#ifndef vclamp
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void vclamp (T *y, T *x, T lo, T hi, int length);
+ *
+ * \brief
+ *    Limits a vector to [lo, hi]
+ *
+ *   y[n] = min (max (x[n], lo), hi)
+ *
+ * \param      y  Pointer to output vector, can be the same as x
+ * \param      x  Pointer to vector x
+ * \param     lo  The lower limit
+ * \param     hi  The upper limit
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define vclamp(y, x, lo, hi, length) _Generic((y), \
+               int*: vclamp_i,               \
+             float*: vclamp_f,               \
+            double*: vclamp_d,               \
+            default: vclamp_d)(y, x, lo, hi, length)
+#endif   // #ifndef vclamp
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+
 int vdot_i (int *a, int *b, int length) __O3__ ;
 float vdot_f (float *a, float *b, int length) __O3__ ;
 double vdot_d (double *a, double *b, int length) __O3__ ;
@@ -233,6 +427,39 @@ complex_d_t vdot_cd (complex_d_t *a, complex_d_t *b, int length) __O3__ ;
 #endif   // #if __STDC_VERSION__ >= 201112L
 
 
+float vdot_pw_f (float *a, float *b, int length) __O3__ ;
+double vdot_pw_d (double *a, double *b, int length) __O3__ ;
+complex_f_t vdot_pw_cf (complex_f_t *a, complex_f_t *b, int length) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+#ifndef vdot_pw
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> T vdot_pw (T *a, T *b, int length);
+ *
+ * \brief
+ *    Calculates the dot product of a and b, as vdot(), with pairwise
+ *    summation of VEC_PW_BLK item blocks. Slower than vdot(), but the
+ *    rounding error grows with log2(length) instead of length, so
+ *    float keeps its accuracy on long vectors.
+ *
+ * \param      a  Pointer to target vector a
+ * \param      b  Pointer to target vector b
+ * \param length  Size of vectors
+ *
+ * \return The dot product of a and b
+ */
+#define vdot_pw(a, b, length) _Generic((a), \
+             float*: vdot_pw_f,             \
+            double*: vdot_pw_d,             \
+       complex_f_t*: vdot_pw_cf,            \
+            default: vdot_pw_d)(a, b, length)
+#endif   // #ifndef vdot_pw
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+
 float vnorm_i (int *x, int length) __O3__ ;
 float vnorm_f (float *x, int length) __O3__ ;
 double vnorm_d (double *x, int length) __O3__ ;
@@ -273,6 +500,147 @@ complex_d_t vnorm_cd (complex_d_t *x, int length) __O3__ ;
 #endif   // #if __STDC_VERSION__ >= 201112L
 
 
+float vnorm_pw_f (float *x, int length) __O3__ ;
+double vnorm_pw_d (double *x, int length) __O3__ ;
+complex_f_t vnorm_pw_cf (complex_f_t *x, int length) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+#ifndef vnorm_pw
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T, typename TT> TT vnorm_pw (T *x, int length);
+ *
+ * \brief
+ *    Calculates the norm (length) of a vector, as vnorm(), with the
+ *    pairwise summation of vdot_pw()
+ *
+ * \param      x  Pointer to target vector a
+ * \param length  Size of vector
+ *
+ * \return The norm of vector
+ */
+#define vnorm_pw(x, length) _Generic((x), \
+             float*: vnorm_pw_f,          \
+            double*: vnorm_pw_d,          \
+       complex_f_t*: vnorm_pw_cf,         \
+            default: vnorm_pw_d)(x, length)
+#endif   // #ifndef vnorm_pw
+
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+
+/*
+ * Split (SoA) complex layout
+ */
+void vsplit_cf (split_f_t y, complex_f_t *x, int length) __O3__ ;
+void vsplit_cd (split_d_t y, complex_d_t *x, int length) __O3__ ;
+void vmerge_cf (complex_f_t *y, split_f_t x, int length) __O3__ ;
+void vmerge_cd (complex_d_t *y, split_d_t x, int length) __O3__ ;
+void vemul_sf (split_f_t y, split_f_t a, split_f_t b, int length) __O3__ ;
+void vemul_sd (split_d_t y, split_d_t a, split_d_t b, int length) __O3__ ;
+complex_f_t vdot_sf (split_f_t a, split_f_t b, int length) __O3__ ;
+complex_d_t vdot_sd (split_d_t a, split_d_t b, int length) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+#ifndef vsplit
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename S, typename T> void vsplit (S y, T *x, int length);
+ *
+ * \brief
+ *    Converts an interleaved complex vector to split (SoA) layout
+ *
+ * \param      y  The split output buffers
+ * \param      x  Pointer to the interleaved complex vector
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define vsplit(y, x, length) _Generic((x),   \
+       complex_f_t*: vsplit_cf,              \
+       complex_d_t*: vsplit_cd,              \
+            default: vsplit_cd)(y, x, length)
+#endif   // #ifndef vsplit
+
+#ifndef vmerge
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T, typename S> void vmerge (T *y, S x, int length);
+ *
+ * \brief
+ *    Converts a split (SoA) complex vector to interleaved layout
+ *
+ * \param      y  Pointer to the interleaved complex output vector
+ * \param      x  The split input buffers
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define vmerge(y, x, length) _Generic((y),   \
+       complex_f_t*: vmerge_cf,              \
+       complex_d_t*: vmerge_cd,              \
+            default: vmerge_cd)(y, x, length)
+#endif   // #ifndef vmerge
+
+#ifndef vemul_split
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename S> void vemul_split (S y, S a, S b, int length);
+ *
+ * \brief
+ *    Calculates the element-wise multiplication of split complex a and b
+ *
+ *   y[n] = a[n] .* b[n]
+ *
+ * \param      y  The split output buffers, can be the same as a or b
+ * \param      a  The split buffers of vector a
+ * \param      b  The split buffers of vector b
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define vemul_split(y, a, b, length) _Generic((y), \
+          split_f_t: vemul_sf,               \
+          split_d_t: vemul_sd,               \
+            default: vemul_sd)(y, a, b, length)
+#endif   // #ifndef vemul_split
+
+#ifndef vdot_split
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename S, typename T> T vdot_split (S a, S b, int length);
+ *
+ * \brief
+ *    Calculates the dot product of split complex a and b
+ *
+ *                     N-1
+ *   r = <a[n],b[n]> = Sum {a'[m]*b[n]}
+ *                     n=0
+ *
+ * \param      a  The split buffers of vector a
+ * \param      b  The split buffers of vector b
+ * \param length  Size of vectors
+ *
+ * \return The dot product of a and b
+ */
+#define vdot_split(a, b, length) _Generic((a), \
+          split_f_t: vdot_sf,                \
+          split_d_t: vdot_sd,                \
+            default: vdot_sd)(a, b, length)
+#endif   // #ifndef vdot_split
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+
 void vcart_i (float *c, int *p) __O3__ ;
 void vcart_f (float *c, float *p) __O3__ ;
 void vcart_d (double *c, double *p) __O3__ ;
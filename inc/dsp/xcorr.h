@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 #include <dsp/dsp.h>
+#include <dsp/conv.h>
 
 /*
  * ================== Public API ====================
@@ -41,6 +42,23 @@ void xcorr_ci (complex_i_t *y, complex_i_t *t, int32_t st, complex_i_t *x, int32
 void xcorr_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx) __O3__ ;
 void xcorr_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx) __O3__ ;
 
+void xcorr_lag_i (int *y, int *t, int32_t st, int *x, int32_t sx, int32_t maxlag) __O3__ ;
+void xcorr_lag_f (float *y, float *t, int32_t st, float *x, int32_t sx, int32_t maxlag) __O3__ ;
+void xcorr_lag_d (double *y, double *t, int32_t st, double *x, int32_t sx, int32_t maxlag) __O3__ ;
+void xcorr_lag_ci (complex_i_t *y, complex_i_t *t, int32_t st, complex_i_t *x, int32_t sx, int32_t maxlag) __O3__ ;
+void xcorr_lag_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx, int32_t maxlag) __O3__ ;
+void xcorr_lag_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx, int32_t maxlag) __O3__ ;
+
+void xcorr_fft_f (float *y, float *t, int32_t st, float *x, int32_t sx) __O3__ ;
+void xcorr_fft_d (double *y, double *t, int32_t st, double *x, int32_t sx) __O3__ ;
+void xcorr_fft_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx) __O3__ ;
+void xcorr_fft_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx) __O3__ ;
+
+int xcorr_norm_f (float *y, float *t, int32_t st, float *x, int32_t sx) __O3__ ;
+int xcorr_norm_d (double *y, double *t, int32_t st, double *x, int32_t sx) __O3__ ;
+int xcorr_norm_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx) __O3__ ;
+int xcorr_norm_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx) __O3__ ;
+
 
 #if __STDC_VERSION__ >= 201112L
 
@@ -69,7 +87,9 @@ void xcorr_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32
  *
  * \return none
  *
- * \note We still have to implement all the functions
+ * \note
+ *    The floating point versions run as a conv() of the reversed target,
+ *    so they use its blocked direct kernel or its FFT path.
  */
 #define xcorr(y, t, st, x, sx) _Generic((y),  int*: xcorr_i,   \
                                             float*: xcorr_f,   \
@@ -79,6 +99,100 @@ void xcorr_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32
                                       complex_d_t*: xcorr_cd,  \
                                            default: xcorr_d)(y, t, st, x, sx)
 #endif   // #ifndef xcorr
+
+#ifndef xcorr_lag
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void xcorr_lag (T *y, T *t, int st, T *x, int sx, int maxlag);
+ *
+ * \brief
+ *    Calculates only the lags [-maxlag .. maxlag] around zero lag of the
+ *    cross-correlation of t and x, in O((sx+st)*maxlag) instead of O(sx*st).
+ *    y[j] is the xcorr() output y[sx-1-maxlag+j]. Lags that fall outside
+ *    the full correlation are zeroed.
+ *
+ * \param   y  Pointer to output vector, size 2*maxlag+1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ * \param  maxlag  The maximum lag to calculate
+ *
+ * \return none
+ */
+#define xcorr_lag(y, t, st, x, sx, maxlag) _Generic((y), \
+                                                 int*: xcorr_lag_i,   \
+                                               float*: xcorr_lag_f,   \
+                                              double*: xcorr_lag_d,   \
+                                         complex_i_t*: xcorr_lag_ci,  \
+                                         complex_f_t*: xcorr_lag_cf,  \
+                                         complex_d_t*: xcorr_lag_cd,  \
+                                              default: xcorr_lag_d)(y, t, st, x, sx, maxlag)
+#endif   // #ifndef xcorr_lag
+
+#ifndef xcorr_fft
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void xcorr_fft (T *y, T *t, int st, T *x, int sx);
+ *
+ * \brief
+ *    Calculates the full cross-correlation of t and x using the FFT
+ *    convolution of conv_fft(). The output layout is the same as xcorr().
+ *
+ * \param   y  Pointer to output vector, size st+sx-1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+#define xcorr_fft(y, t, st, x, sx) _Generic((y), \
+                                            float*: xcorr_fft_f,   \
+                                           double*: xcorr_fft_d,   \
+                                      complex_f_t*: xcorr_fft_cf,  \
+                                      complex_d_t*: xcorr_fft_cd,  \
+                                           default: xcorr_fft_d)(y, t, st, x, sx)
+#endif   // #ifndef xcorr_fft
+
+#ifndef xcorr_norm
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> int xcorr_norm (T *y, T *t, int st, T *x, int sx);
+ *
+ * \brief
+ *    Normalized cross-correlation for template matching. For every
+ *    position n where t fits completely inside x:
+ *
+ *                 st-1
+ *           y[n] = Sum {t[k]*x'[n+k]} / (||t|| * ||x[n .. n+st-1]||)
+ *                  k=0
+ *    n: [0 .. sx-st]
+ *
+ *    The window energy of x slides along the signal. The correlation uses
+ *    xcorr(), so long signals take the FFT path.
+ *
+ * \param   y  Pointer to output vector, size sx-st+1
+ * \param   t  Pointer to the template
+ * \param  st  Size of the template
+ * \param   x  Pointer to input signal
+ * \param  sx  Size of input signal
+ *
+ * \return  The number of outputs (sx-st+1), or 0 on failure (st > sx or no memory)
+ */
+#define xcorr_norm(y, t, st, x, sx) _Generic((y), \
+                                             float*: xcorr_norm_f,   \
+                                            double*: xcorr_norm_d,   \
+                                       complex_f_t*: xcorr_norm_cf,  \
+                                       complex_d_t*: xcorr_norm_cd,  \
+                                            default: xcorr_norm_d)(y, t, st, x, sx)
+#endif   // #ifndef xcorr_norm
 #endif   // #if __STDC_VERSION__ >= 201112L
 
 #ifdef __cplusplus
@@ -0,0 +1,83 @@
+/*
+ * \file arena.h
+ * \brief
+ *    A bump (arena) memory allocator
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2015 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __arena_h__
+#define __arena_h__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+
+/*
+ * User defines
+ */
+#ifndef ARENA_ALIGN
+#define  ARENA_ALIGN       (16)
+   //!< The alignment of each allocation. Must be a power of 2
+#endif
+
+/*
+ * General defines
+ */
+#define  ARENA_SIZE(_sz)   ( ((size_t)(_sz) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1) )
+   //!< The space an allocation of _sz bytes takes from an arena
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * Arena allocator.
+ * Allocations are taken in order from a caller supplied memory block, so
+ * a chain of objects can be laid out contiguously with no heap. Nothing is
+ * freed one by one. The whole arena, or everything after a mark, is
+ * released at once.
+ */
+typedef struct {
+   byte_t   *mem;    //!< Pointer to the memory block
+   size_t   size;    //!< The size of the block
+   size_t   used;    //!< The allocated bytes
+}arena_t;
+
+/*
+ * ================== Public API ====================
+ */
+void arena_init (arena_t *a, void *mem, size_t size);
+void* arena_alloc (arena_t *a, size_t size);
+void* arena_calloc (arena_t *a, size_t size);
+size_t arena_mark (arena_t *a);
+void arena_release (arena_t *a, size_t mark);
+void arena_reset (arena_t *a);
+size_t arena_avail (arena_t *a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // #ifndef __arena_h__
@@ -88,8 +88,24 @@ typedef double _Complex    complex_d_t;
 typedef float _Complex     complex_f_t;
 #ifdef __GNUC__
 typedef int _Complex       complex_i_t;
+typedef short _Complex     complex_q15_t;    /*!< Q15 fixed point complex */
+typedef int _Complex       complex_q31_t;    /*!< Q31 fixed point complex, for 32 bit int */
 #endif
 
+/*!
+ * Split (SoA) complex buffers. The real and the imaginary parts
+ * are in two separate arrays of the same size.
+ */
+typedef struct {
+   double   *re;     //!< Pointer to the real parts
+   double   *im;     //!< Pointer to the imaginary parts
+}split_d_t;
+
+typedef struct {
+   float    *re;     //!< Pointer to the real parts
+   float    *im;     //!< Pointer to the imaginary parts
+}split_f_t;
+
 #define  real(_z)       (((double*)&(_z))[0])
 #define  imag(_z)       (((double*)&(_z))[1])
 #define  realf(_z)      (((float*)&(_z))[0])
@@ -97,6 +113,10 @@ typedef int _Complex       complex_i_t;
 #ifdef __GNUC__
 #define  reali(_z)      (((int*)&(_z))[0])
 #define  imagi(_z)      (((int*)&(_z))[1])
+#define  realq15(_z)    (((short*)&(_z))[0])
+#define  imagq15(_z)    (((short*)&(_z))[1])
+#define  realq31(_z)    (((int*)&(_z))[0])
+#define  imagq31(_z)    (((int*)&(_z))[1])
 #endif
 #ifdef __cplusplus
 }
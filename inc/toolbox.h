@@ -85,12 +85,14 @@ extern "C" {
  */
 #include <dsp/leaky_int.h>
 #include <dsp/filter_mova.h>
+#include <dsp/filter_cic.h>
 #include <dsp/fir_wsinc.h>
 #include <dsp/vectors.h>
 #include <dsp/conv.h>
 #include <dsp/xcorr.h>
 #include <dsp/dft.h>
 #include <dsp/fft.h>
+#include <dsp/fft_mt.h>
 
 /*!
  * \defgroup math
@@ -114,6 +116,7 @@ extern "C" {
 //#include <sys/ffconf.h>
 //#include <sys/integer.h>
 #include <sys/jiffies.h>
+#include <sys/arena.h>
 //#include <sys/semaphore.h>
 
 /*!
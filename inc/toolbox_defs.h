@@ -68,6 +68,63 @@ extern "C" {
 #define __Os__
 #endif
 
+/*!
+ * Host SIMD support.
+ * On x86 hosts the DSP functions can use SSE2/AVX2 kernels, selected
+ * at run time via CPU feature detection. Define TBX_NO_SIMD to use only
+ * the portable C code.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(TBX_NO_SIMD)
+#define TBX_SIMD_X86
+#endif
+
+/*!
+ * Host thread support.
+ * On POSIX hosts some DSP functions can spread large jobs over a pthread
+ * worker pool. Define TBX_NO_THREADS to leave them out.
+ */
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(TBX_NO_THREADS)
+#define TBX_THREADS
+#endif
+
+#ifdef TBX_SIMD_X86
+#define __target_sse2__    __attribute__ ((target("sse2")))
+#define __target_avx2__    __attribute__ ((target("avx2")))
+#endif
+
+/*!
+ * SIMD kernel selection.
+ * Each SIMD kernel has _scalar, _sse2 and _avx2 variants in a table made
+ * by TBX_ISA_KRN(), indexed by tbx_isa() at the call.
+ */
+#define  TBX_ISA_SCALAR    (0)
+#define  TBX_ISA_SSE2      (1)
+#define  TBX_ISA_AVX2      (2)
+
+#ifdef TBX_SIMD_X86
+/*!
+ * \brief
+ *    Get the instruction set level of the host CPU. The CPU features
+ *    are probed at the first call.
+ * \return  TBX_ISA_SCALAR, TBX_ISA_SSE2 or TBX_ISA_AVX2
+ */
+static inline int tbx_isa (void) {
+   static int isa = -1;
+
+   if (isa < 0) {
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx2"))         isa = TBX_ISA_AVX2;
+      else if (__builtin_cpu_supports ("sse2"))    isa = TBX_ISA_SSE2;
+      else                                         isa = TBX_ISA_SCALAR;
+   }
+   return isa;
+}
+#define  TBX_ISA_KRN(_name)      { _name##_scalar, _name##_sse2, _name##_avx2 }
+#else
+#define  tbx_isa()               (TBX_ISA_SCALAR)
+#define  TBX_ISA_KRN(_name)      { _name##_scalar }
+#endif
+
 
 
 
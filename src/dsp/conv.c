@@ -22,20 +22,276 @@
  *
  */
 #include <dsp/conv.h>
+#ifdef TBX_SIMD_X86
+#include <immintrin.h>
+#endif
 
+/*
+ * Static functions
+ */
+static void _conv_krn_i (int *y, int *h, int32_t sh, int *x, int32_t cnt) __O3__ ;
+static void _conv_krn_ci (complex_i_t *y, complex_i_t *h, int32_t sh, complex_i_t *x, int32_t cnt) __O3__ ;
+static void _conv_krn_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_t cnt) __O3__ ;
+static void _conv_krn_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_t cnt) __O3__ ;
+static void _conv_krn_f_scalar (float *y, float *h, int32_t sh, float *x, int32_t cnt) __O3__ ;
+static void _conv_krn_d_scalar (double *y, double *h, int32_t sh, double *x, int32_t cnt) __O3__ ;
+
+/*!
+ * Outputs per block of the scalar steady state kernels
+ */
+#define  _CONV_BLK      (8)
+
+/*!
+ * \brief
+ *    The main body of the steady state kernels.
+ *    Calculates cnt outputs y[i] = Sum {h[k]*x[i-k]}, k: [0 .. sh-1],
+ *    where all x[i-k] are inside the signal, so there is no range check.
+ *    The outputs are calculated in blocks of _CONV_BLK, with the
+ *    accumulators in local variables and each h[k] loaded once per block.
+ *
+ * \param   _type    The signal type
+ */
+#define  _conv_krn_body(_type) {                      \
+   _type a0, a1, a2, a3, a4, a5, a6, a7, hk, *xk;     \
+   int32_t i, k;                                      \
+                                                      \
+   for (i=0 ; i+_CONV_BLK<=cnt ; i+=_CONV_BLK) {      \
+      a0 = a1 = a2 = a3 = a4 = a5 = a6 = a7 = 0;      \
+      for (k=0 ; k<sh ; ++k) {                        \
+         hk = h[k];                                   \
+         xk = &x[i-k];                                \
+         a0 += hk*xk[0];   a1 += hk*xk[1];            \
+         a2 += hk*xk[2];   a3 += hk*xk[3];            \
+         a4 += hk*xk[4];   a5 += hk*xk[5];            \
+         a6 += hk*xk[6];   a7 += hk*xk[7];            \
+      }                                               \
+      y[i]   = a0;   y[i+1] = a1;                     \
+      y[i+2] = a2;   y[i+3] = a3;                     \
+      y[i+4] = a4;   y[i+5] = a5;                     \
+      y[i+6] = a6;   y[i+7] = a7;                     \
+   }                                                  \
+   for ( ; i<cnt ; ++i) {                             \
+      for (a0=0, k=0 ; k<sh ; ++k)                    \
+         a0 += h[k]*x[i-k];                           \
+      y[i] = a0;                                      \
+   }                                                  \
+}
+
+static void _conv_krn_i (int *y, int *h, int32_t sh, int *x, int32_t cnt) {
+   _conv_krn_body (int);
+}
+static void _conv_krn_ci (complex_i_t *y, complex_i_t *h, int32_t sh, complex_i_t *x, int32_t cnt) {
+   _conv_krn_body (complex_i_t);
+}
+static void _conv_krn_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_t cnt) {
+   _conv_krn_body (complex_f_t);
+}
+static void _conv_krn_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_t cnt) {
+   _conv_krn_body (complex_d_t);
+}
+static void _conv_krn_f_scalar (float *y, float *h, int32_t sh, float *x, int32_t cnt) {
+   _conv_krn_body (float);
+}
+static void _conv_krn_d_scalar (double *y, double *h, int32_t sh, double *x, int32_t cnt) {
+   _conv_krn_body (double);
+}
+
+#ifdef TBX_SIMD_X86
+/*
+ * ============ x86 SIMD kernels ============
+ *
+ * Two vector accumulators, h[k] broadcast and x[i-k] unaligned loads.
+ * Each output sums in the same k order as the scalar kernel, without
+ * fused multiply-add, so all kernels give the same results.
+ */
+__target_sse2__ static void _conv_krn_f_sse2 (float *y, float *h, int32_t sh, float *x, int32_t cnt) {
+   __m128 a0, a1, hk;
+   int32_t i, k;
+
+   for (i=0 ; i+8<=cnt ; i+=8) {
+      a0 = a1 = _mm_setzero_ps ();
+      for (k=0 ; k<sh ; ++k) {
+         hk = _mm_set1_ps (h[k]);
+         a0 = _mm_add_ps (a0, _mm_mul_ps (hk, _mm_loadu_ps (&x[i-k])));
+         a1 = _mm_add_ps (a1, _mm_mul_ps (hk, _mm_loadu_ps (&x[i-k+4])));
+      }
+      _mm_storeu_ps (&y[i], a0);
+      _mm_storeu_ps (&y[i+4], a1);
+   }
+   if (i<cnt)
+      _conv_krn_f_scalar (&y[i], h, sh, &x[i], cnt-i);
+}
+
+__target_avx2__ static void _conv_krn_f_avx2 (float *y, float *h, int32_t sh, float *x, int32_t cnt) {
+   __m256 a0, a1, hk;
+   int32_t i, k;
+
+   for (i=0 ; i+16<=cnt ; i+=16) {
+      a0 = a1 = _mm256_setzero_ps ();
+      for (k=0 ; k<sh ; ++k) {
+         hk = _mm256_set1_ps (h[k]);
+         a0 = _mm256_add_ps (a0, _mm256_mul_ps (hk, _mm256_loadu_ps (&x[i-k])));
+         a1 = _mm256_add_ps (a1, _mm256_mul_ps (hk, _mm256_loadu_ps (&x[i-k+8])));
+      }
+      _mm256_storeu_ps (&y[i], a0);
+      _mm256_storeu_ps (&y[i+8], a1);
+   }
+   if (i<cnt)
+      _conv_krn_f_sse2 (&y[i], h, sh, &x[i], cnt-i);
+}
+
+__target_sse2__ static void _conv_krn_d_sse2 (double *y, double *h, int32_t sh, double *x, int32_t cnt) {
+   __m128d a0, a1, hk;
+   int32_t i, k;
+
+   for (i=0 ; i+4<=cnt ; i+=4) {
+      a0 = a1 = _mm_setzero_pd ();
+      for (k=0 ; k<sh ; ++k) {
+         hk = _mm_set1_pd (h[k]);
+         a0 = _mm_add_pd (a0, _mm_mul_pd (hk, _mm_loadu_pd (&x[i-k])));
+         a1 = _mm_add_pd (a1, _mm_mul_pd (hk, _mm_loadu_pd (&x[i-k+2])));
+      }
+      _mm_storeu_pd (&y[i], a0);
+      _mm_storeu_pd (&y[i+2], a1);
+   }
+   if (i<cnt)
+      _conv_krn_d_scalar (&y[i], h, sh, &x[i], cnt-i);
+}
+
+__target_avx2__ static void _conv_krn_d_avx2 (double *y, double *h, int32_t sh, double *x, int32_t cnt) {
+   __m256d a0, a1, hk;
+   int32_t i, k;
+
+   for (i=0 ; i+8<=cnt ; i+=8) {
+      a0 = a1 = _mm256_setzero_pd ();
+      for (k=0 ; k<sh ; ++k) {
+         hk = _mm256_set1_pd (h[k]);
+         a0 = _mm256_add_pd (a0, _mm256_mul_pd (hk, _mm256_loadu_pd (&x[i-k])));
+         a1 = _mm256_add_pd (a1, _mm256_mul_pd (hk, _mm256_loadu_pd (&x[i-k+4])));
+      }
+      _mm256_storeu_pd (&y[i], a0);
+      _mm256_storeu_pd (&y[i+4], a1);
+   }
+   if (i<cnt)
+      _conv_krn_d_sse2 (&y[i], h, sh, &x[i], cnt-i);
+}
+#endif   // #ifdef TBX_SIMD_X86
+
+typedef void (*_conv_krn_f_pt) (float *y, float *h, int32_t sh, float *x, int32_t cnt);
+typedef void (*_conv_krn_d_pt) (double *y, double *h, int32_t sh, double *x, int32_t cnt);
+static const _conv_krn_f_pt _conv_krn_f[] = TBX_ISA_KRN (_conv_krn_f);
+static const _conv_krn_d_pt _conv_krn_d[] = TBX_ISA_KRN (_conv_krn_d);
 
-#define  _conv_body() {                               \
-   int n, k, sy, kmin, kmax;                          \
+/*!
+ * \brief
+ *    The main body of the direct convolution.
+ *    The shorter signal is used as kernel. The outputs are split to
+ *    the head edge n: [0 .. sh-2] and the tail edge n: [sx .. sy-1], where
+ *    the kernel only partially overlaps the signal, and the steady state
+ *    n: [sh-1 .. sx-1] that runs on the blocked _krn kernel.
+ *
+ * \param   _type    The signal type
+ * \param   _krn     The steady state kernel
+ */
+#define  _conv_body(_type, _krn) {                    \
+   _type *_p, _a;                                     \
+   int32_t n, k, sy;                                  \
                                                       \
+   if (sh > sx) {                                     \
+      _p = h; h = x; x = _p;                          \
+      n = sh; sh = sx; sx = n;                        \
+   }                                                  \
    sy = sx + sh - 1;                                  \
-   --sx; --sh; /* Convert to last point */            \
-   for (n=0; n<sy; ++n) {                             \
-      /* Find convolution range - zero padding */     \
-      kmax = (n - sh < 0)       ? n : sh;             \
-      kmin = ((k = n - sx) > 0) ? k : 0;              \
-      for (y[n]=0, k=kmin; k<=kmax; ++k)              \
-         y[n] += h[k] * x[n-k];  /* Do the sum */     \
-  }                                                   \
+   /* Head edge */                                    \
+   for (n=0 ; n<sh-1 ; ++n) {                         \
+      for (_a=0, k=0 ; k<=n ; ++k)                    \
+         _a += h[k] * x[n-k];                         \
+      y[n] = _a;                                      \
+   }                                                  \
+   /* Steady state */                                 \
+   _krn (&y[sh-1], h, sh, &x[sh-1], sx-sh+1);         \
+   /* Tail edge */                                    \
+   for (n=sx ; n<sy ; ++n) {                          \
+      for (_a=0, k=n-sx+1 ; k<sh ; ++k)               \
+         _a += h[k] * x[n-k];                         \
+      y[n] = _a;                                      \
+   }                                                  \
+}
+
+/*!
+ * \brief
+ *    The direct/FFT crossover
+ */
+#define  _conv_use_fft()                                 \
+   (sh >= CONV_FFT_MIN && sx >= CONV_FFT_MIN &&          \
+    (int64_t)sh*sx >= CONV_FFT_MIN_OPS)
+
+/*!
+ * \brief
+ *    The main body of the FFT convolution.
+ *    The shorter signal (kernel) of size s is transformed once. The longer
+ *    of size S is cut to blocks of N points, overlapping by s-1, each block is
+ *    transformed, multiplied by the kernel spectrum and transformed back, and
+ *    the last N-s+1 points are kept (overlap-save). N is the power of 2 near
+ *    CONV_OLS_RATIO*s, but no more than what the whole signal needs. So for
+ *    comparable sizes there is only one whole-signal block.
+ *    The direct form is used if the memory allocation fails.
+ *
+ * \param   _type    The signal type
+ * \param   _ctype   The complex spectrum type
+ * \param   _fft     The plan FFT
+ * \param   _ifft    The plan inverse FFT
+ * \param   _krn     The direct steady state kernel, for the fallback
+ */
+#define  _conv_fft_body(_type, _ctype, _fft, _ifft, _krn) {       \
+   fft_plan_t p;                                                  \
+   _type *hh, *xx, *R;                                            \
+   _ctype *H, *B;                                                 \
+   int32_t s, S, sy, N, M, pos, j0, a, b, i;                      \
+                                                                  \
+   if (sh <= sx)  { hh = h; s = sh; xx = x; S = sx; }             \
+   else           { hh = x; s = sx; xx = h; S = sh; }             \
+   sy = S + s - 1;                                                \
+   for (N=4 ; N < CONV_OLS_RATIO*s && N < sy+s-1 ; N<<=1)         \
+      ;                                                           \
+   H = NULL;                                                      \
+   if (fft_plan_init (&p, N)) {                                   \
+      H = (_ctype*)malloc (2*N*sizeof (_ctype) + 2*N*sizeof (_type)); \
+      if (H == NULL)                                              \
+         fft_plan_deinit (&p);                                    \
+   }                                                              \
+   if (H == NULL) {                                               \
+      _conv_body (_type, _krn);                                   \
+      return;                                                     \
+   }                                                              \
+   B = &H[N];                                                     \
+   R = (_type*)&B[N];                                             \
+   M = N - s + 1;                                                 \
+                                                                  \
+   /* Kernel spectrum */                                          \
+   for (i=0 ; i<s ; ++i)   R[i] = hh[i];                          \
+   for ( ; i<N ; ++i)      R[i] = 0;                              \
+   _fft (&p, R, H);                                               \
+                                                                  \
+   for (pos=0 ; pos<sy ; pos+=M) {                                \
+      /* Input block xx[j0 .. j0+N), zero padded */               \
+      j0 = pos - (s-1);                                           \
+      a = (j0 < 0) ? -j0 : 0;                                     \
+      b = (S - j0 < N) ? S - j0 : N;                              \
+      for (i=0 ; i<a ; ++i)   R[i] = 0;                           \
+      for ( ; i<b ; ++i)      R[i] = xx[j0+i];                    \
+      for ( ; i<N ; ++i)      R[i] = 0;                           \
+      _fft (&p, R, B);                                            \
+      for (i=0 ; i<N ; ++i)                                       \
+         B[i] *= H[i];                                            \
+      _ifft (&p, B, R);                                           \
+      /* Keep the valid, not wrapped, part */                     \
+      b = (sy - pos < M) ? sy - pos : M;                          \
+      for (i=0 ; i<b ; ++i)                                       \
+         y[pos+i] = R[s-1+i];                                     \
+   }                                                              \
+   free ((void*)H);                                               \
+   fft_plan_deinit (&p);                                          \
 }
 
 
@@ -64,7 +320,7 @@
  * \return none
  */
 void conv_i (int *y, int *h, int32_t sh, int *x, int32_t sx) {
-   _conv_body();
+   _conv_body (int, _conv_krn_i);
 }
 
 /*!
@@ -91,7 +347,10 @@ void conv_i (int *y, int *h, int32_t sh, int *x, int32_t sx) {
  * \return none
  */
 void conv_f (float *y, float *h, int32_t sh, float *x, int32_t sx) {
-   _conv_body();
+   if (_conv_use_fft())
+      conv_fft_f (y, h, sh, x, sx);
+   else
+      _conv_body (float, _conv_krn_f[tbx_isa ()]);
 }
 
 /*!
@@ -118,7 +377,10 @@ void conv_f (float *y, float *h, int32_t sh, float *x, int32_t sx) {
  * \return none
  */
 void conv_d (double *y, double *h, int32_t sh, double *x, int32_t sx) {
-   _conv_body();
+   if (_conv_use_fft())
+      conv_fft_d (y, h, sh, x, sx);
+   else
+      _conv_body (double, _conv_krn_d[tbx_isa ()]);
 }
 
 /*!
@@ -145,7 +407,7 @@ void conv_d (double *y, double *h, int32_t sh, double *x, int32_t sx) {
  * \return none
  */
 void conv_ci (complex_i_t *y, complex_i_t *h, int32_t sh, complex_i_t *x, int32_t sx) {
-   _conv_body();
+   _conv_body (complex_i_t, _conv_krn_ci);
 }
 
 /*!
@@ -172,7 +434,10 @@ void conv_ci (complex_i_t *y, complex_i_t *h, int32_t sh, complex_i_t *x, int32_
  * \return none
  */
 void conv_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_t sx) {
-   _conv_body();
+   if (_conv_use_fft())
+      conv_fft_cf (y, h, sh, x, sx);
+   else
+      _conv_body (complex_f_t, _conv_krn_cf);
 }
 
 /*!
@@ -199,7 +464,398 @@ void conv_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_
  * \return none
  */
 void conv_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_t sx) {
-   _conv_body();
+   if (_conv_use_fft())
+      conv_fft_cd (y, h, sh, x, sx);
+   else
+      _conv_body (complex_d_t, _conv_krn_cd);
+}
+
+/*!
+ * \brief
+ *    Calculates the convolution of float h and x using the FFT.
+ *    Overlap-save for long signals, whole-signal for comparable sizes.
+ *
+ * \param   y  Pointer to output vector, size sh+sx-1
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+void conv_fft_f (float *y, float *h, int32_t sh, float *x, int32_t sx) {
+   _conv_fft_body (float, complex_f_t, fftp_rf, ifftp_rf, _conv_krn_f[tbx_isa ()]);
+}
+
+/*!
+ * \brief
+ *    Calculates the convolution of double h and x using the FFT.
+ *    Overlap-save for long signals, whole-signal for comparable sizes.
+ *
+ * \param   y  Pointer to output vector, size sh+sx-1
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+void conv_fft_d (double *y, double *h, int32_t sh, double *x, int32_t sx) {
+   _conv_fft_body (double, complex_d_t, fftp_r, ifftp_r, _conv_krn_d[tbx_isa ()]);
+}
+
+/*!
+ * \brief
+ *    Calculates the convolution of complex float h and x using the FFT.
+ *    Overlap-save for long signals, whole-signal for comparable sizes.
+ *
+ * \param   y  Pointer to output vector, size sh+sx-1
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+void conv_fft_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_t sx) {
+   _conv_fft_body (complex_f_t, complex_f_t, fftp_cf, ifftp_cf, _conv_krn_cf);
+}
+
+/*!
+ * \brief
+ *    Calculates the convolution of complex double h and x using the FFT.
+ *    Overlap-save for long signals, whole-signal for comparable sizes.
+ *
+ * \param   y  Pointer to output vector, size sh+sx-1
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+void conv_fft_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_t sx) {
+   _conv_fft_body (complex_d_t, complex_d_t, fftp_c, ifftp_c, _conv_krn_cd);
+}
+/*
+ * ============ Streaming convolution ============
+ */
+
+/*!
+ * \brief
+ *    Streaming convolution de-initialisation.
+ *    The memory of a streaming convolution from conv_stream_init_static_*()
+ *    stays to the caller.
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \return  none
+ */
+void conv_stream_deinit (conv_stream_t *s) {
+   if (s->type == CONV_STREAM_FFT)
+      fft_plan_deinit (&s->p);
+   if (s->blk)
+      free (s->blk);
+   memset ((void*)s, 0, sizeof (conv_stream_t));
+}
+
+/*!
+ * \brief
+ *    Resolve the backend and the block sizes of a streaming convolution.
+ *    The direct backend uses blocks of CONV_STREAM_BLK new samples.
+ *    The FFT backend uses the overlap-save size of conv_fft(), so each
+ *    block of N points gives M = N-sh+1 outputs.
+ *
+ * \param   sh       Size of the kernel
+ * \param   type     Pointer to the backend, AUTO is resolved
+ * \param   N,M      Pointers to the FFT size and the new samples per block
+ * \param   it       The item size
+ * \param   cit      The complex item size
+ * \return  The memory size in bytes
+ */
+static size_t _conv_stream_size (uint32_t sh, conv_stream_en *type, uint32_t *N, uint32_t *M, size_t it, size_t cit)
+{
+   size_t sz;
+
+   if (*type == CONV_STREAM_AUTO)
+      *type = (sh >= CONV_FFT_MIN) ? CONV_STREAM_FFT : CONV_STREAM_DIRECT;
+   if (*type == CONV_STREAM_FFT) {
+      for (*N=4 ; *N < CONV_OLS_RATIO*sh ; *N<<=1)
+         ;
+      *M = *N - sh + 1;
+      /* h, R, O (2N for the real ifft), then the complex H, B */
+      sz = ((sh + 3*(*N))*it + cit - 1) / cit;
+      return ARENA_SIZE ((sz + 2*(*N)) * cit) + fft_plan_required_size (*N);
+   }
+   else {
+      *M = CONV_STREAM_BLK;
+      *N = sh - 1 + *M;
+      return ARENA_SIZE ((sh + *N) * it);
+   }
+}
+
+/*!
+ * \brief
+ *    The main body of the streaming convolution initialisation.
+ *    All the buffers are in one block, starting from the kernel,
+ *    followed by the FFT plan.
+ *
+ * \param   _type    The signal type
+ * \param   _ctype   The complex spectrum type
+ * \param   _fft     The plan FFT
+ */
+#define  _conv_stream_init_body(_type, _ctype, _fft) {            \
+   uint32_t i;                                                    \
+   size_t sz;                                                     \
+   arena_t a;                                                     \
+                                                                  \
+   memset ((void*)s, 0, sizeof (conv_stream_t));                  \
+   if (sh == 0)                                                   \
+      return 0;                                                   \
+   arena_init (&a, mem, size);                                    \
+   _conv_stream_size (sh, &type, &s->N, &s->M, sizeof (_type), sizeof (_ctype)); \
+   if (type == CONV_STREAM_FFT) {                                 \
+      sz = (sh + 3*s->N) * sizeof (_type);                        \
+      sz = (sz + sizeof (_ctype) - 1) / sizeof (_ctype);          \
+      if ((s->h = arena_alloc (&a, (sz + 2*s->N) * sizeof (_ctype))) == NULL) \
+         return 0;                                                \
+      s->R = (void*)&((_type*)s->h)[sh];                          \
+      s->O = (void*)&((_type*)s->R)[s->N];                        \
+      s->H = (void*)&((_ctype*)s->h)[sz];                         \
+      s->B = (void*)&((_ctype*)s->H)[s->N];                       \
+      sz = fft_plan_required_size (s->N);                         \
+      if (!fft_plan_init_static (&s->p, s->N, arena_alloc (&a, sz), sz)) \
+         return 0;                                                \
+   }                                                              \
+   else {                                                         \
+      if ((s->h = arena_alloc (&a, (sh + s->N) * sizeof (_type))) == NULL) \
+         return 0;                                                \
+      s->R = (void*)&((_type*)s->h)[sh];                          \
+   }                                                              \
+   s->type = type;                                                \
+   s->it_size = sizeof (_type);                                   \
+   s->sh = sh;                                                    \
+   for (i=0 ; i<sh ; ++i)                                         \
+      ((_type*)s->h)[i] = h[i];                                   \
+   if (type == CONV_STREAM_FFT) {                                 \
+      /* Kernel spectrum, the input buffer as scratch */          \
+      for (i=0 ; i<s->N ; ++i)                                    \
+         ((_type*)s->R)[i] = (i<sh) ? h[i] : 0;                   \
+      _fft (&s->p, (_type*)s->R, (_ctype*)s->H);                  \
+   }                                                              \
+   conv_stream_reset (s);                                         \
+   return s->N;                                                   \
+}
+
+/*!
+ * \brief
+ *    The heap streaming convolution initialisation. Allocates the
+ *    memory block and uses the static initialisation over it.
+ *
+ * \param   _init    The static initialisation
+ * \param   _size    The required size function
+ */
+#define  _conv_stream_init_heap(_init, _size) {                   \
+   size_t sz = _size (sh, type);                                  \
+   uint32_t N;                                                    \
+   void *mem;                                                     \
+                                                                  \
+   memset ((void*)s, 0, sizeof (conv_stream_t));                  \
+   if (!sz || (mem = malloc (sz + ARENA_ALIGN)) == NULL)          \
+      return 0;                                                   \
+   if ((N = _init (s, h, sh, type, mem, sz + ARENA_ALIGN)) == 0) {\
+      free (mem);                                                 \
+      return 0;                                                   \
+   }                                                              \
+   s->blk = mem;                                                  \
+   return N;                                                      \
+}
+
+/*!
+ * \brief
+ *    Get the memory size of a float streaming convolution,
+ *    for conv_stream_init_static_f()
+ *
+ * \param  sh     Size of the kernel
+ * \param  type   The backend, CONV_STREAM_AUTO, _DIRECT or _FFT
+ * \return  The size in bytes, 0 for an empty kernel
+ */
+size_t conv_stream_required_size_f (uint32_t sh, conv_stream_en type) {
+   uint32_t N, M;
+   return (sh) ? _conv_stream_size (sh, &type, &N, &M, sizeof (float), sizeof (complex_f_t)) : 0;
+}
+
+/*!
+ * \brief
+ *    Get the memory size of a double streaming convolution,
+ *    for conv_stream_init_static_d()
+ *
+ * \param  sh     Size of the kernel
+ * \param  type   The backend, CONV_STREAM_AUTO, _DIRECT or _FFT
+ * \return  The size in bytes, 0 for an empty kernel
+ */
+size_t conv_stream_required_size_d (uint32_t sh, conv_stream_en type) {
+   uint32_t N, M;
+   return (sh) ? _conv_stream_size (sh, &type, &N, &M, sizeof (double), sizeof (complex_d_t)) : 0;
+}
+
+/*!
+ * \brief
+ *    Initialise a float streaming convolution over caller supplied
+ *    memory, with no heap use. The memory must stay valid for the
+ *    life of the convolution and is not freed by conv_stream_deinit().
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \param   h     Pointer to the kernel
+ * \param  sh     Size of the kernel
+ * \param  type   The backend, CONV_STREAM_AUTO, _DIRECT or _FFT
+ * \param  mem    Pointer to memory, aligned to ARENA_ALIGN
+ * \param  size   The size of the memory, at least conv_stream_required_size_f()
+ *
+ * \return  The input buffer size on success, 0 on failure
+ */
+uint32_t conv_stream_init_static_f (conv_stream_t *s, const float *h, uint32_t sh, conv_stream_en type, void *mem, size_t size) {
+   _conv_stream_init_body (float, complex_f_t, fftp_rf);
+}
+
+/*!
+ * \brief
+ *    Initialise a double streaming convolution over caller supplied
+ *    memory, with no heap use. The memory must stay valid for the
+ *    life of the convolution and is not freed by conv_stream_deinit().
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \param   h     Pointer to the kernel
+ * \param  sh     Size of the kernel
+ * \param  type   The backend, CONV_STREAM_AUTO, _DIRECT or _FFT
+ * \param  mem    Pointer to memory, aligned to ARENA_ALIGN
+ * \param  size   The size of the memory, at least conv_stream_required_size_d()
+ *
+ * \return  The input buffer size on success, 0 on failure
+ */
+uint32_t conv_stream_init_static_d (conv_stream_t *s, const double *h, uint32_t sh, conv_stream_en type, void *mem, size_t size) {
+   _conv_stream_init_body (double, complex_d_t, fftp_r);
+}
+
+/*!
+ * \brief
+ *    Initialise a float streaming convolution
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \param   h     Pointer to the kernel
+ * \param  sh     Size of the kernel
+ * \param  type   The backend, CONV_STREAM_AUTO, _DIRECT or _FFT
+ *
+ * \return  The input buffer size on success, 0 on failure
+ */
+uint32_t conv_stream_init_f (conv_stream_t *s, const float *h, uint32_t sh, conv_stream_en type) {
+   _conv_stream_init_heap (conv_stream_init_static_f, conv_stream_required_size_f);
+}
+
+/*!
+ * \brief
+ *    Initialise a double streaming convolution
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \param   h     Pointer to the kernel
+ * \param  sh     Size of the kernel
+ * \param  type   The backend, CONV_STREAM_AUTO, _DIRECT or _FFT
+ *
+ * \return  The input buffer size on success, 0 on failure
+ */
+uint32_t conv_stream_init_d (conv_stream_t *s, const double *h, uint32_t sh, conv_stream_en type) {
+   _conv_stream_init_heap (conv_stream_init_static_d, conv_stream_required_size_d);
+}
+
+/*!
+ * \brief
+ *    Clear the history of a streaming convolution, as if no
+ *    input was ever given. The kernel stays.
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \return  none
+ */
+void conv_stream_reset (conv_stream_t *s) {
+   memset (s->R, 0, (s->sh - 1 + s->M) * s->it_size);
+   s->c = 0;
+}
+
+/*!
+ * \brief
+ *    The main body of the streaming convolution.
+ *    The input is copied to the buffer in chunks up to the end of the
+ *    current block. A whole FFT block gets its outputs from the block
+ *    transform. A chunk that only completes a block uses the transform
+ *    when its m*sh multiply-adds cost more than the N*(log2(N)+1) of the
+ *    forward and inverse transforms, any other chunk the direct kernel.
+ *    Then a full block keeps its last sh-1 samples as history.
+ *
+ * \param   _type    The signal type
+ * \param   _ctype   The complex spectrum type
+ * \param   _fft     The plan FFT
+ * \param   _ifft    The plan inverse FFT
+ * \param   _krn     The direct steady state kernel
+ */
+#define  _conv_stream_body(_type, _ctype, _fft, _ifft, _krn) {    \
+   _type *h = (_type*)s->h, *R = (_type*)s->R, *O = (_type*)s->O; \
+   _ctype *H = (_ctype*)s->H, *B = (_ctype*)s->B;                 \
+   uint32_t i, j, m, sh1 = s->sh - 1;                             \
+                                                                  \
+   for (i=0 ; i<n ; i+=m) {                                       \
+      m = (n-i < s->M - s->c) ? n-i : s->M - s->c;                \
+      for (j=0 ; j<m ; ++j)                                       \
+         R[sh1 + s->c + j] = x[i+j];                              \
+      if (s->type == CONV_STREAM_FFT && s->c + m == s->M &&       \
+          (m == s->M || (uint64_t)m*s->sh > (uint64_t)s->N*(s->p.m + 1))) { \
+         _fft (&s->p, R, B);                                      \
+         for (j=0 ; j<s->N ; ++j)                                 \
+            B[j] *= H[j];                                         \
+         _ifft (&s->p, B, O);                                     \
+         for (j=0 ; j<m ; ++j)                                    \
+            y[i+j] = O[sh1 + s->c + j];                           \
+      }                                                           \
+      else                                                        \
+         _krn (&y[i], h, s->sh, &R[sh1 + s->c], m);               \
+      if ((s->c += m) == s->M) {                                  \
+         memmove ((void*)R, (void*)&R[s->M], sh1*sizeof (_type)); \
+         s->c = 0;                                                \
+      }                                                           \
+   }                                                              \
+}
+
+/*!
+ * \brief
+ *    Filter the next n float input samples
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \param   y     Pointer to output block, size n. It can be the same as x.
+ * \param   x     Pointer to input block
+ * \param   n     The block size, any
+ *
+ * \return none
+ */
+void conv_stream_f (conv_stream_t *s, float *y, const float *x, uint32_t n) {
+   _conv_stream_body (float, complex_f_t, fftp_rf, ifftp_rf, _conv_krn_f[tbx_isa ()]);
+}
+
+/*!
+ * \brief
+ *    Filter the next n double input samples
+ *
+ * \param   s     Pointer to the streaming convolution
+ * \param   y     Pointer to output block, size n. It can be the same as x.
+ * \param   x     Pointer to input block
+ * \param   n     The block size, any
+ *
+ * \return none
+ */
+void conv_stream_d (conv_stream_t *s, double *y, const double *x, uint32_t n) {
+   _conv_stream_body (double, complex_d_t, fftp_r, ifftp_r, _conv_krn_d[tbx_isa ()]);
 }
+#undef _conv_stream_init_body
+#undef _conv_stream_init_heap
+#undef _conv_stream_body
+#undef _conv_use_fft
+#undef _conv_fft_body
 #undef _conv_body
+#undef _conv_krn_body
 
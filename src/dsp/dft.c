@@ -288,3 +288,427 @@ void idft_rf (complex_f_t *X, float *x, uint32_t n)
    }
 }
 
+
+
+/*
+ * ============ Partial spectrum DFT ============
+ */
+
+/*!
+ * \brief
+ *    The main body of the partial spectrum DFT.
+ *    For each bin b the phasor e^(-j2pi*b*j/n) is rotated sample by sample
+ *    in the working precision, and every DFT_BINS_BLK samples it is reloaded
+ *    from a double precision anchor, rotated by e^(-j2pi*b*DFT_BINS_BLK/n).
+ *    This keeps the rotation error bounded, even for single precision.
+ *
+ * \param   _ctype   The complex working type
+ * \param   _bin     Expression of the i-th bin
+ */
+#define _dft_bins_body(_ctype, _bin) {                         \
+   uint32_t i, j, je, b;                                       \
+   complex_d_t wb, pa;                                         \
+   _ctype w, ph, acc;                                          \
+                                                               \
+   if (!n)                                                     \
+      return;                                                  \
+   for (i=0 ; i<K ; ++i) {                                     \
+      b = (_bin) % n;                                          \
+      w = (_ctype)cexp (-I*M_2PI*b/n);                         \
+      wb = cexp (-I*M_2PI*(double)(((uint64_t)b*DFT_BINS_BLK) % n)/n); \
+      pa = 1;                                                  \
+      acc = 0;                                                 \
+      for (j=0 ; j<n ; ) {                                     \
+         je = (n-j > DFT_BINS_BLK) ? j+DFT_BINS_BLK : n;       \
+         ph = (_ctype)pa;                                      \
+         for ( ; j<je ; ++j) {                                 \
+            acc += x[j] * ph;                                  \
+            ph *= w;                                           \
+         }                                                     \
+         pa *= wb;                                             \
+      }                                                        \
+      X[i] = acc;                                              \
+   }                                                           \
+}
+
+/*!
+ * \brief
+ *    Calculate a list of bins of the double precision complex DFT.
+ *
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin[i]
+ * \param   n     Number of points
+ * \param   bins  Pointer to the K bin indexes
+ * \param   K     Number of bins
+ * \return        None
+ */
+void dft_bins_c (complex_d_t *x, complex_d_t *X, uint32_t n, const uint32_t *bins, uint32_t K) {
+   _dft_bins_body (complex_d_t, bins[i]);
+}
+
+/*!
+ * \brief
+ *    Calculate a list of bins of the single precision complex DFT.
+ *
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin[i]
+ * \param   n     Number of points
+ * \param   bins  Pointer to the K bin indexes
+ * \param   K     Number of bins
+ * \return        None
+ */
+void dft_bins_cf (complex_f_t *x, complex_f_t *X, uint32_t n, const uint32_t *bins, uint32_t K) {
+   _dft_bins_body (complex_f_t, bins[i]);
+}
+
+/*!
+ * \brief
+ *    Calculate a list of bins of the double precision DFT of a real signal.
+ *
+ * \param   x     Pointer to size n time domain real array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin[i]
+ * \param   n     Number of points
+ * \param   bins  Pointer to the K bin indexes
+ * \param   K     Number of bins
+ * \return        None
+ */
+void dft_bins_r (double *x, complex_d_t *X, uint32_t n, const uint32_t *bins, uint32_t K) {
+   _dft_bins_body (complex_d_t, bins[i]);
+}
+
+/*!
+ * \brief
+ *    Calculate a list of bins of the single precision DFT of a real signal.
+ *
+ * \param   x     Pointer to size n time domain real array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin[i]
+ * \param   n     Number of points
+ * \param   bins  Pointer to the K bin indexes
+ * \param   K     Number of bins
+ * \return        None
+ */
+void dft_bins_rf (float *x, complex_f_t *X, uint32_t n, const uint32_t *bins, uint32_t K) {
+   _dft_bins_body (complex_f_t, bins[i]);
+}
+
+/*!
+ * \brief
+ *    Calculate the bins [k0..k0+K) of the double precision complex DFT.
+ *
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin k0+i
+ * \param   n     Number of points
+ * \param   k0    The first bin
+ * \param   K     Number of bins
+ * \return        None
+ */
+void dft_range_c (complex_d_t *x, complex_d_t *X, uint32_t n, uint32_t k0, uint32_t K) {
+   _dft_bins_body (complex_d_t, k0+i);
+}
+
+/*!
+ * \brief
+ *    Calculate the bins [k0..k0+K) of the single precision complex DFT.
+ *
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin k0+i
+ * \param   n     Number of points
+ * \param   k0    The first bin
+ * \param   K     Number of bins
+ * \return        None
+ */
+void dft_range_cf (complex_f_t *x, complex_f_t *X, uint32_t n, uint32_t k0, uint32_t K) {
+   _dft_bins_body (complex_f_t, k0+i);
+}
+
+/*!
+ * \brief
+ *    Calculate the bins [k0..k0+K) of the double precision DFT of a real signal.
+ *
+ * \param   x     Pointer to size n time domain real array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin k0+i
+ * \param   n     Number of points
+ * \param   k0    The first bin
+ * \param   K     Number of bins
+ * \return        None
+ */
+void dft_range_r (double *x, complex_d_t *X, uint32_t n, uint32_t k0, uint32_t K) {
+   _dft_bins_body (complex_d_t, k0+i);
+}
+
+/*!
+ * \brief
+ *    Calculate the bins [k0..k0+K) of the single precision DFT of a real signal.
+ *
+ * \param   x     Pointer to size n time domain real array
+ * \param   X     Pointer to size K frequency domain complex array. X[i] is bin k0+i
+ * \param   n     Number of points
+ * \param   k0    The first bin
+ * \param   K     Number of bins
+ * \return        None
+ */
+void dft_range_rf (float *x, complex_f_t *X, uint32_t n, uint32_t k0, uint32_t K) {
+   _dft_bins_body (complex_f_t, k0+i);
+}
+
+/*
+ * ============ Sliding DFT bin bank ============
+ */
+
+/*!
+ * \brief
+ *    Sliding DFT de-initialisation.
+ *    The memory of a bank from sdft_init_static() stays to the caller.
+ *
+ * \param  s      Which bank to free
+ * \return none
+ */
+void sdft_deinit (sdft_t *s)
+{
+   if (s->blk)
+      free (s->blk);
+   memset ((void*)s, 0, sizeof (sdft_t));
+}
+
+/*!
+ * \brief
+ *    Get the memory size of a sliding DFT bank, for sdft_init_static().
+ *
+ * \param  n      The DFT length (window length)
+ * \param  K      The number of bins
+ * \return        The size in bytes
+ */
+size_t sdft_required_size (uint32_t n, uint32_t K) {
+   return 2*ARENA_SIZE (K*sizeof (complex_d_t))
+        + ARENA_SIZE (n*sizeof (double));
+}
+
+/*!
+ * \brief
+ *    Sliding DFT initialisation.
+ *    The bins start from zero, as if the window was full of zeros.
+ *
+ * \param  s      Which bank to use
+ * \param  n      The DFT length (window length)
+ * \param  bins   Pointer to the K bin indexes to track, in [0..n)
+ * \param  K      The number of bins
+ * \param  r      Damping factor in (0..1]. 1 for the exact DFT. A value
+ *                slightly less than 1 (ex: 1-1e-9) keeps the rounding errors
+ *                from accumulating on very long runs.
+ * \return        The number of bins on success, 0 on failure
+ */
+uint32_t sdft_init (sdft_t *s, uint32_t n, const uint32_t *bins, uint32_t K, double r)
+{
+   size_t sz = sdft_required_size (n, K);
+   void *mem;
+
+   memset ((void*)s, 0, sizeof (sdft_t));
+   if ((mem = malloc (sz)) == NULL)
+      return 0;
+   if (sdft_init_static (s, n, bins, K, r, mem, sz) == 0) {
+      free (mem);
+      return 0;
+   }
+   s->blk = mem;
+   return K;
+}
+
+/*!
+ * \brief
+ *    Sliding DFT initialisation over caller supplied memory, with no heap
+ *    use. The memory must stay valid for the life of the bank and is not
+ *    freed by sdft_deinit().
+ *
+ * \param  s      Which bank to use
+ * \param  n      The DFT length (window length)
+ * \param  bins   Pointer to the K bin indexes to track, in [0..n)
+ * \param  K      The number of bins
+ * \param  r      Damping factor in (0..1]
+ * \param  mem    Pointer to memory, aligned to ARENA_ALIGN
+ * \param  size   The size of the memory, at least sdft_required_size()
+ * \return        The number of bins on success, 0 on failure
+ */
+uint32_t sdft_init_static (sdft_t *s, uint32_t n, const uint32_t *bins, uint32_t K, double r, void *mem, size_t size)
+{
+   arena_t a;
+   uint32_t k;
+
+   memset ((void*)s, 0, sizeof (sdft_t));
+   if (!n || !K || r <= 0 || r > 1)
+      return 0;
+   arena_init (&a, mem, size);
+   s->X = (complex_d_t*)arena_calloc (&a, K*sizeof (complex_d_t));
+   s->w = (complex_d_t*)arena_calloc (&a, K*sizeof (complex_d_t));
+   s->d = (double*)arena_calloc (&a, n*sizeof (double));
+   if (!s->X || !s->w || !s->d) {
+      memset ((void*)s, 0, sizeof (sdft_t));
+      return 0;
+   }
+   s->r = r;
+   s->rn = pow (r, n);
+   s->n = n;
+   s->K = K;
+   for (k=0 ; k<K ; ++k)
+      s->w[k] = r * cexp (I*M_2PI*(double)(bins[k] % n)/n);
+   return K;
+}
+
+/*!
+ * \brief
+ *    Push a new sample to the sliding DFT and update all the bins.
+ *
+ * \param  s      Which bank to use
+ * \param  x      The new sample
+ * \return        Pointer to the K current bins. The i-th is the
+ *                bin[i] of the DFT of the last n samples.
+ */
+complex_d_t *sdft (sdft_t *s, double x)
+{
+   uint32_t k;
+   double dx;
+
+   // Replace the oldest sample in the delay line
+   dx = x - s->rn * s->d[s->c];
+   s->d[s->c] = x;
+   if (++s->c >= s->n)
+      s->c = 0;
+
+   for (k=0 ; k<s->K ; ++k)
+      s->X[k] = s->w[k] * (s->X[k] + dx);
+   return s->X;
+}
+
+
+/*
+ * ============ Goertzel bin bank ============
+ */
+
+/*!
+ * \brief
+ *    Goertzel bank de-initialisation.
+ *    The memory of a bank from goertzel_init_static() stays to the caller.
+ *
+ * \param  g      Which bank to free
+ * \return none
+ */
+void goertzel_deinit (goertzel_t *g)
+{
+   if (g->blk)
+      free (g->blk);
+   memset ((void*)g, 0, sizeof (goertzel_t));
+}
+
+/*!
+ * \brief
+ *    Get the memory size of a Goertzel bank, for goertzel_init_static().
+ *
+ * \param  K      The number of bins
+ * \return        The size in bytes
+ */
+size_t goertzel_required_size (uint32_t K) {
+   return 3*ARENA_SIZE (K*sizeof (complex_d_t))
+        + 3*ARENA_SIZE (K*sizeof (double));
+}
+
+/*!
+ * \brief
+ *    Goertzel bank initialisation.
+ *
+ * \param  g      Which bank to use
+ * \param  n      The block length
+ * \param  bins   Pointer to the K bins to calculate. Fractional bins are
+ *                allowed, the frequency of bin b is b*fs/n.
+ * \param  K      The number of bins
+ * \return        The number of bins on success, 0 on failure
+ */
+uint32_t goertzel_init (goertzel_t *g, uint32_t n, const double *bins, uint32_t K)
+{
+   size_t sz = goertzel_required_size (K);
+   void *mem;
+
+   memset ((void*)g, 0, sizeof (goertzel_t));
+   if ((mem = malloc (sz)) == NULL)
+      return 0;
+   if (goertzel_init_static (g, n, bins, K, mem, sz) == 0) {
+      free (mem);
+      return 0;
+   }
+   g->blk = mem;
+   return K;
+}
+
+/*!
+ * \brief
+ *    Goertzel bank initialisation over caller supplied memory, with no heap
+ *    use. The memory must stay valid for the life of the bank and is not
+ *    freed by goertzel_deinit().
+ *
+ * \param  g      Which bank to use
+ * \param  n      The block length
+ * \param  bins   Pointer to the K bins to calculate
+ * \param  K      The number of bins
+ * \param  mem    Pointer to memory, aligned to ARENA_ALIGN
+ * \param  size   The size of the memory, at least goertzel_required_size()
+ * \return        The number of bins on success, 0 on failure
+ */
+uint32_t goertzel_init_static (goertzel_t *g, uint32_t n, const double *bins, uint32_t K, void *mem, size_t size)
+{
+   arena_t a;
+   uint32_t k;
+   double th;
+
+   memset ((void*)g, 0, sizeof (goertzel_t));
+   if (!n || !K)
+      return 0;
+   arena_init (&a, mem, size);
+   g->X = (complex_d_t*)arena_calloc (&a, K*sizeof (complex_d_t));
+   g->w = (complex_d_t*)arena_calloc (&a, K*sizeof (complex_d_t));
+   g->p = (complex_d_t*)arena_calloc (&a, K*sizeof (complex_d_t));
+   g->cf = (double*)arena_calloc (&a, K*sizeof (double));
+   g->s1 = (double*)arena_calloc (&a, K*sizeof (double));
+   g->s2 = (double*)arena_calloc (&a, K*sizeof (double));
+   if (!g->X || !g->w || !g->p || !g->cf || !g->s1 || !g->s2) {
+      memset ((void*)g, 0, sizeof (goertzel_t));
+      return 0;
+   }
+   g->n = n;
+   g->K = K;
+   for (k=0 ; k<K ; ++k) {
+      th = M_2PI*bins[k]/n;
+      g->cf[k] = 2*cos (th);
+      g->w[k] = cexp (-I*th);
+      g->p[k] = cexp (-I*th*(n-1));
+   }
+   return K;
+}
+
+/*!
+ * \brief
+ *    Push a new sample to the Goertzel bank. Every n samples the
+ *    bins of the block are calculated to g->X and the bank restarts.
+ *
+ * \param  g      Which bank to use
+ * \param  x      The new sample
+ * \return        1 when a block is complete and g->X holds its bins, 0 otherwise
+ */
+int goertzel (goertzel_t *g, double x)
+{
+   uint32_t k;
+   double s;
+
+   for (k=0 ; k<g->K ; ++k) {
+      s = x + g->cf[k]*g->s1[k] - g->s2[k];
+      g->s2[k] = g->s1[k];
+      g->s1[k] = s;
+   }
+   if (++g->cnt < g->n)
+      return 0;
+
+   // X = e^(-jw(n-1)) * (s[n-1] - e^(-jw)*s[n-2])
+   for (k=0 ; k<g->K ; ++k) {
+      g->X[k] = g->p[k] * (g->s1[k] - g->w[k]*g->s2[k]);
+      g->s1[k] = g->s2[k] = 0;
+   }
+   g->cnt = 0;
+   return 1;
+}
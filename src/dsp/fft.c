@@ -22,6 +22,9 @@
  *
  */
 #include <dsp/fft.h>
+#ifdef TBX_SIMD_X86
+#include <immintrin.h>
+#endif
 
 /*
  * Static functions
@@ -30,6 +33,12 @@
 static void _bit_reverse_c (complex_d_t *x, complex_d_t *r, uint32_t n) __O3__;
 static void _bit_reverse_cf (complex_f_t *x, complex_f_t *r, uint32_t n) __O3__ ;
 static void _bit_reverse_ci (complex_i_t *x, complex_f_t *r, uint32_t n) __O3__ ;
+static void _bit_reverse_blk_c (complex_d_t *x, complex_d_t *r, uint32_t n) __O3__;
+static void _bit_reverse_blk_cf (complex_f_t *x, complex_f_t *r, uint32_t n) __O3__ ;
+static void _bit_reverse_blk_ci (complex_i_t *x, complex_f_t *r, uint32_t n) __O3__ ;
+#ifdef TBX_SIMD_X86
+static void _fft_stages_simd_cf (fft_plan_t *p, complex_f_t *x, uint32_t n) __O3__ ;
+#endif
 
 
 /*!
@@ -56,6 +65,90 @@ static void _bit_reverse_ci (complex_i_t *x, complex_f_t *r, uint32_t n) __O3__
    r[0] = (_t)x[0]; r[n-1] = (_t)x[n-1];        \
 }
 
+/*!
+ * Block size of the cache blocked bit reversal, in bits.
+ */
+#define  _FFT_BRB_BITS     (4)
+#define  _FFT_BRB          (1UL << _FFT_BRB_BITS)
+
+/*!
+ * Bit reversal of the _FFT_BRB_BITS block indexes
+ */
+static const uint8_t _brb_rev[_FFT_BRB] = {
+   0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15
+};
+
+/*!
+ * \brief
+ *    Reverse the lower b bits of x
+ */
+static uint32_t _rev_bits (uint32_t x, uint32_t b) {
+   uint32_t r;
+   for (r=0 ; b ; --b, x>>=1)
+      r = (r<<1) | (x & 1);
+   return r;
+}
+
+/*!
+ * \brief
+ *    The main body of the cache blocked (COBRA) bit reversal algorithm.
+ *
+ *    Each index is split as i = [a | c | d], with a and d of _FFT_BRB_BITS.
+ *    so rev(i) = [rev(d) | rev(c) | rev(a)]. For each pair of middle parts
+ *    c, rev(c) a _FFT_BRB x _FFT_BRB tile is read in contiguous rows of
+ *    _FFT_BRB points, and written back to the pair's place again in
+ *    contiguous rows. The two tiles are buffered before writing, so the
+ *    algorithm works both in-place and not in-place.
+ *
+ * \param   _t    The type for the conversion
+ */
+#define _bit_reverse_blk_body(_t)                     \
+{                                                     \
+   _t b0[_FFT_BRB*_FFT_BRB], b1[_FFT_BRB*_FFT_BRB];   \
+   uint32_t a, c, cr, d, mc, sh;                      \
+                                                      \
+   mc = _log2(n) - 2*_FFT_BRB_BITS;                   \
+   sh = _log2(n) - _FFT_BRB_BITS;                     \
+   for (c=0 ; c < (1UL<<mc) ; ++c) {                  \
+      if ((cr = _rev_bits (c, mc)) < c)               \
+         continue;   /* pair already done */          \
+      /* Read the tile(s) with type conversion */     \
+      for (a=0 ; a<_FFT_BRB ; ++a)                    \
+         for (d=0 ; d<_FFT_BRB ; ++d) {               \
+            b0[_brb_rev[a]*_FFT_BRB + d] = (_t)x[(a<<sh) | (c<<_FFT_BRB_BITS) | d];  \
+            b1[_brb_rev[a]*_FFT_BRB + d] = (_t)x[(a<<sh) | (cr<<_FFT_BRB_BITS) | d]; \
+         }                                            \
+      /* Write them to their pair's place */          \
+      for (d=0 ; d<_FFT_BRB ; ++d)                    \
+         for (a=0 ; a<_FFT_BRB ; ++a) {               \
+            r[(d<<sh) | (cr<<_FFT_BRB_BITS) | a] = b0[a*_FFT_BRB + _brb_rev[d]];  \
+            r[(d<<sh) | (c<<_FFT_BRB_BITS) | a] = b1[a*_FFT_BRB + _brb_rev[d]];   \
+         }                                            \
+   }                                                  \
+}
+
+/*!
+ * \brief
+ *    Cache blocked bit reversal shorting algorithm for large transforms.
+ *    Every exchange in the classic algorithm is a cache miss for large n.
+ *    This one moves whole cache lines instead.
+ *    - Not in-place.   Use pointers to different arrays for input and output
+ *    - In-place        Use the same pointer for input and output
+ *
+ * \param   x     Pointer to input signal
+ * \param   r     Pointer to output signal
+ * \param   n     Number of points. Must be at least 2^(2*_FFT_BRB_BITS)
+ */
+static void _bit_reverse_blk_c (complex_d_t *x, complex_d_t *r, uint32_t n) {
+   _bit_reverse_blk_body (complex_d_t);
+}
+static void _bit_reverse_blk_cf (complex_f_t *x, complex_f_t *r, uint32_t n) {
+   _bit_reverse_blk_body (complex_f_t);
+}
+static void _bit_reverse_blk_ci (complex_i_t *x, complex_f_t *r, uint32_t n) {
+   _bit_reverse_blk_body (complex_f_t);
+}
+
 /*!
  * \brief
  *    Bit reversal shorting algorithm using double precision
@@ -70,7 +163,10 @@ static void _bit_reverse_ci (complex_i_t *x, complex_f_t *r, uint32_t n) __O3__
  */
 static void _bit_reverse_c (complex_d_t *x, complex_d_t *r, uint32_t n) {
    complex_d_t tmp;
-   _bit_reverse_body(complex_d_t);
+   if (n >= FFT_BITREV_BLOCKED_N)
+      _bit_reverse_blk_c (x, r, n);
+   else
+      _bit_reverse_body(complex_d_t);
 }
 
 /*!
@@ -87,7 +183,10 @@ static void _bit_reverse_c (complex_d_t *x, complex_d_t *r, uint32_t n) {
  */
 static void _bit_reverse_cf (complex_f_t *x, complex_f_t *r, uint32_t n) {
    complex_f_t tmp;
-   _bit_reverse_body(complex_f_t);
+   if (n >= FFT_BITREV_BLOCKED_N)
+      _bit_reverse_blk_cf (x, r, n);
+   else
+      _bit_reverse_body(complex_f_t);
 }
 
 
@@ -105,7 +204,10 @@ static void _bit_reverse_cf (complex_f_t *x, complex_f_t *r, uint32_t n) {
  */
 static void _bit_reverse_ci (complex_i_t *x, complex_f_t *r, uint32_t n) {
    complex_f_t tmp;
-   _bit_reverse_body(complex_f_t);
+   if (n >= FFT_BITREV_BLOCKED_N)
+      _bit_reverse_blk_ci (x, r, n);
+   else
+      _bit_reverse_body(complex_f_t);
 }
 
 /*!
@@ -134,21 +236,363 @@ static void _bit_reverse_ci (complex_i_t *x, complex_f_t *r, uint32_t n) {
 
 /*!
  * \brief
- *    The main body of fft
+ *    The first radix-2 stage of 2 point sub-DFTs. All twiddle factors are 1.
+ *    Used as the tail stage when log2(n) is odd.
+ */
+#define  _fft_loop_r2_first(_x, _n)       \
+{                                         \
+   for (i=0 ; i<_n ; i+=2) {              \
+      t = _x[i+1];                        \
+      _x[i+1] = _x[i]-t;                  \
+      _x[i] += t;                         \
+   }                                      \
+}
+
+/*!
+ * \brief
+ *    Radix-4 decimation in time butterfly. It merges the four q point
+ *    sub-DFTs at _a, _a+q, _a+2q, _a+3q produced by the bit reversal,
+ *    (the 0, 2, 1, 3 mod 4 points) into one 4q point DFT.
+ *    Expects the twiddled inputs in a0..a3. The -j multiplication is
+ *    done by swapping real and imaginary parts.
+ */
+#define  _fft_bfly_r4(_x, _a, _q, _r, _i) \
+{                                         \
+   t0 = a0 + a2;                          \
+   t1 = a0 - a2;                          \
+   t2 = a1 + a3;                          \
+   t = a1 - a3;                           \
+   t3 = _i(t) - I*_r(t);   /* -j(a1-a3) */\
+   _x[_a]        = t0 + t2;               \
+   _x[_a+(_q)]   = t1 + t3;               \
+   _x[_a+2*(_q)] = t0 - t2;               \
+   _x[_a+3*(_q)] = t1 - t3;               \
+}
+
+/*!
+ * \brief
+ *    Load the radix-4 butterfly inputs
+ *    - _fft_load_r4_0  for the twiddle free butterfly (j=0)
+ *    - _fft_load_r4    using w1, w2, w3 twiddles
+ */
+#define  _fft_load_r4_0(_x, _a, _q)       \
+{                                         \
+   a0 = _x[_a];                           \
+   a2 = _x[_a+(_q)];                      \
+   a1 = _x[_a+2*(_q)];                    \
+   a3 = _x[_a+3*(_q)];                    \
+}
+#define  _fft_load_r4(_x, _a, _q)         \
+{                                         \
+   a0 = _x[_a];                           \
+   a2 = _x[_a+(_q)]*w2;                   \
+   a1 = _x[_a+2*(_q)]*w1;                 \
+   a3 = _x[_a+3*(_q)]*w3;                 \
+}
+
+/*!
+ * \brief
+ *    Radix-4 stage, merging q point sub-DFTs into 4q point DFTs.
+ *    Twiddle factors are calculated recursively once for each butterfly
+ *    column and used for all the sub-DFTs.
+ */
+#define  _fft_loop_r4(_x, _n, _q, _r, _i) \
+{                                         \
+   le = (_q)<<2;                          \
+   th = M_2PI/le;                         \
+   s = cos (th) - I*sin (th);             \
+   /* Twiddle free butterflies */         \
+   for (i=0 ; i<_n ; i+=le) {             \
+      _fft_load_r4_0 (_x, i, _q);         \
+      _fft_bfly_r4 (_x, i, _q, _r, _i);   \
+   }                                      \
+   /* Loop each butterfly column */       \
+   for (w1=s, j=1 ; j<(_q) ; ++j) {       \
+      w2 = w1*w1;                         \
+      w3 = w2*w1;                         \
+      for (i=j ; i<_n ; i+=le) {          \
+         _fft_load_r4 (_x, i, _q);        \
+         _fft_bfly_r4 (_x, i, _q, _r, _i);\
+      }                                   \
+      w1 *= s;                            \
+   }                                      \
+}
+
+/*!
+ * \brief
+ *    Radix-4 stage using the plan's twiddle table. The twiddle factors
+ *    for the j-th butterfly of a 4q point sub-DFT are w[r*j*N/4q], r:[1..3].
+ *    Each sub-DFT is processed in turn, so the data are accessed linearly.
+ */
+#define  _fft_loop_r4_tbl(_x, _n, _q, _w, _r, _i)  \
+{                                         \
+   le = (_q)<<2;                          \
+   st = p->n / le;                        \
+   /* Loop each sub-DFT  */               \
+   for (i=0 ; i<_n ; i+=le) {             \
+      /* Twiddle free butterfly */        \
+      _fft_load_r4_0 (_x, i, _q);         \
+      _fft_bfly_r4 (_x, i, _q, _r, _i);   \
+      /* Loop each Butterfly */           \
+      for (j=i+1, tw=st ; j<i+(_q) ; ++j, tw+=st) { \
+         w1 = _w[tw];                     \
+         w2 = _w[2*tw];                   \
+         w3 = _w[3*tw];                   \
+         _fft_load_r4 (_x, j, _q);        \
+         _fft_bfly_r4 (_x, j, _q, _r, _i);\
+      }                                   \
+   }                                      \
+}
+
+/*!
+ * \brief
+ *    The fft frequency domain synthesis stages. Radix-4 stages with
+ *    a radix-2 first stage if log2(n) is odd.
+ *    - _fft_stages     calculates the twiddle factors recursively
+ *    - _fftp_stages    uses the twiddle table _w of plan p
  */
-#define _fft_body(_type, _reverse) {            \
-   uint32_t i, j, l, m;    /* Loop counters */  \
-   uint32_t k, le, le_2;   /* butterfly loop */ \
-   _type w, s, t;                         \
+#define  _fft_stages(_type, _x, _n, _r, _i)  {  \
+   uint32_t i, j, q;       /* Loop counters */  \
+   uint32_t le;            /* butterfly loop */ \
+   _type s, t, w1, w2, w3;                      \
+   _type a0, a1, a2, a3, t0, t1, t2, t3;        \
    double th;  /* Always double like sin/cos */ \
                                                 \
+   q = 1;                                       \
+   if (_log2(_n) & 1) {                         \
+      _fft_loop_r2_first (_x, _n);              \
+      q = 2;                                    \
+   }                                            \
+   for ( ; (q<<2) <= (_n) ; q<<=2)              \
+      _fft_loop_r4 (_x, _n, q, _r, _i);         \
+}
+
+#define  _fftp_stages(_type, _x, _n, _w, _r, _i)  { \
+   uint32_t i, j, q;       /* Loop counters */  \
+   uint32_t le;            /* butterfly loop */ \
+   uint32_t st, tw;        /* twiddle stride */ \
+   _type t, w1, w2, w3;                         \
+   _type a0, a1, a2, a3, t0, t1, t2, t3;        \
+                                                \
+   q = 1;                                       \
+   if (_log2(_n) & 1) {                         \
+      _fft_loop_r2_first (_x, _n);              \
+      q = 2;                                    \
+   }                                            \
+   for ( ; (q<<2) <= (_n) ; q<<=2)              \
+      _fft_loop_r4_tbl (_x, _n, q, _w, _r, _i); \
+}
+
+#ifdef TBX_SIMD_X86
+/*
+ * ============ x86 SIMD kernels ============
+ */
+
+/*!
+ * Twiddle factors chunk size for the SIMD stages.
+ */
+#define  _FFT_SIMD_CHUNK      (64)
+
+/*!
+ * Single precision radix-4 butterfly kernel.
+ * Runs cnt consecutive butterflies on x[j], x[j+q], x[j+2q], x[j+3q]
+ * using the contiguous twiddle factors w1[j], w2[j], w3[j].
+ */
+typedef void (*_fft_r4_cf_pt) (complex_f_t *x, uint32_t q,
+                               complex_f_t *w1, complex_f_t *w2, complex_f_t *w3, uint32_t cnt);
+
+static void _fft_r4_cf_scalar (complex_f_t *x, uint32_t q,
+                               complex_f_t *w1, complex_f_t *w2, complex_f_t *w3, uint32_t cnt) {
+   uint32_t j;
+   complex_f_t t, a0, a1, a2, a3, t0, t1, t2, t3;
+
+   for (j=0 ; j<cnt ; ++j) {
+      a0 = x[j];
+      a2 = x[j+q]*w2[j];
+      a1 = x[j+2*q]*w1[j];
+      a3 = x[j+3*q]*w3[j];
+      _fft_bfly_r4 (x, j, q, realf, imagf);
+   }
+}
+
+/*!
+ * \brief
+ *    Complex multiplication of two interleaved complex pairs
+ *    {re0, im0, re1, im1} using SSE2
+ */
+__target_sse2__ static inline __m128 _cmul_sse2 (__m128 a, __m128 b) {
+   const __m128 neg_re = _mm_castsi128_ps (_mm_set_epi32 (0, 0x80000000, 0, 0x80000000));
+   __m128 br = _mm_shuffle_ps (b, b, _MM_SHUFFLE (2,2,0,0));
+   __m128 bi = _mm_shuffle_ps (b, b, _MM_SHUFFLE (3,3,1,1));
+   __m128 as = _mm_shuffle_ps (a, a, _MM_SHUFFLE (2,3,0,1));
+   return _mm_add_ps (_mm_mul_ps (a, br), _mm_xor_ps (_mm_mul_ps (as, bi), neg_re));
+}
+
+__target_sse2__ static void _fft_r4_cf_sse2 (complex_f_t *x, uint32_t q,
+                                             complex_f_t *w1, complex_f_t *w2, complex_f_t *w3, uint32_t cnt) {
+   const __m128 neg_im = _mm_castsi128_ps (_mm_set_epi32 (0x80000000, 0, 0x80000000, 0));
+   __m128 a0, a1, a2, a3, t0, t1, t2, t3;
+   uint32_t j;
+
+   for (j=0 ; j+2<=cnt ; j+=2) {
+      a0 = _mm_loadu_ps ((float*)&x[j]);
+      a2 = _cmul_sse2 (_mm_loadu_ps ((float*)&x[j+q]), _mm_loadu_ps ((float*)&w2[j]));
+      a1 = _cmul_sse2 (_mm_loadu_ps ((float*)&x[j+2*q]), _mm_loadu_ps ((float*)&w1[j]));
+      a3 = _cmul_sse2 (_mm_loadu_ps ((float*)&x[j+3*q]), _mm_loadu_ps ((float*)&w3[j]));
+      t0 = _mm_add_ps (a0, a2);
+      t1 = _mm_sub_ps (a0, a2);
+      t2 = _mm_add_ps (a1, a3);
+      t3 = _mm_sub_ps (a1, a3);
+      t3 = _mm_xor_ps (_mm_shuffle_ps (t3, t3, _MM_SHUFFLE (2,3,0,1)), neg_im);  // -j(a1-a3)
+      _mm_storeu_ps ((float*)&x[j],     _mm_add_ps (t0, t2));
+      _mm_storeu_ps ((float*)&x[j+q],   _mm_add_ps (t1, t3));
+      _mm_storeu_ps ((float*)&x[j+2*q], _mm_sub_ps (t0, t2));
+      _mm_storeu_ps ((float*)&x[j+3*q], _mm_sub_ps (t1, t3));
+   }
+   if (j<cnt)
+      _fft_r4_cf_scalar (&x[j], q, &w1[j], &w2[j], &w3[j], cnt-j);
+}
+
+/*!
+ * \brief
+ *    Complex multiplication of four interleaved complex numbers using AVX
+ */
+__target_avx2__ static inline __m256 _cmul_avx2 (__m256 a, __m256 b) {
+   __m256 br = _mm256_moveldup_ps (b);
+   __m256 bi = _mm256_movehdup_ps (b);
+   __m256 as = _mm256_permute_ps (a, _MM_SHUFFLE (2,3,0,1));
+   return _mm256_addsub_ps (_mm256_mul_ps (a, br), _mm256_mul_ps (as, bi));
+}
+
+__target_avx2__ static void _fft_r4_cf_avx2 (complex_f_t *x, uint32_t q,
+                                             complex_f_t *w1, complex_f_t *w2, complex_f_t *w3, uint32_t cnt) {
+   const __m256 neg_im = _mm256_castsi256_ps (_mm256_set_epi32 (0x80000000, 0, 0x80000000, 0,
+                                                                0x80000000, 0, 0x80000000, 0));
+   __m256 a0, a1, a2, a3, t0, t1, t2, t3;
+   uint32_t j;
+
+   for (j=0 ; j+4<=cnt ; j+=4) {
+      a0 = _mm256_loadu_ps ((float*)&x[j]);
+      a2 = _cmul_avx2 (_mm256_loadu_ps ((float*)&x[j+q]), _mm256_loadu_ps ((float*)&w2[j]));
+      a1 = _cmul_avx2 (_mm256_loadu_ps ((float*)&x[j+2*q]), _mm256_loadu_ps ((float*)&w1[j]));
+      a3 = _cmul_avx2 (_mm256_loadu_ps ((float*)&x[j+3*q]), _mm256_loadu_ps ((float*)&w3[j]));
+      t0 = _mm256_add_ps (a0, a2);
+      t1 = _mm256_sub_ps (a0, a2);
+      t2 = _mm256_add_ps (a1, a3);
+      t3 = _mm256_sub_ps (a1, a3);
+      t3 = _mm256_xor_ps (_mm256_permute_ps (t3, _MM_SHUFFLE (2,3,0,1)), neg_im);  // -j(a1-a3)
+      _mm256_storeu_ps ((float*)&x[j],     _mm256_add_ps (t0, t2));
+      _mm256_storeu_ps ((float*)&x[j+q],   _mm256_add_ps (t1, t3));
+      _mm256_storeu_ps ((float*)&x[j+2*q], _mm256_sub_ps (t0, t2));
+      _mm256_storeu_ps ((float*)&x[j+3*q], _mm256_sub_ps (t1, t3));
+   }
+   if (j<cnt)
+      _fft_r4_cf_scalar (&x[j], q, &w1[j], &w2[j], &w3[j], cnt-j);
+}
+
+static const _fft_r4_cf_pt _fft_r4_cf[] = TBX_ISA_KRN (_fft_r4_cf);
+
+/*!
+ * \brief
+ *    Single precision fft stages using the SIMD kernels.
+ *    The first (q<4) stage is scalar. For the rest, the twiddle factors
+ *    of each stage are gathered in contiguous chunks, either from the plan
+ *    or recursively (in double precision), and applied to all sub-DFTs.
+ *
+ * \param   p     Pointer to plan, or NULL for recursive twiddle factors
+ * \param   x     Pointer to the bit reversed data
+ * \param   n     Number of points
+ */
+static void _fft_stages_simd_cf (fft_plan_t *p, complex_f_t *x, uint32_t n)
+{
+   complex_f_t tw1[_FFT_SIMD_CHUNK], tw2[_FFT_SIMD_CHUNK], tw3[_FFT_SIMD_CHUNK];
+   complex_f_t t, w1, w2, w3;
+   complex_f_t a0, a1, a2, a3, t0, t1, t2, t3;
+   complex_d_t s, w=1;
+   uint32_t i, j, j0, k, q, le, cnt, st=0, tw;
+   double th;
+
+   // First stage
+   q = 1;
+   if (_log2(n) & 1) {
+      _fft_loop_r2_first (x, n);
+      q = 2;
+   }
+   if ((q<<2) <= n) {
+      if (p) {
+         _fft_loop_r4_tbl (x, n, q, p->wf, realf, imagf);
+      }
+      else {
+         _fft_loop_r4 (x, n, q, realf, imagf);
+      }
+      q <<= 2;
+   }
+   // SIMD stages
+   for ( ; (q<<2) <= n ; q<<=2) {
+      le = q<<2;
+      if (p)
+         st = p->n / le;
+      else {
+         th = M_2PI/le;
+         s = cos (th) - I*sin (th);
+         w = 1;
+      }
+      for (j0=0 ; j0<q ; j0+=cnt) {
+         cnt = (q-j0 < _FFT_SIMD_CHUNK) ? q-j0 : _FFT_SIMD_CHUNK;
+         for (j=0 ; j<cnt ; ++j) {
+            if (p) {
+               k = (j0+j)*st;
+               tw1[j] = p->wf[k];
+               tw2[j] = p->wf[2*k];
+               tw3[j] = p->wf[3*k];
+            }
+            else {
+               tw1[j] = (complex_f_t)w;
+               tw2[j] = (complex_f_t)(w*w);
+               tw3[j] = (complex_f_t)(w*w*w);
+               w *= s;
+            }
+         }
+         for (i=j0 ; i<n ; i+=le)
+            _fft_r4_cf[tbx_isa ()] (&x[i], q, tw1, tw2, tw3, cnt);
+      }
+   }
+}
+
+#define  _fft_stages_cf(_x, _n)     _fft_stages_simd_cf (NULL, _x, _n)
+#define  _fftp_stages_cf(_x, _n)    _fft_stages_simd_cf (p, _x, _n)
+#else
+#define  _fft_stages_cf(_x, _n)     _fft_stages (complex_f_t, _x, _n, realf, imagf)
+#define  _fftp_stages_cf(_x, _n)    _fftp_stages (complex_f_t, _x, _n, p->wf, realf, imagf)
+#endif   // #ifdef TBX_SIMD_X86
+
+#define  _fft_stages_c(_x, _n)      _fft_stages (complex_d_t, _x, _n, real, imag)
+#define  _fftp_stages_c(_x, _n)     _fftp_stages (complex_d_t, _x, _n, p->w, real, imag)
+
+/*!
+ * \brief
+ *    The main body of fft
+ */
+#define _fft_body(_reverse, _stages) {          \
    /* Bit reversal */                           \
-   _reverse (x, X, n);                    \
+   _reverse (x, X, n);                          \
                                                 \
    /* Loop for each stage */                    \
-   m = _log2(n);                                \
-   for (l=1 ; l<=m ; ++l)                       \
-      _fft_loop_cmplx (X, n, l);                \
+   _stages (X, n);                              \
+}
+
+/*!
+ * \brief
+ *    Transform of a non power of 2 number of points, using a temporary
+ *    plan. Nothing is calculated if the plan allocation fails.
+ */
+#define _fft_any(_fftp, _in, _out) {            \
+   fft_plan_t p;                                \
+                                                \
+   if (fft_plan_init (&p, n)) {                 \
+      _fftp (&p, _in, _out);                    \
+      fft_plan_deinit (&p);                     \
+   }                                            \
 }
 
 /*!
@@ -210,7 +654,12 @@ static void _bit_reverse_ci (complex_i_t *x, complex_f_t *r, uint32_t n) {
  * \return        None
  */
 void fft_c (complex_d_t *x, complex_d_t *X, uint32_t n) {
-   _fft_body (complex_d_t, _bit_reverse_c);
+   if (n & (n-1)) {
+      _fft_any (fftp_c, x, X);
+   }
+   else {
+      _fft_body (_bit_reverse_c, _fft_stages_c);
+   }
 }
 
 /*!
@@ -229,7 +678,12 @@ void fft_c (complex_d_t *x, complex_d_t *X, uint32_t n) {
  * \return        None
  */
 void fft_cf (complex_f_t *x, complex_f_t *X, uint32_t n) {
-   _fft_body (complex_f_t, _bit_reverse_cf);
+   if (n & (n-1)) {
+      _fft_any (fftp_cf, x, X);
+   }
+   else {
+      _fft_body (_bit_reverse_cf, _fft_stages_cf);
+   }
 }
 
 /*!
@@ -248,7 +702,12 @@ void fft_cf (complex_f_t *x, complex_f_t *X, uint32_t n) {
  * \return        None
  */
 void fft_ci (complex_i_t *x, complex_f_t *X, uint32_t n) {
-   _fft_body (complex_f_t, _bit_reverse_ci);
+   if (n & (n-1)) {
+      _fft_any (fftp_ci, x, X);
+   }
+   else {
+      _fft_body (_bit_reverse_ci, _fft_stages_cf);
+   }
 }
 
 /*!
@@ -276,7 +735,12 @@ void fft_ci (complex_i_t *x, complex_f_t *X, uint32_t n) {
  * \return        None
  */
 void fft_r (double *x, complex_d_t *X, uint32_t n) {
-   _fft_r_body (complex_d_t, complex_d_t, fft_c, real, imag);
+   if (n & (n-1)) {
+      _fft_any (fftp_r, x, X);
+   }
+   else {
+      _fft_r_body (complex_d_t, complex_d_t, fft_c, real, imag);
+   }
 }
 
 /*!
@@ -304,7 +768,12 @@ void fft_r (double *x, complex_d_t *X, uint32_t n) {
  * \return        None
  */
 void fft_rf (float *x, complex_f_t *X, uint32_t n) {
-   _fft_r_body (complex_f_t, complex_f_t, fft_cf, realf, imagf);
+   if (n & (n-1)) {
+      _fft_any (fftp_rf, x, X);
+   }
+   else {
+      _fft_r_body (complex_f_t, complex_f_t, fft_cf, realf, imagf);
+   }
 }
 
 /*!
@@ -332,18 +801,20 @@ void fft_rf (float *x, complex_f_t *X, uint32_t n) {
  * \return        None
  */
 void fft_ri (int *x, complex_f_t *X, uint32_t n) {
-   _fft_r_body (complex_i_t, complex_f_t, fft_ci, realf, imagf);
+   if (n & (n-1)) {
+      _fft_any (fftp_ri, x, X);
+   }
+   else {
+      _fft_r_body (complex_i_t, complex_f_t, fft_ci, realf, imagf);
+   }
 }
 
 /*!
  * \brief
  *    Inverse fft main body
  */
-#define _ifft_body(_type, _reverse, _i, _c) {  \
-   uint32_t i, j, l, m;    /* Loop counters */  \
-   uint32_t k, le, le_2;   /* butterfly loop */ \
-   _type w, s, t;                         \
-   double th;  /* Always double like sin/cos*/  \
+#define _ifft_body(_reverse, _stages, _i, _c) { \
+   uint32_t i;             /* Loop counter */   \
                                                 \
    _reverse (X, x, n);  /* Bit reversal */      \
                                                 \
@@ -352,9 +823,7 @@ void fft_ri (int *x, complex_f_t *X, uint32_t n) {
    _i(x[i]) = -_i(x[i]);                 \
                                                 \
    /* Loop for each stage */                    \
-   m = _log2(n);                                \
-   for (l=1 ; l<=m ; ++l)                       \
-      _fft_loop_cmplx (x, n, l);                \
+   _stages (x, n);                              \
                                                 \
    /* Take the conjugate and scale by n */      \
    for (i=0 ; i<n ; ++i)                        \
@@ -399,7 +868,12 @@ void fft_ri (int *x, complex_f_t *X, uint32_t n) {
  * \return        None
  */
 void ifft_c (complex_d_t *X, complex_d_t *x, uint32_t n) {
-   _ifft_body (complex_d_t, _bit_reverse_c, imag, conj);
+   if (n & (n-1)) {
+      _fft_any (ifftp_c, X, x);
+   }
+   else {
+      _ifft_body (_bit_reverse_c, _fft_stages_c, imag, conj);
+   }
 }
 
 /*
@@ -418,7 +892,12 @@ void ifft_c (complex_d_t *X, complex_d_t *x, uint32_t n) {
  * \return        None
  */
 void ifft_cf (complex_f_t *X, complex_f_t *x, uint32_t n) {
-   _ifft_body (complex_f_t, _bit_reverse_cf, imagf, conjf);
+   if (n & (n-1)) {
+      _fft_any (ifftp_cf, X, x);
+   }
+   else {
+      _ifft_body (_bit_reverse_cf, _fft_stages_cf, imagf, conjf);
+   }
 }
 
 /*!
@@ -479,3 +958,1583 @@ void ifft_rf (complex_f_t *X, float *x, uint32_t n) {
    _ifft_r_body (complex_f_t, fft_rf, realf, imagf);
 }
 
+
+
+/*
+ * ============ FFT plan ============
+ */
+
+/*!
+ * \brief
+ *    The main body of table driven bit reversal algorithm.
+ *    A plan of N points serves also the n = N/2^s point transforms
+ *    as rev_(m-s)(i) = rev_m(i) >> s, for i < n.
+ * \param   _t    The type for the conversion
+ */
+#define _bit_reverse_tbl_body(_t)               \
+{                                               \
+   uint32_t i, j, s;                            \
+   s = p->m - _log2(n);                         \
+   for (i=0 ; i<n ; ++i) {                      \
+      /* point exchange and type conversion */  \
+      if (i <= (j = p->r[i]>>s)) {              \
+         tmp = (_t)x[i];                        \
+         X[i] = (_t)x[j];                       \
+         X[j] = tmp;                            \
+      }                                         \
+   }                                            \
+}
+
+static void _bit_reverse_tbl_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X, uint32_t n) {
+   complex_d_t tmp;
+   if (n >= FFT_BITREV_BLOCKED_N)
+      _bit_reverse_blk_c (x, X, n);
+   else
+      _bit_reverse_tbl_body(complex_d_t);
+}
+static void _bit_reverse_tbl_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X, uint32_t n) {
+   complex_f_t tmp;
+   if (n >= FFT_BITREV_BLOCKED_N)
+      _bit_reverse_blk_cf (x, X, n);
+   else
+      _bit_reverse_tbl_body(complex_f_t);
+}
+static void _bit_reverse_tbl_ci (fft_plan_t *p, complex_i_t *x, complex_f_t *X, uint32_t n) {
+   complex_f_t tmp;
+   if (n >= FFT_BITREV_BLOCKED_N)
+      _bit_reverse_blk_ci (x, X, n);
+   else
+      _bit_reverse_tbl_body(complex_f_t);
+}
+
+/*!
+ * \brief
+ *    The main body of fft frequency domain synthesis algorithm
+ *    using the plan's twiddle table. The twiddle factor for the j-th
+ *    butterfly of a le point sub-DFT is w[j*N/le].
+ *    Each sub-DFT is processed in turn, so the data are accessed linearly.
+ */
+#define  _fft_loop_tbl(_x, _n, _l, _w)    \
+{                                         \
+   le = 1UL << (_l);                      \
+   le_2 = le>>1;                          \
+   st = p->n >> (_l);                     \
+   /* Loop each sub-DFT  */               \
+   for (i=0 ; i<_n ; i+=le) {             \
+      /* Loop each Butterfly */           \
+      for (j=i, k=i+le_2, tw=0 ; j<i+le_2 ; ++j, ++k, tw+=st) { \
+         t = _x[k]*_w[tw];                \
+         _x[k] = _x[j]-t;                 \
+         _x[j] += t;                      \
+      }                                   \
+   }                                      \
+}
+
+/*!
+ * \brief
+ *    The main body of fft using plan
+ */
+#define _fftp_body(_reverse, _stages) {         \
+   /* Bit reversal */                           \
+   _reverse (p, x, X, n);                       \
+                                                \
+   /* Loop for each stage */                    \
+   _stages (X, n);                              \
+}
+
+/*
+ * ============ Mixed radix and Bluestein ============
+ */
+
+/*!
+ * \brief
+ *    Mixed radix decimation in time butterflies (radix 2, 3, 4 and 5).
+ *    Each one merges the r sub-DFTs of m points at _X, _X+m, .., _X+(r-1)m
+ *    into one DFT of r*m points. The twiddle factor e^(-j2pik/(r*m)) is
+ *    the _w[k*fs] of a n point table.
+ */
+#define  _fft_mr_bfly2(_X, _fs, _m, _w)            \
+{                                                  \
+   for (k=0 ; k<(_m) ; ++k) {                      \
+      t = _X[(_m)+k] * _w[k*(_fs)];                \
+      _X[(_m)+k] = _X[k] - t;                      \
+      _X[k] += t;                                  \
+   }                                               \
+}
+
+#define  _fft_mr_bfly3(_X, _fs, _m, _w, _r, _i)    \
+{                                                  \
+   e3 = _w[(_fs)*(_m)];    /* e^(-j2pi/3) */       \
+   for (k=0 ; k<(_m) ; ++k) {                      \
+      s1 = _X[(_m)+k] * _w[k*(_fs)];               \
+      s2 = _X[2*(_m)+k] * _w[2*k*(_fs)];           \
+      s3 = s1 + s2;                                \
+      s0 = (s1 - s2) * _i(e3);                     \
+      _X[(_m)+k] = _X[k] - s3/2;                   \
+      _X[k] += s3;                                 \
+      t = _i(s0) - I*_r(s0);  /* -j s0 */          \
+      _X[2*(_m)+k] = _X[(_m)+k] + t;               \
+      _X[(_m)+k] -= t;                             \
+   }                                               \
+}
+
+#define  _fft_mr_bfly4(_X, _fs, _m, _w, _r, _i)    \
+{                                                  \
+   for (k=0 ; k<(_m) ; ++k) {                      \
+      s0 = _X[(_m)+k] * _w[k*(_fs)];               \
+      s1 = _X[2*(_m)+k] * _w[2*k*(_fs)];           \
+      s2 = _X[3*(_m)+k] * _w[3*k*(_fs)];           \
+      s5 = _X[k] - s1;                             \
+      _X[k] += s1;                                 \
+      s3 = s0 + s2;                                \
+      s4 = s0 - s2;                                \
+      _X[2*(_m)+k] = _X[k] - s3;                   \
+      _X[k] += s3;                                 \
+      t = _i(s4) - I*_r(s4);  /* -j s4 */          \
+      _X[(_m)+k] = s5 + t;                         \
+      _X[3*(_m)+k] = s5 - t;                       \
+   }                                               \
+}
+
+#define  _fft_mr_bfly5(_X, _fs, _m, _w, _r, _i)    \
+{                                                  \
+   ya = _w[(_fs)*(_m)];    /* e^(-j2pi/5) */       \
+   yb = _w[2*(_fs)*(_m)];  /* e^(-j4pi/5) */       \
+   for (k=0 ; k<(_m) ; ++k) {                      \
+      s0 = _X[k];                                  \
+      s1 = _X[(_m)+k] * _w[k*(_fs)];               \
+      s2 = _X[2*(_m)+k] * _w[2*k*(_fs)];           \
+      s3 = _X[3*(_m)+k] * _w[3*k*(_fs)];           \
+      s4 = _X[4*(_m)+k] * _w[4*k*(_fs)];           \
+      s7 = s1 + s4;                                \
+      s10 = s1 - s4;                               \
+      s8 = s2 + s3;                                \
+      s9 = s2 - s3;                                \
+      _X[k] = s0 + s7 + s8;                        \
+      s5 = s0 + s7*_r(ya) + s8*_r(yb);             \
+      t = s10*_i(ya) + s9*_i(yb);                  \
+      s6 = _i(t) - I*_r(t);   /* -j t */           \
+      _X[(_m)+k] = s5 - s6;                        \
+      _X[4*(_m)+k] = s5 + s6;                      \
+      s11 = s0 + s7*_r(yb) + s8*_r(ya);            \
+      t = s10*_i(yb) - s9*_i(ya);                  \
+      s12 = -_i(t) + I*_r(t); /* j t */            \
+      _X[2*(_m)+k] = s11 + s12;                    \
+      _X[3*(_m)+k] = s11 - s12;                    \
+   }                                               \
+}
+
+/*!
+ * \brief
+ *    The main body of the recursive mixed radix algorithm.
+ *    The input is decimated by the first radix f[0] of the remaining
+ *    f[1] points, each decimated sequence is transformed recursively
+ *    to its place in X, and the results are merged with an f[0] radix
+ *    butterfly.
+ *
+ * \param   _type    The output type
+ * \param   _work    The recursive function
+ */
+#define _fft_mr_work_body(_type, _work, _w, _r, _i)   \
+{                                                     \
+   _type *Xb = X, *Xe = X + f[0]*f[1];                \
+   _type t, e3, ya, yb;                               \
+   _type s0, s1, s2, s3, s4, s5, s6;                  \
+   _type s7, s8, s9, s10, s11, s12;                   \
+   uint32_t k, r = f[0], m = f[1];                    \
+                                                      \
+   if (m == 1) {                                      \
+      do {                                            \
+         *X = (_type)*x;                              \
+         x += fs;                                     \
+      } while (++X != Xe);                            \
+   }                                                  \
+   else {                                             \
+      do {                                            \
+         _work (p, X, x, fs*r, f+2);                  \
+         x += fs;                                     \
+      } while ((X += m) != Xe);                       \
+   }                                                  \
+   switch (r) {                                       \
+      case 2: _fft_mr_bfly2 (Xb, fs, m, _w); break;   \
+      case 3: _fft_mr_bfly3 (Xb, fs, m, _w, _r, _i); break; \
+      case 4: _fft_mr_bfly4 (Xb, fs, m, _w, _r, _i); break; \
+      case 5: _fft_mr_bfly5 (Xb, fs, m, _w, _r, _i); break; \
+   }                                                  \
+}
+
+static void _fft_mr_work_c (fft_plan_t *p, complex_d_t *X, complex_d_t *x, uint32_t fs, uint32_t *f) {
+   _fft_mr_work_body (complex_d_t, _fft_mr_work_c, p->w, real, imag);
+}
+static void _fft_mr_work_cf (fft_plan_t *p, complex_f_t *X, complex_f_t *x, uint32_t fs, uint32_t *f) {
+   _fft_mr_work_body (complex_f_t, _fft_mr_work_cf, p->wf, realf, imagf);
+}
+static void _fft_mr_work_ci (fft_plan_t *p, complex_f_t *X, complex_i_t *x, uint32_t fs, uint32_t *f) {
+   _fft_mr_work_body (complex_f_t, _fft_mr_work_ci, p->wf, realf, imagf);
+}
+
+/*!
+ * \brief
+ *    Mixed radix transforms. The algorithm is not in-place, so for in-place
+ *    calls the input is copied to the plan's scratch array first.
+ */
+static void _fftp_mr_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X) {
+   if (x == X) {
+      memcpy ((void*)p->t, (void*)x, p->n*sizeof (complex_d_t));
+      x = p->t;
+   }
+   _fft_mr_work_c (p, X, x, 1, p->f);
+}
+static void _fftp_mr_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X) {
+   if (x == X) {
+      memcpy ((void*)p->t, (void*)x, p->n*sizeof (complex_f_t));
+      x = (complex_f_t*)p->t;
+   }
+   _fft_mr_work_cf (p, X, x, 1, p->f);
+}
+static void _fftp_mr_ci (fft_plan_t *p, complex_i_t *x, complex_f_t *X) {
+   uint32_t i;
+   complex_f_t *t = (complex_f_t*)p->t;
+
+   if ((void*)x == (void*)X) {
+      for (i=0 ; i<p->n ; ++i)
+         t[i] = (complex_f_t)x[i];
+      _fft_mr_work_cf (p, X, t, 1, p->f);
+   }
+   else
+      _fft_mr_work_ci (p, X, x, 1, p->f);
+}
+
+/*!
+ * \brief
+ *    The main body of Bluestein's algorithm.
+ *    Using jk = (j^2 + k^2 - (k-j)^2)/2, the DFT becomes
+ *       X[k] = c[k] * Sum { (x[j]*c[j]) * c'[k-j] },   c[k] = e^(-jpik^2/n)
+ *    a convolution with the conjugate chirp, calculated with the inner
+ *    power of 2 plan. The calculations are always in double precision.
+ */
+#define _fftp_blu_body() {                            \
+   uint32_t j, n = p->n, M = p->bp->n;                \
+   complex_d_t *t = p->t;                             \
+                                                      \
+   for (j=0 ; j<n ; ++j)                              \
+      t[j] = x[j] * p->w[j];                          \
+   for ( ; j<M ; ++j)                                 \
+      t[j] = 0;                                       \
+   fftp_c (p->bp, t, t);                              \
+   for (j=0 ; j<M ; ++j)                              \
+      t[j] *= p->k[j];                                \
+   ifftp_c (p->bp, t, t);                             \
+   for (j=0 ; j<n ; ++j)                              \
+      X[j] = t[j] * p->w[j];                          \
+}
+
+static void _fftp_blu_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X) {
+   _fftp_blu_body ();
+}
+static void _fftp_blu_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X) {
+   _fftp_blu_body ();
+}
+static void _fftp_blu_ci (fft_plan_t *p, complex_i_t *x, complex_f_t *X) {
+   _fftp_blu_body ();
+}
+
+/*!
+ * \brief
+ *    Factorise n to radix 4, 2, 3 and 5 factors.
+ *
+ * \param   n     The number of points
+ * \param   f     Pointer to the radix/sub-length pairs array to fill, or NULL
+ * \return        The number of factors, 0 if n has other prime factors
+ */
+static uint32_t _factorise (uint32_t n, uint32_t *f) {
+   static const uint32_t rdx[] = { 4, 2, 3, 5 };
+   uint32_t i, nf;
+
+   for (i=nf=0 ; i<sizeof (rdx)/sizeof (rdx[0]) ; ++i) {
+      while (n % rdx[i] == 0) {
+         n /= rdx[i];
+         if (f) {
+            f[2*nf] = rdx[i];
+            f[2*nf+1] = n;
+         }
+         ++nf;
+      }
+   }
+   return (n == 1) ? nf : 0;
+}
+
+/*
+ * Plan memory sizes. Each plan takes one block, placed with arena_calloc()
+ */
+#define _plan_r2_size(_n)        ARENA_SIZE (                   \
+      3*((_n)>>2)*(sizeof (complex_d_t) + sizeof (complex_f_t)) \
+      + (_n)*sizeof (uint32_t) )
+#define _plan_mr_size(_n, _nf)   ARENA_SIZE (                   \
+      2*(_n)*sizeof (complex_d_t) + (_n)*sizeof (complex_f_t)   \
+      + 2*(_nf)*sizeof (uint32_t) )
+#define _plan_blu_size(_n, _M)   ARENA_SIZE (                   \
+      ((_n) + 2*(_M))*sizeof (complex_d_t) + sizeof (fft_plan_t) )
+#define _plan_fixed_size(_n)     ARENA_SIZE (                   \
+      ((_n)>>1)*(sizeof (complex_q31_t) + sizeof (complex_q15_t)) \
+      + (_n)*sizeof (uint32_t) )
+
+//! The inner power of 2 size of Bluestein's algorithm, M >= 2n-1
+static uint32_t _plan_blu_points (uint32_t n) {
+   uint32_t M;
+   for (M=4 ; M < 2*n-1 ; M<<=1)
+      ;
+   return M;
+}
+
+static uint32_t _plan_init (fft_plan_t *p, uint32_t n, arena_t *a);
+
+/*!
+ * \brief
+ *    Mixed radix plan initialisation, for n = 2^a * 3^b * 5^c points.
+ */
+static uint32_t _plan_mr_init (fft_plan_t *p, uint32_t n, uint32_t nf, arena_t *a)
+{
+   uint32_t i;
+   double th;
+
+   if ( (p->w = (void*)arena_calloc (a, _plan_mr_size (n, nf))) != NULL ) {
+      p->t = &p->w[n];
+      p->wf = (complex_f_t*)&p->t[n];
+      p->f = (uint32_t*)&p->wf[n];
+      p->type = FFT_MIXED_RADIX;
+      p->n = n;
+      _factorise (n, p->f);
+
+      for (i=0 ; i<n ; ++i) {
+         th = M_2PI*i/n;
+         p->w[i] = cos (th) - I*sin (th);
+         p->wf[i] = (complex_f_t)p->w[i];
+      }
+      return n;
+   }
+   else
+      return 0;
+}
+
+/*!
+ * \brief
+ *    Bluestein plan initialisation, for any number of points.
+ *    Uses an inner power of 2 plan of M >= 2n-1 points, placed in
+ *    the same memory.
+ */
+static uint32_t _plan_blu_init (fft_plan_t *p, uint32_t n, arena_t *a)
+{
+   uint32_t j, M = _plan_blu_points (n);
+   double th;
+
+   if ( (p->w = (void*)arena_calloc (a, _plan_blu_size (n, M))) != NULL ) {
+      p->t = &p->w[n];
+      p->k = &p->t[M];
+      p->bp = (fft_plan_t*)&p->k[M];
+      if (_plan_init (p->bp, M, a) == 0) {
+         p->w = NULL;
+         p->bp = NULL;
+         return 0;
+      }
+      p->type = FFT_BLUESTEIN;
+      p->n = n;
+
+      // The chirp. k^2 is taken modulo 2n to keep the angle small
+      for (j=0 ; j<n ; ++j) {
+         th = M_PI * (double)(((uint64_t)j*j) % (2*n)) / n;
+         p->w[j] = cos (th) - I*sin (th);
+      }
+      // The spectrum of the conjugate chirp filter, c'[j] for j:(-n..n)
+      p->k[0] = conj (p->w[0]);
+      for (j=1 ; j<n ; ++j)
+         p->k[j] = p->k[M-j] = conj (p->w[j]);
+      fftp_c (p->bp, p->k, p->k);
+      return n;
+   }
+   else
+      return 0;
+}
+
+/*!
+ * \brief
+ *    Plan initialisation, taking the tables from an arena.
+ */
+static uint32_t _plan_init (fft_plan_t *p, uint32_t n, arena_t *a)
+{
+   uint32_t i, nw, nf;
+   double th;
+
+   // Check number of points
+   if (n < 2)
+      return 0;
+   memset ((void*)p, 0, sizeof (fft_plan_t));
+   if (n < 4 || (n & (n-1))) {
+      if ((nf = _factorise (n, NULL)) != 0)
+         return _plan_mr_init (p, n, nf, a);
+      else
+         return _plan_blu_init (p, n, a);
+   }
+
+   // Try to allocate all tables in one block
+   nw = 3*(n>>2);
+   if ( (p->w = (void*)arena_calloc (a, _plan_r2_size (n))) != NULL ) {
+      p->wf = (complex_f_t*)&p->w[nw];
+      p->r = (uint32_t*)&p->wf[nw];
+      p->type = FFT_RADIX2;
+      p->n = n;
+      p->m = _log2(n);
+
+      // Twiddle factors
+      for (i=0 ; i<nw ; ++i) {
+         th = M_2PI*i/n;
+         p->w[i] = cos (th) - I*sin (th);
+         p->wf[i] = (complex_f_t)p->w[i];
+      }
+      // Bit reversal permutation
+      for (i=1 ; i<n ; ++i)
+         p->r[i] = (p->r[i>>1] >> 1) | ((i & 1) << (p->m-1));
+      return n;
+   }
+   else
+      return 0;
+}
+
+/*
+ * Inner complex transforms of n points using a plan of N>=n points.
+ * Non radix-2 plans serve only their own n.
+ */
+static void _fftp_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X, uint32_t n) {
+   switch (p->type) {
+      default:
+      case FFT_RADIX2:        _fftp_body (_bit_reverse_tbl_c, _fftp_stages_c); break;
+      case FFT_MIXED_RADIX:   _fftp_mr_c (p, x, X); break;
+      case FFT_BLUESTEIN:     _fftp_blu_c (p, x, X); break;
+   }
+}
+static void _fftp_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X, uint32_t n) {
+   switch (p->type) {
+      default:
+      case FFT_RADIX2:        _fftp_body (_bit_reverse_tbl_cf, _fftp_stages_cf); break;
+      case FFT_MIXED_RADIX:   _fftp_mr_cf (p, x, X); break;
+      case FFT_BLUESTEIN:     _fftp_blu_cf (p, x, X); break;
+   }
+}
+static void _fftp_ci (fft_plan_t *p, complex_i_t *x, complex_f_t *X, uint32_t n) {
+   switch (p->type) {
+      default:
+      case FFT_RADIX2:        _fftp_body (_bit_reverse_tbl_ci, _fftp_stages_cf); break;
+      case FFT_MIXED_RADIX:   _fftp_mr_ci (p, x, X); break;
+      case FFT_BLUESTEIN:     _fftp_blu_ci (p, x, X); break;
+   }
+}
+
+/*!
+ * \brief
+ *    The main body of fft for real signals using plan
+ */
+#define _fftp_r_body(_intype, _outtype, _fft, _r, _i, _w) {   \
+   uint32_t i, j, l, n;    /* Loop counters */                \
+   uint32_t k, le, le_2;   /* butterfly loop */               \
+   uint32_t st, tw;        /* twiddle stride */               \
+   uint32_t n_2, n_4, _3n_4, im, ip2, ipm;                    \
+   _outtype t;                                                \
+                                                              \
+   /* Calculate helpers */                                    \
+   n = p->n;                                                  \
+   n_2 = n>>1;                                                \
+   n_4 = n_2>>1;                                              \
+   _3n_4 = 3*n_4;                                             \
+                                                              \
+   /* Cast real signal as complex, so even */                 \
+   /* points became real part and odd points */               \
+   /* became imaginary. Then do FFT to n/2 */                 \
+   _fft (p, (_intype*)x, X, n_2);                             \
+                                                              \
+   /* Even/odd frequency domain decomposition */              \
+   for (i=1 ; i<n_4 ; ++i) {                                  \
+      im = n_2 - i;                                           \
+      ip2 = n_2 + i;                                          \
+      ipm = n_2 + im;                                         \
+      _r(X[ip2]) = (_i(X[i]) + _i(X[im])) / 2;                \
+      _i(X[ip2]) = -(_r(X[i]) - _r(X[im])) / 2;               \
+      _r(X[ipm]) = _r(X[ip2]);                                \
+      _i(X[ipm]) = -_i(X[ip2]);                               \
+      _r(X[i])   = (_r(X[i]) + _r(X[im])) / 2;                \
+      _i(X[i])   = (_i(X[i]) - _i(X[im])) / 2;                \
+      _r(X[im])  = _r(X[i]);                                  \
+      _i(X[im])  = -_i(X[i]);                                 \
+   }                                                          \
+   _r(X[_3n_4]) = _i(X[n_4]);                                 \
+   _r(X[n_2]) = _i(X[0]);                                     \
+   _i(X[0]) = _i(X[n_4]) = _i(X[n_2]) = _i(X[_3n_4]) = 0;     \
+                                                              \
+   /* Do the last frequency domain synthesis loop */          \
+   l = p->m;                                                  \
+   _fft_loop_tbl (X, n, l, _w);                               \
+}
+
+/*!
+ * \brief
+ *    The main body of fft for real signals using a non radix-2 plan.
+ *    The signal is expanded to complex, from the end for the in-place case,
+ *    and the complex transform is used.
+ */
+#define _fftp_r_any_body(_outtype, _fft) {      \
+   uint32_t i;                                  \
+                                                \
+   for (i=p->n ; i>0 ; --i)                     \
+      X[i-1] = (_outtype)x[i-1];                \
+   _fft (p, X, X, p->n);                        \
+}
+
+/*!
+ * \brief
+ *    Inverse fft main body using plan
+ */
+#define _ifftp_body(_fft, _i, _c) {             \
+   uint32_t i, n = p->n;                        \
+                                                \
+   /* Convert to the conjugate */               \
+   for (i=0 ; i<n ; ++i) {                      \
+      x[i] = X[i];                              \
+      _i(x[i]) = -_i(x[i]);                     \
+   }                                            \
+   _fft (p, x, x, n);                           \
+                                                \
+   /* Take the conjugate and scale by n */      \
+   for (i=0 ; i<n ; ++i)                        \
+      x[i] = _c (x[i])/n;                       \
+}
+
+/*!
+ * \brief
+ *    Inverse fft main body for real signals using plan
+ */
+#define _ifftp_r_body(_type, _fft, _r, _i) {    \
+   uint32_t i, _2n, n = p->n;                   \
+   _type *xx = (_type*)x;                       \
+                                                \
+   /* Add real and imaginary part */            \
+   for (i=0 ; i<n ; ++i)                        \
+      x[i] = _r(X[i]) + _i(X[i]);               \
+                                                \
+   /* Calculate the real FFT from x */          \
+   _fft (p, x, xx);                             \
+                                                \
+   /* place the signal to the first half of the array */ \
+   for (i=0 ; i<n ; ++i)                        \
+      x[i] = (_r(xx[i]) + _i(xx[i])) / n;       \
+   for (i=n, _2n = 2*n; i<_2n ; ++i)            \
+      x[i] = 0;                                 \
+}
+
+/*!
+ * \brief
+ *    FFT plan de-initialisation.
+ *    The memory of a plan from fft_plan_init_static() stays to the caller.
+ *
+ * \param  p      Which plan to free
+ * \return none
+ */
+void fft_plan_deinit (fft_plan_t *p) {
+   if ( p->blk )
+      free (p->blk);
+   memset ((void*)p, 0, sizeof (fft_plan_t));
+}
+
+/*!
+ * \brief
+ *    Get the memory size an n point plan needs, for fft_plan_init_static().
+ *
+ * \param  n      Number of points. Must be greater or equal to 2
+ * \return        The size in bytes, 0 for invalid number of points
+ */
+size_t fft_plan_required_size (uint32_t n)
+{
+   uint32_t nf, M;
+
+   if (n < 2)
+      return 0;
+   if (n < 4 || (n & (n-1))) {
+      if ((nf = _factorise (n, NULL)) != 0)
+         return _plan_mr_size (n, nf);
+      M = _plan_blu_points (n);
+      return _plan_blu_size (n, M) + fft_plan_required_size (M);
+   }
+   return _plan_r2_size (n);
+}
+
+/*!
+ * \brief
+ *    FFT plan initialisation.
+ *    Allocates and calculates the tables for a n point transform:
+ *    - Power of 2 points. The twiddle factor table and the bit reversal
+ *      permutation table for the radix-2/4 kernels.
+ *    - 2^a * 3^b * 5^c points. The twiddle factor table and the factors
+ *      for the mixed radix kernels.
+ *    - Any other number of points. The chirp tables and an inner power
+ *      of 2 plan for Bluestein's algorithm.
+ *    Each twiddle factor is calculated directly, so there is no error
+ *    accumulation as with the recursive w *= s method.
+ *
+ * \param  p      Which plan to use
+ * \param  n      Number of points. Must be greater or equal to 2
+ * \return        The number of points on success, 0 on failure
+ */
+uint32_t fft_plan_init (fft_plan_t *p, uint32_t n)
+{
+   size_t sz = fft_plan_required_size (n);
+   void *mem;
+
+   if (!sz || (mem = malloc (sz + ARENA_ALIGN)) == NULL)
+      return 0;
+   if (fft_plan_init_static (p, n, mem, sz + ARENA_ALIGN) == 0) {
+      free (mem);
+      return 0;
+   }
+   p->blk = mem;
+   return n;
+}
+
+/*!
+ * \brief
+ *    FFT plan initialisation over caller supplied memory, with no heap use.
+ *    The plan is the same as from fft_plan_init(). The memory must stay
+ *    valid for the life of the plan and is not freed by fft_plan_deinit().
+ *
+ * \param  p      Which plan to use
+ * \param  n      Number of points. Must be greater or equal to 2
+ * \param  mem    Pointer to memory, aligned to ARENA_ALIGN
+ * \param  size   The size of the memory, at least fft_plan_required_size(n)
+ * \return        The number of points on success, 0 on failure
+ */
+uint32_t fft_plan_init_static (fft_plan_t *p, uint32_t n, void *mem, size_t size)
+{
+   arena_t a;
+
+   arena_init (&a, mem, size);
+   return _plan_init (p, n, &a);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision complex FFT using a precomputed plan.
+ *    - Not in-place.   Use pointers to different arrays for time and frequency
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        None
+ */
+void fftp_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X) {
+   _fftp_c (p, x, X, p->n);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision complex FFT using a precomputed plan.
+ *    - Not in-place.   Use pointers to different arrays for time and frequency
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        None
+ */
+void fftp_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X) {
+   _fftp_cf (p, x, X, p->n);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision complex FFT for complex integer input,
+ *    using a precomputed plan.
+ *    - Not in-place.   Use pointers to different arrays for time and frequency
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        None
+ */
+void fftp_ci (fft_plan_t *p, complex_i_t *x, complex_f_t *X) {
+   _fftp_ci (p, x, X, p->n);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision FFT for real signal, using a precomputed
+ *    plan and the even/odd decomposition of fft_r().
+ *    - Not in-place.   Use pointers to different arrays for time and frequency
+ *    - In-place        Use the same pointer for time and frequency
+ *                      In this case time domain array must have 2*n size.
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     Pointer to size n time domain array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        None
+ */
+void fftp_r (fft_plan_t *p, double *x, complex_d_t *X) {
+   if (p->type != FFT_RADIX2) {
+      _fftp_r_any_body (complex_d_t, _fftp_c);
+   }
+   else {
+      _fftp_r_body (complex_d_t, complex_d_t, _fftp_c, real, imag, p->w);
+   }
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision FFT for real signal, using a precomputed
+ *    plan and the even/odd decomposition of fft_r().
+ *    - Not in-place.   Use pointers to different arrays for time and frequency
+ *    - In-place        Use the same pointer for time and frequency
+ *                      In this case time domain array must have 2*n size.
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     Pointer to size n time domain array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        None
+ */
+void fftp_rf (fft_plan_t *p, float *x, complex_f_t *X) {
+   if (p->type != FFT_RADIX2) {
+      _fftp_r_any_body (complex_f_t, _fftp_cf);
+   }
+   else {
+      _fftp_r_body (complex_f_t, complex_f_t, _fftp_cf, realf, imagf, p->wf);
+   }
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision FFT for integer real signal, using a
+ *    precomputed plan and the even/odd decomposition of fft_r().
+ *    - Not in-place.   Use pointers to different arrays for time and frequency
+ *    - In-place        Use the same pointer for time and frequency
+ *                      In this case time domain array must have 2*n size.
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     Pointer to size n time domain array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        None
+ */
+void fftp_ri (fft_plan_t *p, int *x, complex_f_t *X) {
+   if (p->type != FFT_RADIX2) {
+      _fftp_r_any_body (complex_f_t, _fftp_cf);
+   }
+   else {
+      _fftp_r_body (complex_i_t, complex_f_t, _fftp_ci, realf, imagf, p->wf);
+   }
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision inverse complex FFT using a precomputed plan.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   X     Pointer to size n frequency domain complex array
+ * \param   x     Pointer to size n time domain complex array
+ * \return        None
+ */
+void ifftp_c (fft_plan_t *p, complex_d_t *X, complex_d_t *x) {
+   _ifftp_body (_fftp_c, imag, conj);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision inverse complex FFT using a precomputed plan.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   X     Pointer to size n frequency domain complex array
+ * \param   x     Pointer to size n time domain complex array
+ * \return        None
+ */
+void ifftp_cf (fft_plan_t *p, complex_f_t *X, complex_f_t *x) {
+   _ifftp_body (_fftp_cf, imagf, conjf);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision inverse FFT for real signal, using a
+ *    precomputed plan.
+ *
+ * \warning
+ *    The real time domain pointers MUST point to arrays with size 2*n
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   X     Pointer to size n frequency domain complex array
+ * \param   x     Pointer to size 2*n time domain array
+ * \return        None
+ */
+void ifftp_r (fft_plan_t *p, complex_d_t *X, double *x) {
+   _ifftp_r_body (complex_d_t, fftp_r, real, imag);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision inverse FFT for real signal, using a
+ *    precomputed plan.
+ *
+ * \warning
+ *    The real time domain pointers MUST point to arrays with size 2*n
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   X     Pointer to size n frequency domain complex array
+ * \param   x     Pointer to size 2*n time domain array
+ * \return        None
+ */
+void ifftp_rf (fft_plan_t *p, complex_f_t *X, float *x) {
+   _ifftp_r_body (complex_f_t, fftp_rf, realf, imagf);
+}
+
+
+/*
+ * ============ Split complex transforms ============
+ */
+
+/*!
+ * \brief
+ *    Radix-2 butterflies on split complex data, for cnt consecutive
+ *    butterflies of the same stage.
+ *       t = w*b, b = a - t, a = a + t
+ *    The real and imaginary parts are in separate arrays and the
+ *    twiddles are contiguous, so the loop is vectorised without shuffles.
+ */
+#define _fft_split_bfly_body(_type) {           \
+   _type tr, ti;                                \
+   uint32_t i;                                  \
+   for (i=0 ; i<cnt ; ++i) {                    \
+      tr = wr[i]*br[i] - wi[i]*bi[i];           \
+      ti = wr[i]*bi[i] + wi[i]*br[i];           \
+      br[i] = ar[i] - tr;                       \
+      bi[i] = ai[i] - ti;                       \
+      ar[i] += tr;                              \
+      ai[i] += ti;                              \
+   }                                            \
+}
+static void _fft_split_bfly_d (double *restrict ar, double *restrict ai,
+                               double *restrict br, double *restrict bi,
+                               const double *restrict wr, const double *restrict wi, uint32_t cnt) __O3__ ;
+static void _fft_split_bfly_f (float *restrict ar, float *restrict ai,
+                               float *restrict br, float *restrict bi,
+                               const float *restrict wr, const float *restrict wi, uint32_t cnt) __O3__ ;
+
+static void _fft_split_bfly_d (double *restrict ar, double *restrict ai,
+                               double *restrict br, double *restrict bi,
+                               const double *restrict wr, const double *restrict wi, uint32_t cnt) {
+   _fft_split_bfly_body (double);
+}
+static void _fft_split_bfly_f (float *restrict ar, float *restrict ai,
+                               float *restrict br, float *restrict bi,
+                               const float *restrict wr, const float *restrict wi, uint32_t cnt) {
+   _fft_split_bfly_body (float);
+}
+
+#define _FFT_SPLIT_TW      (64)     //!< Twiddles gathered per chunk of a stage
+
+/*!
+ * \brief
+ *    Radix-2 split complex FFT main body, using a power of 2 plan.
+ *    The data are bit reversed to X with the plan's table and then each
+ *    stage runs in chunks of _FFT_SPLIT_TW butterflies. The chunk's twiddles,
+ *    w[k*n/le], are gathered once to contiguous split arrays and used by
+ *    every sub-DFT of the stage.
+ *
+ * \param   _type    The real data type
+ * \param   _w       The plan's twiddle table to use
+ * \param   _bfly    The butterfly kernel
+ * \param   _xr,_xi  The input real and imaginary arrays
+ * \param   _Xr,_Xi  The output real and imaginary arrays
+ */
+#define _fftp_split_r2_body(_type, _w, _bfly, _xr, _xi, _Xr, _Xi) { \
+   _type wr[_FFT_SPLIT_TW], wi[_FFT_SPLIT_TW], t;        \
+   uint32_t i, j, k, c, cnt, le, le_2, st;               \
+                                                         \
+   /* Bit reversal */                                    \
+   for (i=0 ; i<n ; ++i) {                               \
+      if (i <= (j = p->r[i])) {                          \
+         t = _xr[i]; _Xr[i] = _xr[j]; _Xr[j] = t;        \
+         t = _xi[i]; _Xi[i] = _xi[j]; _Xi[j] = t;        \
+      }                                                  \
+   }                                                     \
+   /* The first stage has only w = 1 */                  \
+   for (i=0 ; i<n ; i+=2) {                              \
+      t = _Xr[i+1]; _Xr[i+1] = _Xr[i] - t; _Xr[i] += t;  \
+      t = _Xi[i+1]; _Xi[i+1] = _Xi[i] - t; _Xi[i] += t;  \
+   }                                                     \
+   for (le=4 ; le<=n ; le<<=1) {                         \
+      le_2 = le>>1;                                      \
+      st = n/le;                                         \
+      for (k=0 ; k<le_2 ; k+=cnt) {                      \
+         cnt = (le_2-k < _FFT_SPLIT_TW) ? le_2-k : _FFT_SPLIT_TW; \
+         for (c=0 ; c<cnt ; ++c) {                       \
+            wr[c] = __real__ _w[(k+c)*st];              \
+            wi[c] = __imag__ _w[(k+c)*st];              \
+         }                                               \
+         for (i=k ; i<n ; i+=le)                         \
+            _bfly (&_Xr[i], &_Xi[i], &_Xr[i+le_2], &_Xi[i+le_2], wr, wi, cnt); \
+      }                                                  \
+   }                                                     \
+}
+
+/*!
+ * \brief
+ *    Split complex FFT main body for any plan. Power of 2 plans run the split
+ *    radix-2 body. The others merge to the caller's workspace, interleaved,
+ *    run the plan's complex transform and split the result back.
+ *    The forward transform calls it with (x.re, x.im) -> (X.re, X.im) and the
+ *    inverse with the parts swapped, as swap(fft(swap(X))) = n*ifft(X).
+ */
+#define _fftp_split_body(_type, _ctype, _w, _bfly, _fftp, _xr, _xi, _Xr, _Xi) { \
+   _ctype *t;                                            \
+   uint32_t i;                                           \
+                                                         \
+   if (p->type == FFT_RADIX2)                            \
+      _fftp_split_r2_body (_type, _w, _bfly, _xr, _xi, _Xr, _Xi)  \
+   else {                                                \
+      if ((t = (_ctype*)ws) == NULL)                     \
+         return 0;                                       \
+      for (i=0 ; i<n ; ++i) {                            \
+         __real__ t[i] = _xr[i];                         \
+         __imag__ t[i] = _xi[i];                         \
+      }                                                  \
+      _fftp (p, t, t);                                   \
+      for (i=0 ; i<n ; ++i) {                            \
+         _Xr[i] = __real__ t[i];                         \
+         _Xi[i] = __imag__ t[i];                         \
+      }                                                  \
+   }                                                     \
+}
+
+/*!
+ * \brief
+ *    Get the workspace size the split transforms of an n point plan need.
+ *    Power of 2 plans need none. The others need n complex points.
+ *
+ * \param  n      Number of points
+ * \return        The size in bytes, 0 for power of 2 points
+ */
+size_t fftp_split_required_size (uint32_t n) {
+   return (n & (n-1)) ? (size_t)n*sizeof (complex_d_t) : 0;
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision complex FFT of a split (SoA) complex
+ *    signal, using a precomputed plan.
+ *    - Not in-place.   Use different arrays for time and frequency
+ *    - In-place        Use the same arrays for time and frequency
+ *
+ * \note
+ *    Power of 2 plans work directly on the split arrays. The other plans
+ *    need a workspace of fftp_split_required_size() bytes.
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     The size n time domain split arrays
+ * \param   X     The size n frequency domain split arrays
+ * \param   ws    Pointer to the workspace, NULL for power of 2 plans
+ * \return        The number of points on success, 0 on failure
+ */
+uint32_t fftp_split_d (fft_plan_t *p, split_d_t x, split_d_t X, void *ws) {
+   uint32_t n = p->n;
+   _fftp_split_body (double, complex_d_t, p->w, _fft_split_bfly_d, fftp_c, x.re, x.im, X.re, X.im);
+   return n;
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision complex FFT of a split (SoA) complex
+ *    signal, using a precomputed plan.
+ *    - Not in-place.   Use different arrays for time and frequency
+ *    - In-place        Use the same arrays for time and frequency
+ *
+ * \note
+ *    Power of 2 plans work directly on the split arrays. The other plans
+ *    need a workspace of fftp_split_required_size() bytes.
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   x     The size n time domain split arrays
+ * \param   X     The size n frequency domain split arrays
+ * \param   ws    Pointer to the workspace, NULL for power of 2 plans
+ * \return        The number of points on success, 0 on failure
+ */
+uint32_t fftp_split_f (fft_plan_t *p, split_f_t x, split_f_t X, void *ws) {
+   uint32_t n = p->n;
+   _fftp_split_body (float, complex_f_t, p->wf, _fft_split_bfly_f, fftp_cf, x.re, x.im, X.re, X.im);
+   return n;
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision inverse complex FFT of a split (SoA)
+ *    complex spectrum, using a precomputed plan.
+ *    - Not in-place.   Use different arrays for time and frequency
+ *    - In-place        Use the same arrays for time and frequency
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   X     The size n frequency domain split arrays
+ * \param   x     The size n time domain split arrays
+ * \param   ws    Pointer to the workspace, NULL for power of 2 plans
+ * \return        The number of points on success, 0 on failure
+ */
+uint32_t ifftp_split_d (fft_plan_t *p, split_d_t X, split_d_t x, void *ws) {
+   uint32_t j, n = p->n;
+   double s = 1.0/n;
+
+   _fftp_split_body (double, complex_d_t, p->w, _fft_split_bfly_d, fftp_c, X.im, X.re, x.im, x.re);
+   for (j=0 ; j<n ; ++j) {
+      x.re[j] *= s;
+      x.im[j] *= s;
+   }
+   return n;
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision inverse complex FFT of a split (SoA)
+ *    complex spectrum, using a precomputed plan.
+ *    - Not in-place.   Use different arrays for time and frequency
+ *    - In-place        Use the same arrays for time and frequency
+ *
+ * \param   p     Pointer to an initialised plan of n points
+ * \param   X     The size n frequency domain split arrays
+ * \param   x     The size n time domain split arrays
+ * \param   ws    Pointer to the workspace, NULL for power of 2 plans
+ * \return        The number of points on success, 0 on failure
+ */
+uint32_t ifftp_split_f (fft_plan_t *p, split_f_t X, split_f_t x, void *ws) {
+   uint32_t j, n = p->n;
+   float s = 1.0f/n;
+
+   _fftp_split_body (float, complex_f_t, p->wf, _fft_split_bfly_f, fftp_cf, X.im, X.re, x.im, x.re);
+   for (j=0 ; j<n ; ++j) {
+      x.re[j] *= s;
+      x.im[j] *= s;
+   }
+   return n;
+}
+
+#undef _fft_split_bfly_body
+#undef _fftp_split_r2_body
+#undef _fftp_split_body
+
+/*
+ * ============ Batched transforms ============
+ */
+
+/*!
+ * \brief
+ *    The main body of the batched transforms.
+ *    Contiguous channels are transformed directly. Strided channels are
+ *    gathered FFT_BATCH_CH at a time, sample by sample, to the caller's
+ *    workspace, transformed in place there and scattered back the same way.
+ *
+ * \param   _intype     The time domain type
+ * \param   _outtype    The frequency domain type
+ * \param   _fft        The plan transform to use
+ * \param   _in         The input arrays
+ * \param   _out        The output arrays
+ */
+#define _fftp_batch_body(_intype, _outtype, _fft, _in, _out) { \
+   uint32_t c, b, nb, i, n = p->n;                       \
+   _outtype *t;                                          \
+                                                         \
+   if (stride == 1) {                                    \
+      for (c=0 ; c<ch ; ++c)                             \
+         _fft (p, &_in[c*dist], &_out[c*dist]);        \
+      return ch;                                         \
+   }                                                     \
+   if ((t = (_outtype*)ws) == NULL)                      \
+      return 0;                                          \
+   for (c=0 ; c<ch ; c+=nb) {                            \
+      nb = (ch-c < FFT_BATCH_CH) ? ch-c : FFT_BATCH_CH;  \
+      for (i=0 ; i<n ; ++i)                              \
+         for (b=0 ; b<nb ; ++b)                          \
+            ((_intype*)&t[b*n])[i] = _in[(c+b)*dist + i*stride]; \
+      for (b=0 ; b<nb ; ++b)                             \
+         _fft (p, (_intype*)&t[b*n], &t[b*n]);           \
+      for (i=0 ; i<n ; ++i)                              \
+         for (b=0 ; b<nb ; ++b)                          \
+            _out[(c+b)*dist + i*stride] = t[b*n + i];    \
+   }                                                     \
+   return ch;                                            \
+}
+
+/*!
+ * \brief
+ *    Batched transform using a temporary plan, shared by all the channels,
+ *    and a temporary workspace for strided channels.
+ */
+#define _fft_batch_any(_fftp) {                          \
+   fft_plan_t p;                                         \
+   void *ws = NULL;                                      \
+   uint32_t ret = 0;                                     \
+                                                         \
+   if (stride != 1 &&                                    \
+      (ws = malloc (fftp_batch_required_size (n))) == NULL) \
+      return 0;                                          \
+   if (fft_plan_init (&p, n)) {                          \
+      ret = _fftp (&p, x, X, ch, stride, dist, ws);      \
+      fft_plan_deinit (&p);                              \
+   }                                                     \
+   free (ws);                                            \
+   return ret;                                           \
+}
+
+/*!
+ * \brief
+ *    Get the workspace size the strided batch transforms of n points need.
+ *    Contiguous channels, stride = 1, need none.
+ *
+ * \param  n      Number of points
+ * \return        The size in bytes, FFT_BATCH_CH*n complex points
+ */
+size_t fftp_batch_required_size (uint32_t n) {
+   return FFT_BATCH_CH*(size_t)n*sizeof (complex_d_t);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision complex FFT of ch equal length signals.
+ *    Sample i of channel c is at x[c*dist + i*stride].
+ *
+ * \param   x        Pointer to the time domain arrays
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   n        Number of points
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t fft_batch_c (complex_d_t *x, complex_d_t *X, uint32_t n, uint32_t ch, uint32_t stride, uint32_t dist) {
+   _fft_batch_any (fftp_batch_c);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision complex FFT of ch equal length signals.
+ *    Sample i of channel c is at x[c*dist + i*stride].
+ *
+ * \param   x        Pointer to the time domain arrays
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   n        Number of points
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t fft_batch_cf (complex_f_t *x, complex_f_t *X, uint32_t n, uint32_t ch, uint32_t stride, uint32_t dist) {
+   _fft_batch_any (fftp_batch_cf);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision FFT of ch equal length real signals.
+ *    Sample i of channel c is at x[c*dist + i*stride]. Not in-place.
+ *
+ * \param   x        Pointer to the time domain arrays
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   n        Number of points
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t fft_batch_r (double *x, complex_d_t *X, uint32_t n, uint32_t ch, uint32_t stride, uint32_t dist) {
+   _fft_batch_any (fftp_batch_r);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision FFT of ch equal length real signals.
+ *    Sample i of channel c is at x[c*dist + i*stride]. Not in-place.
+ *
+ * \param   x        Pointer to the time domain arrays
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   n        Number of points
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t fft_batch_rf (float *x, complex_f_t *X, uint32_t n, uint32_t ch, uint32_t stride, uint32_t dist) {
+   _fft_batch_any (fftp_batch_rf);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision complex FFT of ch equal length signals
+ *    using a precomputed plan.
+ *
+ * \param   p        Pointer to an initialised plan of n points
+ * \param   x        Pointer to the time domain arrays
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \param   ws       Pointer to the workspace, NULL for stride = 1
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t fftp_batch_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) {
+   _fftp_batch_body (complex_d_t, complex_d_t, fftp_c, x, X);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision complex FFT of ch equal length signals
+ *    using a precomputed plan.
+ *
+ * \param   p        Pointer to an initialised plan of n points
+ * \param   x        Pointer to the time domain arrays
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \param   ws       Pointer to the workspace, NULL for stride = 1
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t fftp_batch_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) {
+   _fftp_batch_body (complex_f_t, complex_f_t, fftp_cf, x, X);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision FFT of ch equal length real signals
+ *    using a precomputed plan. Not in-place.
+ *
+ * \param   p        Pointer to an initialised plan of n points
+ * \param   x        Pointer to the time domain arrays
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \param   ws       Pointer to the workspace, NULL for stride = 1
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t fftp_batch_r (fft_plan_t *p, double *x, complex_d_t *X, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) {
+   _fftp_batch_body (double, complex_d_t, fftp_r, x, X);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision FFT of ch equal length real signals
+ *    using a precomputed plan. Not in-place.
+ *
+ * \param   p        Pointer to an initialised plan of n points
+ * \param   x        Pointer to the time domain arrays
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \param   ws       Pointer to the workspace, NULL for stride = 1
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t fftp_batch_rf (fft_plan_t *p, float *x, complex_f_t *X, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) {
+   _fftp_batch_body (float, complex_f_t, fftp_rf, x, X);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision inverse complex FFT of ch equal length
+ *    spectra using a precomputed plan.
+ *
+ * \param   p        Pointer to an initialised plan of n points
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   x        Pointer to the time domain arrays
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \param   ws       Pointer to the workspace, NULL for stride = 1
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t ifftp_batch_c (fft_plan_t *p, complex_d_t *X, complex_d_t *x, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) {
+   _fftp_batch_body (complex_d_t, complex_d_t, ifftp_c, X, x);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision inverse complex FFT of ch equal length
+ *    spectra using a precomputed plan.
+ *
+ * \param   p        Pointer to an initialised plan of n points
+ * \param   X        Pointer to the frequency domain arrays
+ * \param   x        Pointer to the time domain arrays
+ * \param   ch       Number of channels
+ * \param   stride   Distance between two samples of a channel
+ * \param   dist     Distance between the first samples of two channels
+ * \param   ws       Pointer to the workspace, NULL for stride = 1
+ * \return           The number of channels on success, 0 on failure
+ */
+uint32_t ifftp_batch_cf (fft_plan_t *p, complex_f_t *X, complex_f_t *x, uint32_t ch, uint32_t stride, uint32_t dist, void *ws) {
+   _fftp_batch_body (complex_f_t, complex_f_t, ifftp_cf, X, x);
+}
+
+/*
+ * ============ Fixed point ============
+ */
+
+#define  _FFT_Q15_LIM      (11585L)       //!< 1/(2*sqrt(2)) in Q15
+#define  _FFT_Q31_LIM      (759250124LL)  //!< 1/(2*sqrt(2)) in Q31
+
+/*!
+ * \brief
+ *    Convert a [-1, 1] value to a fixed point value of q fractional bits.
+ *    The result is saturated symmetrically, so the inverse transform can
+ *    negate the twiddle factors without overflow.
+ */
+static int64_t _fft_to_q (double v, int q) {
+   int64_t r = (int64_t)floor (v*(double)(1LL<<q) + 0.5);
+   int64_t lim = (1LL<<q) - 1;
+
+   return (r > lim) ? lim : ((r < -lim) ? -lim : r);
+}
+
+/*!
+ * \brief
+ *    Absolute maximum tracking
+ */
+#define  _fft_q_max(_v)       \
+{                             \
+   v = (_v);                  \
+   if (v < 0)  v = -v;        \
+   if (v > mx) mx = v;        \
+}
+
+/*!
+ * \brief
+ *    The main body of the block floating point radix-2 fft.
+ *    Before each stage the whole block is scaled down by 2 until its maximum
+ *    component is below 1/(2*sqrt(2)). This way no butterfly output can
+ *    overflow, and no precision is lost when there is no need to. The
+ *    maximum for the next stage is tracked while each stage is calculated.
+ *
+ * \param   _type    The complex data type
+ * \param   _stype   The component type
+ * \param   _ltype   The product type
+ * \param   _q       The number of fractional bits
+ * \param   _lim     The scaling limit
+ * \param   _w       The twiddle factor table
+ * \param   _r       The real part access macro
+ * \param   _i       The imaginary part access macro
+ * \return           The block exponent
+ */
+#define _fftp_q_body(_type, _stype, _ltype, _q, _lim, _w, _r, _i) {  \
+   uint32_t i, j, k, le, le_2, st, n = p->n;             \
+   _stype ar, ai, br, bi, tr, ti, wr, wi;                \
+   _ltype mx, v, rnd;                                    \
+   _type tmp;                                            \
+   int s, e;                                             \
+                                                         \
+   /* Bit reversal permutation */                       \
+   for (i=0 ; i<n ; ++i) {                               \
+      if (i <= (j = p->r[i])) {                          \
+         tmp = x[i];                                     \
+         X[i] = x[j];                                    \
+         X[j] = tmp;                                     \
+      }                                                  \
+   }                                                     \
+   for (i=0, mx=0 ; i<n ; ++i) {                         \
+      _fft_q_max (_r(X[i]));                             \
+      _fft_q_max (_i(X[i]));                             \
+   }                                                     \
+   for (le=2, e=0 ; le<=n ; le<<=1) {                    \
+      /* Block scaling for this stage */                 \
+      for (s=0 ; mx > (_lim) ; ++s)                      \
+         mx >>= 1;                                       \
+      rnd = (s) ? (_ltype)1 << (s-1) : 0;                \
+      e += s;                                            \
+      mx = 0;                                            \
+      le_2 = le>>1;                                      \
+      st = n/le;                                         \
+      for (j=0 ; j<le_2 ; ++j) {                         \
+         wr = _r(_w[j*st]);                              \
+         wi = (inv) ? -_i(_w[j*st]) : _i(_w[j*st]);      \
+         for (i=j ; i<n ; i+=le) {                       \
+            k = i + le_2;                                \
+            ar = ((_ltype)_r(X[i]) + rnd) >> s;          \
+            ai = ((_ltype)_i(X[i]) + rnd) >> s;          \
+            br = ((_ltype)_r(X[k]) + rnd) >> s;          \
+            bi = ((_ltype)_i(X[k]) + rnd) >> s;          \
+            tr = ((_ltype)br*wr - (_ltype)bi*wi + ((_ltype)1 << ((_q)-1))) >> (_q); \
+            ti = ((_ltype)br*wi + (_ltype)bi*wr + ((_ltype)1 << ((_q)-1))) >> (_q); \
+            _r(X[i]) = ar + tr;                          \
+            _i(X[i]) = ai + ti;                          \
+            _r(X[k]) = ar - tr;                          \
+            _i(X[k]) = ai - ti;                          \
+            _fft_q_max (_r(X[i]));                       \
+            _fft_q_max (_i(X[i]));                       \
+            _fft_q_max (_r(X[k]));                       \
+            _fft_q_max (_i(X[k]));                       \
+         }                                               \
+      }                                                  \
+   }                                                     \
+   return (inv) ? e - (int)p->m : e;                     \
+}
+
+static int _fftp_q15 (fft_plan_t *p, complex_q15_t *x, complex_q15_t *X, int inv) {
+   _fftp_q_body (complex_q15_t, int16_t, int32_t, 15, _FFT_Q15_LIM, p->wq15, realq15, imagq15);
+}
+static int _fftp_q31 (fft_plan_t *p, complex_q31_t *x, complex_q31_t *X, int inv) {
+   _fftp_q_body (complex_q31_t, int32_t, int64_t, 31, _FFT_Q31_LIM, p->wq31, realq31, imagq31);
+}
+
+/*!
+ * \brief
+ *    Get the memory size an n point fixed point plan needs,
+ *    for fft_plan_fixed_init_static().
+ *
+ * \param  n      Number of points. Must be a power of 2, greater or equal to 2
+ * \return        The size in bytes, 0 for invalid number of points
+ */
+size_t fft_plan_fixed_required_size (uint32_t n)
+{
+   if (n < 2 || (n & (n-1)))
+      return 0;
+   return _plan_fixed_size (n);
+}
+
+/*!
+ * \brief
+ *    Fixed point FFT plan initialisation.
+ *    Allocates and calculates only the Q31 and Q15 twiddle factor tables and
+ *    the bit reversal permutation table, so no floating point arithmetic is
+ *    needed by the transforms. The plan serves only the fixed point transforms.
+ *
+ * \param  p      Which plan to use
+ * \param  n      Number of points. Must be a power of 2, greater or equal to 2
+ * \return        The number of points on success, 0 on failure
+ */
+uint32_t fft_plan_fixed_init (fft_plan_t *p, uint32_t n)
+{
+   size_t sz = fft_plan_fixed_required_size (n);
+   void *mem;
+
+   if (!sz || (mem = malloc (sz + ARENA_ALIGN)) == NULL)
+      return 0;
+   if (fft_plan_fixed_init_static (p, n, mem, sz + ARENA_ALIGN) == 0) {
+      free (mem);
+      return 0;
+   }
+   p->blk = mem;
+   return n;
+}
+
+/*!
+ * \brief
+ *    Fixed point FFT plan initialisation over caller supplied memory,
+ *    with no heap use. The memory must stay valid for the life of the plan
+ *    and is not freed by fft_plan_deinit().
+ *
+ * \param  p      Which plan to use
+ * \param  n      Number of points. Must be a power of 2, greater or equal to 2
+ * \param  mem    Pointer to memory, aligned to ARENA_ALIGN
+ * \param  size   The size of the memory, at least fft_plan_fixed_required_size(n)
+ * \return        The number of points on success, 0 on failure
+ */
+uint32_t fft_plan_fixed_init_static (fft_plan_t *p, uint32_t n, void *mem, size_t size)
+{
+   uint32_t i, nw;
+   double th, c, s;
+   arena_t a;
+
+   // Check number of points
+   if (n < 2 || (n & (n-1)))
+      return 0;
+   memset ((void*)p, 0, sizeof (fft_plan_t));
+   arena_init (&a, mem, size);
+
+   // All tables in one block
+   nw = n>>1;
+   if ( (p->wq31 = (void*)arena_calloc (&a, _plan_fixed_size (n))) != NULL ) {
+      p->wq15 = (complex_q15_t*)&p->wq31[nw];
+      p->r = (uint32_t*)&p->wq15[nw];
+      p->type = FFT_RADIX2;
+      p->n = n;
+      p->m = _log2(n);
+
+      // Twiddle factors
+      for (i=0 ; i<nw ; ++i) {
+         th = M_2PI*i/n;
+         c = cos (th);
+         s = -sin (th);
+         realq31 (p->wq31[i]) = (int32_t)_fft_to_q (c, 31);
+         imagq31 (p->wq31[i]) = (int32_t)_fft_to_q (s, 31);
+         realq15 (p->wq15[i]) = (int16_t)_fft_to_q (c, 15);
+         imagq15 (p->wq15[i]) = (int16_t)_fft_to_q (s, 15);
+      }
+      // Bit reversal permutation
+      for (i=1 ; i<n ; ++i)
+         p->r[i] = (p->r[i>>1] >> 1) | ((i & 1) << (p->m-1));
+      return n;
+   }
+   else
+      return 0;
+}
+
+/*!
+ * \brief
+ *    Calculate the Q15 complex FFT using a fixed point plan.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised fixed point plan of n points
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        The block exponent e. The spectrum is X*2^e
+ */
+int fftp_q15 (fft_plan_t *p, complex_q15_t *x, complex_q15_t *X) {
+   return _fftp_q15 (p, x, X, 0);
+}
+
+/*!
+ * \brief
+ *    Calculate the Q31 complex FFT using a fixed point plan.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised fixed point plan of n points
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        The block exponent e. The spectrum is X*2^e
+ */
+int fftp_q31 (fft_plan_t *p, complex_q31_t *x, complex_q31_t *X) {
+   return _fftp_q31 (p, x, X, 0);
+}
+
+/*!
+ * \brief
+ *    Calculate the Q15 inverse complex FFT using a fixed point plan.
+ *    The 1/n scaling is included in the returned exponent.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised fixed point plan of n points
+ * \param   X     Pointer to size n frequency domain complex array
+ * \param   x     Pointer to size n time domain complex array
+ * \return        The block exponent e. The signal is x*2^e
+ */
+int ifftp_q15 (fft_plan_t *p, complex_q15_t *X, complex_q15_t *x) {
+   return _fftp_q15 (p, X, x, 1);
+}
+
+/*!
+ * \brief
+ *    Calculate the Q31 inverse complex FFT using a fixed point plan.
+ *    The 1/n scaling is included in the returned exponent.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised fixed point plan of n points
+ * \param   X     Pointer to size n frequency domain complex array
+ * \param   x     Pointer to size n time domain complex array
+ * \return        The block exponent e. The signal is x*2^e
+ */
+int ifftp_q31 (fft_plan_t *p, complex_q31_t *X, complex_q31_t *x) {
+   return _fftp_q31 (p, X, x, 1);
+}
@@ -0,0 +1,398 @@
+/*
+ * \file fft_mt.c
+ * \brief
+ *    Multithreaded four-step FFT for very large transforms on host builds
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2015 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <dsp/fft_mt.h>
+
+#ifdef TBX_THREADS
+
+/*
+ * The transform steps. With index j = j1 + n1*j2 and k = k2 + n2*k1:
+ *    1. Transpose x (n2 x n1) to t (n1 x n2)
+ *    2. n2 point transforms of the rows of t, times e^(-j2pi j1*k2/n)
+ *    3. Transpose t (n1 x n2) to X (n2 x n1)
+ *    4. n1 point transforms of the rows of X
+ *    5. Transpose X (n2 x n1) to t (n1 x n2), the natural order
+ *    6. Copy t to X
+ */
+typedef enum {
+   _FFT_MT_TR1 = 0,
+   _FFT_MT_ROW2,
+   _FFT_MT_TR2,
+   _FFT_MT_ROW1,
+   _FFT_MT_TR3,
+   _FFT_MT_COPY
+}_fft_mt_step_en;
+
+/*
+ * Static functions
+ */
+static void _fft_mt_job (fft_mt_plan_t *p, uint32_t id) __O3__ ;
+
+
+/*
+ * ============ Worker pool ============
+ */
+
+/*!
+ * \brief
+ *    Worker thread. Takes an id and then runs each new job generation
+ *    until the pool terminates.
+ */
+static void *_fft_mt_worker (void *arg)
+{
+   fft_mt_plan_t *p = (fft_mt_plan_t*)arg;
+   uint32_t id, gen;
+
+   // Workers start before the first job, at generation 0
+   gen = 0;
+   pthread_mutex_lock (&p->mx);
+   id = ++p->ids;
+   for ( ; ; ) {
+      while (gen == p->gen && !p->quit)
+         pthread_cond_wait (&p->go, &p->mx);
+      if (p->quit)
+         break;
+      gen = p->gen;
+      pthread_mutex_unlock (&p->mx);
+
+      _fft_mt_job (p, id);
+
+      pthread_mutex_lock (&p->mx);
+      if (--p->busy == 0)
+         pthread_cond_signal (&p->done);
+   }
+   pthread_mutex_unlock (&p->mx);
+   return NULL;
+}
+
+/*!
+ * \brief
+ *    Run a step on all threads. The caller runs the first band and
+ *    returns when all the workers are done.
+ */
+static void _fft_mt_run (fft_mt_plan_t *p, uint8_t step)
+{
+   p->step = step;
+   if (p->nt > 1) {
+      pthread_mutex_lock (&p->mx);
+      p->busy = p->nt - 1;
+      ++p->gen;
+      pthread_cond_broadcast (&p->go);
+      pthread_mutex_unlock (&p->mx);
+   }
+   _fft_mt_job (p, 0);
+   if (p->nt > 1) {
+      pthread_mutex_lock (&p->mx);
+      while (p->busy)
+         pthread_cond_wait (&p->done, &p->mx);
+      pthread_mutex_unlock (&p->mx);
+   }
+}
+
+/*!
+ * \brief
+ *    Stop and join the first nt-1 workers of the pool.
+ */
+static void _fft_mt_pool_stop (fft_mt_plan_t *p, uint32_t nt)
+{
+   uint32_t i;
+
+   pthread_mutex_lock (&p->mx);
+   p->quit = 1;
+   pthread_cond_broadcast (&p->go);
+   pthread_mutex_unlock (&p->mx);
+   for (i=0 ; i+1<nt ; ++i)
+      pthread_join (p->th[i], NULL);
+}
+
+
+/*
+ * ============ Steps ============
+ */
+
+/*!
+ * \brief
+ *    Blocked transpose body. Transposes the src rows x cols matrix to dst,
+ *    calculating only the dst rows [c0..c1), in FFT_MT_TR_BLK square tiles.
+ */
+#define _fft_mt_tr_body(_type) {                               \
+   _type *s = (_type*)src, *d = (_type*)dst;                   \
+   uint32_t r, c, rb, cb, re, ce;                              \
+                                                               \
+   for (cb=c0 ; cb<c1 ; cb+=FFT_MT_TR_BLK) {                   \
+      ce = (cb+FFT_MT_TR_BLK < c1) ? cb+FFT_MT_TR_BLK : c1;    \
+      for (rb=0 ; rb<rows ; rb+=FFT_MT_TR_BLK) {               \
+         re = (rb+FFT_MT_TR_BLK < rows) ? rb+FFT_MT_TR_BLK : rows; \
+         for (c=cb ; c<ce ; ++c)                               \
+            for (r=rb ; r<re ; ++r)                            \
+               d[c*rows + r] = s[r*cols + c];                  \
+      }                                                        \
+   }                                                           \
+}
+
+static void _fft_mt_tr (fft_mt_plan_t *p, void *src, void *dst,
+                        uint32_t rows, uint32_t cols, uint32_t c0, uint32_t c1) {
+   if (p->sgl) _fft_mt_tr_body (complex_f_t)
+   else        _fft_mt_tr_body (complex_d_t)
+}
+
+/*!
+ * \brief
+ *    Row transforms body, with the optional twiddle multiplication of
+ *    the first transform step. e^(-j2pi*e/n) = wh[e>>h] * wl[e & (2^h-1)]
+ */
+#define _fft_mt_row_body(_type, _fft, _ifft, _c) {             \
+   _type *x = (_type*)buf, *rw;                                \
+   complex_d_t w;                                              \
+   uint32_t r, k, e, msk = (1UL << p->h) - 1;                  \
+                                                               \
+   for (r=r0 ; r<r1 ; ++r) {                                   \
+      rw = &x[r*len];                                          \
+      if (p->inv)    _ifft (pl, rw, rw);                       \
+      else           _fft (pl, rw, rw);                        \
+      if (tw) {                                                \
+         for (k=1 ; k<len ; ++k) {                             \
+            e = r*k;                                           \
+            w = p->wh[e >> p->h] * p->wl[e & msk];             \
+            rw[k] *= (_type)((p->inv) ? _c (w) : w);           \
+         }                                                     \
+      }                                                        \
+   }                                                           \
+}
+
+static void _fft_mt_row (fft_mt_plan_t *p, fft_plan_t *pl, void *buf,
+                         uint32_t len, uint32_t r0, uint32_t r1, int tw) {
+   if (p->sgl) _fft_mt_row_body (complex_f_t, fftp_cf, ifftp_cf, conj)
+   else        _fft_mt_row_body (complex_d_t, fftp_c, ifftp_c, conj)
+}
+
+/*!
+ * \brief
+ *    Run the id-th band of the current step.
+ */
+static void _fft_mt_job (fft_mt_plan_t *p, uint32_t id)
+{
+   uint32_t n1 = p->n1, n2 = p->n2, nt = p->nt;
+   uint32_t a1 = (uint32_t)((uint64_t)n1*id/nt),   b1 = (uint32_t)((uint64_t)n1*(id+1)/nt);
+   uint32_t a2 = (uint32_t)((uint64_t)n2*id/nt),   b2 = (uint32_t)((uint64_t)n2*(id+1)/nt);
+   size_t   sz = (p->sgl) ? sizeof (complex_f_t) : sizeof (complex_d_t);
+
+   switch (p->step) {
+      case _FFT_MT_TR1:    _fft_mt_tr (p, p->x, p->t, n2, n1, a1, b1);  break;
+      case _FFT_MT_ROW2:   _fft_mt_row (p, &p->p2, p->t, n2, a1, b1, 1); break;
+      case _FFT_MT_TR2:    _fft_mt_tr (p, p->t, p->X, n1, n2, a2, b2);  break;
+      case _FFT_MT_ROW1:   _fft_mt_row (p, &p->p1, p->X, n1, a2, b2, 0); break;
+      case _FFT_MT_TR3:    _fft_mt_tr (p, p->X, p->t, n2, n1, a1, b1);  break;
+      case _FFT_MT_COPY:
+         memcpy ((uint8_t*)p->X + a1*n2*sz, (uint8_t*)p->t + a1*n2*sz, (b1-a1)*n2*sz);
+         break;
+   }
+}
+
+/*!
+ * \brief
+ *    The main body of the multithreaded transforms.
+ */
+static void _fftp_mt (fft_mt_plan_t *p, void *x, void *X, uint8_t sgl, uint8_t inv)
+{
+   p->x = x;
+   p->X = X;
+   p->sgl = sgl;
+   p->inv = inv;
+   _fft_mt_run (p, _FFT_MT_TR1);
+   _fft_mt_run (p, _FFT_MT_ROW2);
+   _fft_mt_run (p, _FFT_MT_TR2);
+   _fft_mt_run (p, _FFT_MT_ROW1);
+   _fft_mt_run (p, _FFT_MT_TR3);
+   _fft_mt_run (p, _FFT_MT_COPY);
+}
+
+
+/*
+ * ============ Public multithreaded FFT API ============
+ */
+
+/*!
+ * \brief
+ *    Multithreaded FFT plan de-initialisation.
+ *    Stops the worker pool and frees all the tables.
+ *
+ * \param  p      Which plan to free
+ * \return none
+ */
+void fft_mt_plan_deinit (fft_mt_plan_t *p)
+{
+   if (p->th) {
+      _fft_mt_pool_stop (p, p->nt);
+      free ((void*)p->th);
+      pthread_cond_destroy (&p->done);
+      pthread_cond_destroy (&p->go);
+      pthread_mutex_destroy (&p->mx);
+   }
+   if (p->t)
+      free ((void*)p->t);
+   fft_plan_deinit (&p->p2);
+   fft_plan_deinit (&p->p1);
+   memset ((void*)p, 0, sizeof (fft_mt_plan_t));
+}
+
+/*!
+ * \brief
+ *    Multithreaded FFT plan initialisation.
+ *    For n >= FFT_MT_MIN_N, splits the transform to n = n1*n2 with n1 = 2^(m/2),
+ *    allocates the sub-plans, the scratch array and the twiddle tables, and
+ *    starts threads-1 workers. Smaller transforms use a plain plan of n points.
+ *
+ * \param  p         Which plan to use
+ * \param  n         Number of points. Must be a power of 2, greater or equal to 4
+ * \param  threads   The number of threads to use, including the caller.
+ *                   0 for the number of online processors
+ * \return           The number of points on success, 0 on failure
+ */
+uint32_t fft_mt_plan_init (fft_mt_plan_t *p, uint32_t n, uint32_t threads)
+{
+   uint32_t i, m, nh, nl;
+   long ncpu;
+
+   memset ((void*)p, 0, sizeof (fft_mt_plan_t));
+   if (n < 4 || (n & (n-1)))
+      return 0;
+   if (n < FFT_MT_MIN_N) {
+      p->n = n;
+      p->nt = 1;
+      return (fft_plan_init (&p->p1, n)) ? n : 0;
+   }
+   if (threads == 0)
+      threads = ((ncpu = sysconf (_SC_NPROCESSORS_ONLN)) > 0) ? (uint32_t)ncpu : 1;
+
+   // Split and sub-plans
+   m = _log2 (n);
+   p->n = n;
+   p->n1 = 1UL << (m/2);
+   p->n2 = n / p->n1;
+   p->h = m/2;
+   if (!fft_plan_init (&p->p1, p->n1) || !fft_plan_init (&p->p2, p->n2)) {
+      fft_mt_plan_deinit (p);
+      return 0;
+   }
+
+   // Scratch and twiddle tables in one block
+   nh = n >> p->h;
+   nl = 1UL << p->h;
+   if ((p->t = (complex_d_t*)malloc ((n + nh + nl)*sizeof (complex_d_t))) == NULL) {
+      fft_mt_plan_deinit (p);
+      return 0;
+   }
+   p->wh = &p->t[n];
+   p->wl = &p->wh[nh];
+   for (i=0 ; i<nh ; ++i)
+      p->wh[i] = cexp (-I*M_2PI*((double)i*nl)/n);
+   for (i=0 ; i<nl ; ++i)
+      p->wl[i] = cexp (-I*M_2PI*(double)i/n);
+
+   // Worker pool
+   p->nt = 1;
+   if (threads > 1) {
+      if ((p->th = (pthread_t*)calloc (threads-1, sizeof (pthread_t))) == NULL) {
+         fft_mt_plan_deinit (p);
+         return 0;
+      }
+      pthread_mutex_init (&p->mx, NULL);
+      pthread_cond_init (&p->go, NULL);
+      pthread_cond_init (&p->done, NULL);
+      for (i=0 ; i<threads-1 ; ++i) {
+         if (pthread_create (&p->th[i], NULL, _fft_mt_worker, (void*)p) != 0) {
+            // Keep the workers we have
+            break;
+         }
+      }
+      p->nt = i+1;
+   }
+   return n;
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision complex FFT using a multithreaded plan.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised multithreaded plan of n points
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        None
+ */
+void fftp_mt_c (fft_mt_plan_t *p, complex_d_t *x, complex_d_t *X) {
+   if (p->n < FFT_MT_MIN_N)   fftp_c (&p->p1, x, X);
+   else                       _fftp_mt (p, (void*)x, (void*)X, 0, 0);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision complex FFT using a multithreaded plan.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised multithreaded plan of n points
+ * \param   x     Pointer to size n time domain complex array
+ * \param   X     Pointer to size n frequency domain complex array
+ * \return        None
+ */
+void fftp_mt_cf (fft_mt_plan_t *p, complex_f_t *x, complex_f_t *X) {
+   if (p->n < FFT_MT_MIN_N)   fftp_cf (&p->p1, x, X);
+   else                       _fftp_mt (p, (void*)x, (void*)X, 1, 0);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision inverse complex FFT using a multithreaded plan.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised multithreaded plan of n points
+ * \param   X     Pointer to size n frequency domain complex array
+ * \param   x     Pointer to size n time domain complex array
+ * \return        None
+ */
+void ifftp_mt_c (fft_mt_plan_t *p, complex_d_t *X, complex_d_t *x) {
+   if (p->n < FFT_MT_MIN_N)   ifftp_c (&p->p1, X, x);
+   else                       _fftp_mt (p, (void*)X, (void*)x, 0, 1);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision inverse complex FFT using a multithreaded plan.
+ *    - Not in-place.   Use pointers to different arrays for time and freq
+ *    - In-place        Use the same pointer for time and frequency
+ *
+ * \param   p     Pointer to an initialised multithreaded plan of n points
+ * \param   X     Pointer to size n frequency domain complex array
+ * \param   x     Pointer to size n time domain complex array
+ * \return        None
+ */
+void ifftp_mt_cf (fft_mt_plan_t *p, complex_f_t *X, complex_f_t *x) {
+   if (p->n < FFT_MT_MIN_N)   ifftp_cf (&p->p1, X, x);
+   else                       _fftp_mt (p, (void*)X, (void*)x, 1, 1);
+}
+
+#endif   // #ifdef TBX_THREADS
@@ -0,0 +1,220 @@
+/*!
+ * \file filter_cic.c
+ * \brief
+ *    An exact integer CIC (cascaded integrator-comb) filter implementation.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2015 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <dsp/filter_cic.h>
+
+/*
+ * =================== Public API =====================
+ */
+
+/*!
+ * \brief
+ *    CIC filter de-initialisation.
+ *    The memory of a filter from filter_cic_init_static() stays to the caller.
+ *
+ * \param  f      Which filter to free
+ * \return none
+*/
+void filter_cic_deinit (filter_cic_t *f) {
+   if ( f->blk )
+      free (f->blk);
+   memset ((void*)f, 0, sizeof (filter_cic_t));
+}
+
+/*!
+ * \brief
+ *    Get the memory size of a CIC filter, for filter_cic_init_static().
+ *
+ * \param  N      The number of stages
+ * \param  M      The differential delay
+ * \return        The size in bytes
+ */
+size_t filter_cic_required_size (uint32_t N, uint32_t M) {
+   return ARENA_SIZE ((size_t)N*M*sizeof (uint64_t));
+}
+
+/*!
+ * \brief
+ *    CIC filter initialisation.
+ *
+ * \param  f      Which filter to use
+ * \param  N      The number of stages [1 .. FILTER_CIC_MAX_STAGES]
+ * \param  R      The decimation factor, 1 for no decimation
+ * \param  M      The differential delay, in output samples
+ * \return        The number of stages on success, 0 on failure
+ */
+uint32_t filter_cic_init (filter_cic_t *f, uint32_t N, uint32_t R, uint32_t M)
+{
+   size_t sz = filter_cic_required_size (N, M);
+   void *mem;
+
+   memset ((void*)f, 0, sizeof (filter_cic_t));
+   if (!sz || (mem = malloc (sz)) == NULL)
+      return 0;
+   if (filter_cic_init_static (f, N, R, M, mem, sz) == 0) {
+      free (mem);
+      return 0;
+   }
+   f->blk = mem;
+   return f->N;
+}
+
+/*!
+ * \brief
+ *    CIC filter initialisation over caller supplied memory, with no heap
+ *    use. The memory must stay valid for the life of the filter and is
+ *    not freed by filter_cic_deinit().
+ *
+ * \param  f      Which filter to use
+ * \param  N      The number of stages [1 .. FILTER_CIC_MAX_STAGES]
+ * \param  R      The decimation factor, 1 for no decimation
+ * \param  M      The differential delay, in output samples
+ * \param  mem    Pointer to memory, aligned to 8 bytes
+ * \param  size   The size of the memory, at least filter_cic_required_size()
+ * \return        The number of stages on success, 0 on failure. The gain
+ *                (R*M)^N must fit in 64 - FILTER_CIC_INPUT_BITS bits.
+ */
+uint32_t filter_cic_init_static (filter_cic_t *f, uint32_t N, uint32_t R, uint32_t M, void *mem, size_t size)
+{
+   uint64_t G, RM = (uint64_t)R*M;
+   uint32_t s;
+
+   memset ((void*)f, 0, sizeof (filter_cic_t));
+   if (!N || N > FILTER_CIC_MAX_STAGES || !R || !M)
+      return 0;
+   if (!mem || size < (size_t)N*M*sizeof (uint64_t))
+      return 0;
+
+   // Check the register growth
+   for (G=1, s=0 ; s<N ; ++s) {
+      if (G > ((uint64_t)1 << (64 - FILTER_CIC_INPUT_BITS)) / RM)
+         return 0;
+      G *= RM;
+   }
+   f->c = (uint64_t*)mem;
+   f->G = G;
+   f->N = N;
+   f->R = R;
+   f->M = M;
+   filter_cic_reset (f);
+   return f->N;
+}
+
+/*!
+ * \brief
+ *    Clears the filter history. The next output comes after R inputs.
+ *
+ * \param  f      Which filter to use
+ * \return        None
+ */
+void filter_cic_reset (filter_cic_t *f) {
+   memset ((void*)f->c, 0, f->N*f->M*sizeof (uint64_t));
+   memset ((void*)f->i, 0, sizeof (f->i));
+   f->r = f->ci = 0;
+}
+
+/*!
+ * \brief
+ *    The number of outputs the next filter_cic() call of n inputs produces.
+ *    Use it to size the output block.
+ *
+ * \param  f      Which filter to use
+ * \param  n      The number of inputs
+ * \return        The number of outputs
+ */
+uint32_t filter_cic_outputs (filter_cic_t *f, uint32_t n) {
+   return (uint32_t)(((uint64_t)f->r + n) / f->R);
+}
+
+/*!
+ * \brief
+ *    The CIC filter body. The state is kept in locals for the whole block
+ *    and the integrators and combs are modulo 2^64 unsigned arithmetic.
+ *
+ * \param   _out     The output expression of the comb result y
+ */
+#define  _filter_cic_body(_out) {                           \
+   uint64_t it[FILTER_CIC_MAX_STAGES], y, d, *c = f->c;     \
+   uint32_t i, s, m, N = f->N, R = f->R, M = f->M;          \
+   uint32_t r = f->r, ci = f->ci;                           \
+                                                            \
+   for (s=0 ; s<N ; ++s)                                    \
+      it[s] = f->i[s];                                      \
+   for (i=m=0 ; i<n ; ++i) {                                \
+      /* Integrators at the input rate */                   \
+      y = (uint64_t)(int64_t)in[i];                         \
+      for (s=0 ; s<N ; ++s)                                 \
+         y = it[s] += y;                                    \
+      if (++r < R)                                          \
+         continue;                                          \
+      r = 0;                                                \
+      /* Combs at the output rate */                        \
+      for (s=0 ; s<N ; ++s) {                               \
+         d = c[s*M + ci];                                   \
+         c[s*M + ci] = y;                                   \
+         y -= d;                                            \
+      }                                                     \
+      if (++ci >= M)                                        \
+         ci = 0;                                            \
+      out[m++] = _out;                                      \
+   }                                                        \
+   for (s=0 ; s<N ; ++s)                                    \
+      f->i[s] = it[s];                                      \
+   f->r = r;                                                \
+   f->ci = ci;                                              \
+   return m;                                                \
+}
+
+/*!
+ * \brief
+ *    Integer CIC filtering of a block of any size.
+ *    The outputs are exact and carry the gain of the filter, f->G.
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  n      The input block size
+ * \param  out    Pointer to the output block, filter_cic_outputs(f, n) items
+ * \return        The number of outputs
+ */
+uint32_t filter_cic (filter_cic_t *f, const int32_t *in, uint32_t n, int64_t *out) {
+   _filter_cic_body ((int64_t)y);
+}
+
+/*!
+ * \brief
+ *    CIC filtering of a block of any size, with the outputs normalised
+ *    to unity gain. The filter runs in integers as filter_cic().
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  n      The input block size
+ * \param  out    Pointer to the output block, filter_cic_outputs(f, n) items
+ * \return        The number of outputs
+ */
+uint32_t filter_cic_d (filter_cic_t *f, const int32_t *in, uint32_t n, double *out) {
+   double g = 1.0 / f->G;
+   _filter_cic_body ((double)(int64_t)y * g);
+}
+
+#undef _filter_cic_body
@@ -70,41 +70,77 @@ void filter_mova_set_fc (filter_mova_t *f, double fc) {
 /*!
  * \brief
  *    Moving Average filter de-initialisation.
+ *    The memory of a filter from filter_mova_init_static() stays to the caller.
  *
  * \param  f      Which filter to free
  * \return none
 */
 void filter_mova_deinit (filter_mova_t* f) {
-   if ( f->bf )
-      free ((void*)f->bf);
+   if ( f->blk )
+      free (f->blk);
    memset ((void*)f, 0, sizeof (filter_mova_t));
 }
 
+/*!
+ * \brief
+ *    Get the memory size of the filter, for filter_mova_init_static().
+ *    The item size and the cut-off frequency must be set first.
+ *
+ * \param  f      Which filter to use
+ * \return        The size in bytes, 0 if the filter is not set
+ */
+size_t filter_mova_required_size (filter_mova_t* f) {
+   return ARENA_SIZE ((size_t)f->N * f->it_size);
+}
+
 /*!
  * \brief
  *    Moving Average filter initialisation.
  *
  * \param  f      Which filter to use
- * \param  fc     The normalised cutoff frequency [0fs - 0.5fs]
- * \return        None
+ * \return        The number of samples on success, 0 on failure
  */
 uint32_t filter_mova_init (filter_mova_t* f)
 {
-   // Check sample points for cutoff frequency
-   if (f->N == 0)
-      return 0;
+   size_t sz = filter_mova_required_size (f);
+   void *mem;
 
-   // Try to allocate memory
-   if ( (f->bf = (void*)calloc (f->N, f->it_size)) != NULL ) {
-      // Clear accumulator and cursor
-      memset ((void*)f->last, 0, FILTER_MOVA_LAST_SIZE);
-      f->c = 0;
-      return f->N;
-   }
-   else
+   // Check sample points for cutoff frequency and try to allocate memory
+   if (!sz || (mem = malloc (sz)) == NULL)
+      return 0;
+   if (filter_mova_init_static (f, mem, sz) == 0) {
+      free (mem);
       return 0;
+   }
+   f->blk = mem;
+   return f->N;
 }
 
+/*!
+ * \brief
+ *    Moving Average filter initialisation over caller supplied memory,
+ *    with no heap use. The memory must stay valid for the life of the
+ *    filter and is not freed by filter_mova_deinit().
+ *
+ * \param  f      Which filter to use
+ * \param  mem    Pointer to memory, aligned for the item type
+ * \param  size   The size of the memory, at least filter_mova_required_size()
+ * \return        The number of samples on success, 0 on failure
+ */
+uint32_t filter_mova_init_static (filter_mova_t* f, void *mem, size_t size)
+{
+   // Check sample points for cutoff frequency and the memory
+   if (f->N == 0 || mem == NULL || size < (size_t)f->N * f->it_size)
+      return 0;
+
+   f->bf = mem;
+   f->blk = NULL;
+   memset (f->bf, 0, (size_t)f->N * f->it_size);
+   // Clear accumulator and cursor
+   memset ((void*)f->last, 0, FILTER_MOVA_LAST_SIZE);
+   f->c = 0;
+   return f->N;
+}
 
 
 /*!
@@ -215,6 +251,297 @@ complex_f_t filter_mova_ci (filter_mova_t* f, complex_i_t in) {
    _filter_body(_complex_f, _complex_i);
 }
 
+/*!
+ * \brief
+ *    Recursive moving average algorithm over a block.
+ *    The state is kept in locals and the buffer is walked in runs up to
+ *    its end, so there is no cursor check per sample. The results are
+ *    the same as of the per-sample functions.
+ *
+ * \param   _rtype   The output (accumulator) type
+ * \param   _type    The input type
+ */
+#define  _filter_block_body(_rtype, _type)  {                  \
+   _type *bf = (_type*)f->bf, x, dep;                          \
+   _rtype acc;                                                 \
+   uint32_t i, j, run, c = f->c, N = f->N;                     \
+                                                               \
+   memcpy ((void*)&acc, (void*)f->last, sizeof (_rtype));      \
+   for (i=0 ; i<n ; i+=run) {                                  \
+      run = (N - c < n - i) ? N - c : n - i;                   \
+      for (j=0 ; j<run ; ++j) {                                \
+         x = in[i+j];                                          \
+         dep = bf[c+j];          /* Save departed point */     \
+         bf[c+j] = x;            /* Get new value */           \
+         out[i+j] = acc += (_rtype)(x - dep)/N;                \
+      }                                                        \
+      if ((c += run) >= N)                                     \
+         c = 0;                                                \
+   }                                                           \
+   memcpy ((void*)f->last, (void*)&acc, sizeof (_rtype));      \
+   f->c = c;                                                   \
+}
+
+/*!
+ * \brief
+ *    Double precision recursive Moving Average filter of a block.
+ *    Output = Moving_Average (Input)
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block. Can be the same as in
+ * \param  n      The block size
+ * \return        None
+ */
+void filter_mova_block_d (filter_mova_t* f, double *in, double *out, uint32_t n) {
+   _filter_block_body(_double, _double);
+}
+
+/*!
+ * \brief
+ *    Single precision recursive Moving Average filter of a block.
+ *    Output = Moving_Average (Input)
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block. Can be the same as in
+ * \param  n      The block size
+ * \return        None
+ */
+void filter_mova_block_f (filter_mova_t* f, float *in, float *out, uint32_t n) {
+   _filter_block_body(_float, _float);
+}
+
+/*!
+ * \brief
+ *    Integer recursive Moving Average filter of a block, to
+ *    single precision float.
+ *    Output = Moving_Average (Input)
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block
+ * \param  n      The block size
+ * \return        None
+ */
+void filter_mova_block_i (filter_mova_t* f, int *in, float *out, uint32_t n) {
+   _filter_block_body(_float, _int);
+}
+
+/*!
+ * \brief
+ *    Double precision complex recursive Moving Average filter of a block.
+ *    Output = Moving_Average (Input)
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block. Can be the same as in
+ * \param  n      The block size
+ * \return        None
+ */
+void filter_mova_block_cd (filter_mova_t* f, complex_d_t *in, complex_d_t *out, uint32_t n) {
+   _filter_block_body(_complex_d, _complex_d);
+}
+
+/*!
+ * \brief
+ *    Single precision complex recursive Moving Average filter of a block.
+ *    Output = Moving_Average (Input)
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block. Can be the same as in
+ * \param  n      The block size
+ * \return        None
+ */
+void filter_mova_block_cf (filter_mova_t* f, complex_f_t *in, complex_f_t *out, uint32_t n) {
+   _filter_block_body(_complex_f, _complex_f);
+}
+
+/*!
+ * \brief
+ *    Integer complex recursive Moving Average filter of a block, to
+ *    single precision complex.
+ *    Output = Moving_Average (Input)
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block
+ * \param  n      The block size
+ * \return        None
+ */
+void filter_mova_block_ci (filter_mova_t* f, complex_i_t *in, complex_f_t *out, uint32_t n) {
+   _filter_block_body(_complex_f, _complex_i);
+}
+
+/*!
+ * \brief
+ *    Recursive moving average algorithm over a bank of ch filters of
+ *    interleaved frames. The channels are updated in lock-step, a frame
+ *    at a time, FILTER_MOVA_BANK_BLK channels per pass, with their
+ *    accumulators and cursors in locals. Channels of the same length and
+ *    cursor share one cursor. The results are the same as of the
+ *    per-sample functions.
+ *
+ * \param   _rtype   The output (accumulator) type
+ * \param   _type    The input type
+ */
+#define  _filter_bank_body(_rtype, _type)  {                   \
+   _type *bf[FILTER_MOVA_BANK_BLK], x, dep;                    \
+   _rtype acc[FILTER_MOVA_BANK_BLK];                           \
+   uint32_t c[FILTER_MOVA_BANK_BLK], N[FILTER_MOVA_BANK_BLK];  \
+   uint32_t i, k, k0, m, cs, Ns, same;                         \
+                                                               \
+   for (k0=0 ; k0<ch ; k0+=m) {                                \
+      m = (ch - k0 < FILTER_MOVA_BANK_BLK) ? ch - k0 : FILTER_MOVA_BANK_BLK; \
+      for (same=1, k=0 ; k<m ; ++k) {                          \
+         bf[k] = (_type*)f[k0+k].bf;                           \
+         memcpy ((void*)&acc[k], (void*)f[k0+k].last, sizeof (_rtype)); \
+         c[k] = f[k0+k].c;                                     \
+         N[k] = f[k0+k].N;                                     \
+         same &= (N[k] == N[0] && c[k] == c[0]);               \
+      }                                                        \
+      if (same) {                                              \
+         /* Shared length and cursor */                        \
+         cs = c[0];                                            \
+         Ns = N[0];                                            \
+         for (i=0 ; i<n ; ++i) {                               \
+            for (k=0 ; k<m ; ++k) {                            \
+               x = in[i*ch + k0+k];                            \
+               dep = bf[k][cs];                                \
+               bf[k][cs] = x;                                  \
+               out[i*ch + k0+k] = acc[k] += (_rtype)(x - dep)/Ns; \
+            }                                                  \
+            if (++cs >= Ns)                                    \
+               cs = 0;                                         \
+         }                                                     \
+         for (k=0 ; k<m ; ++k)                                 \
+            c[k] = cs;                                         \
+      }                                                        \
+      else {                                                   \
+         for (i=0 ; i<n ; ++i) {                               \
+            for (k=0 ; k<m ; ++k) {                            \
+               x = in[i*ch + k0+k];                            \
+               dep = bf[k][c[k]];                              \
+               bf[k][c[k]] = x;                                \
+               out[i*ch + k0+k] = acc[k] += (_rtype)(x - dep)/N[k]; \
+               if (++c[k] >= N[k])                             \
+                  c[k] = 0;                                    \
+            }                                                  \
+         }                                                     \
+      }                                                        \
+      for (k=0 ; k<m ; ++k) {                                  \
+         memcpy ((void*)f[k0+k].last, (void*)&acc[k], sizeof (_rtype)); \
+         f[k0+k].c = c[k];                                     \
+      }                                                        \
+   }                                                           \
+}
+
+/*!
+ * \brief
+ *    Double precision recursive Moving Average filter bank.
+ *    Filters ch channels of interleaved frames, in[i*ch + k] is the
+ *    sample i of channel k, each one with its own filter f[k].
+ *
+ * \param  f      Pointer to an array of ch initialised filters
+ * \param  ch     The number of channels
+ * \param  in     Pointer to the input frames, n*ch items
+ * \param  out    Pointer to the output frames, n*ch items. Can be the same as in
+ * \param  n      The number of frames
+ * \return        None
+ */
+void filter_mova_bank_d (filter_mova_t* f, uint32_t ch, double *in, double *out, uint32_t n) {
+   _filter_bank_body(_double, _double);
+}
+
+/*!
+ * \brief
+ *    Single precision recursive Moving Average filter bank.
+ *    Filters ch channels of interleaved frames, in[i*ch + k] is the
+ *    sample i of channel k, each one with its own filter f[k].
+ *
+ * \param  f      Pointer to an array of ch initialised filters
+ * \param  ch     The number of channels
+ * \param  in     Pointer to the input frames, n*ch items
+ * \param  out    Pointer to the output frames, n*ch items. Can be the same as in
+ * \param  n      The number of frames
+ * \return        None
+ */
+void filter_mova_bank_f (filter_mova_t* f, uint32_t ch, float *in, float *out, uint32_t n) {
+   _filter_bank_body(_float, _float);
+}
+
+/*!
+ * \brief
+ *    Integer recursive Moving Average filter bank, to single precision float.
+ *    Filters ch channels of interleaved frames, in[i*ch + k] is the
+ *    sample i of channel k, each one with its own filter f[k].
+ *
+ * \param  f      Pointer to an array of ch initialised filters
+ * \param  ch     The number of channels
+ * \param  in     Pointer to the input frames, n*ch items
+ * \param  out    Pointer to the output frames, n*ch items
+ * \param  n      The number of frames
+ * \return        None
+ */
+void filter_mova_bank_i (filter_mova_t* f, uint32_t ch, int *in, float *out, uint32_t n) {
+   _filter_bank_body(_float, _int);
+}
+
+/*!
+ * \brief
+ *    Double precision complex recursive Moving Average filter bank.
+ *    Filters ch channels of interleaved frames, in[i*ch + k] is the
+ *    sample i of channel k, each one with its own filter f[k].
+ *
+ * \param  f      Pointer to an array of ch initialised filters
+ * \param  ch     The number of channels
+ * \param  in     Pointer to the input frames, n*ch items
+ * \param  out    Pointer to the output frames, n*ch items. Can be the same as in
+ * \param  n      The number of frames
+ * \return        None
+ */
+void filter_mova_bank_cd (filter_mova_t* f, uint32_t ch, complex_d_t *in, complex_d_t *out, uint32_t n) {
+   _filter_bank_body(_complex_d, _complex_d);
+}
+
+/*!
+ * \brief
+ *    Single precision complex recursive Moving Average filter bank.
+ *    Filters ch channels of interleaved frames, in[i*ch + k] is the
+ *    sample i of channel k, each one with its own filter f[k].
+ *
+ * \param  f      Pointer to an array of ch initialised filters
+ * \param  ch     The number of channels
+ * \param  in     Pointer to the input frames, n*ch items
+ * \param  out    Pointer to the output frames, n*ch items. Can be the same as in
+ * \param  n      The number of frames
+ * \return        None
+ */
+void filter_mova_bank_cf (filter_mova_t* f, uint32_t ch, complex_f_t *in, complex_f_t *out, uint32_t n) {
+   _filter_bank_body(_complex_f, _complex_f);
+}
+
+/*!
+ * \brief
+ *    Integer complex recursive Moving Average filter bank, to single
+ *    precision complex.
+ *    Filters ch channels of interleaved frames, in[i*ch + k] is the
+ *    sample i of channel k, each one with its own filter f[k].
+ *
+ * \param  f      Pointer to an array of ch initialised filters
+ * \param  ch     The number of channels
+ * \param  in     Pointer to the input frames, n*ch items
+ * \param  out    Pointer to the output frames, n*ch items
+ * \param  n      The number of frames
+ * \return        None
+ */
+void filter_mova_bank_ci (filter_mova_t* f, uint32_t ch, complex_i_t *in, complex_f_t *out, uint32_t n) {
+   _filter_bank_body(_complex_f, _complex_i);
+}
+
+#undef   _filter_bank_body
+#undef   _filter_block_body
 #undef   _filter_body
 #undef  _double
 #undef  _float
@@ -69,7 +69,7 @@ static uint32_t _first_pow2_ge (uint32_t x) {
 }
 
 
-static void _1tran_loop (fir_wsinc_t *f, int sign) {
+static void _1tran_loop (fir_wsinc_t *f, double *k, int sign) {
    uint32_t i, sT, n_2;
    int32_t  n;
    double fact;
@@ -88,21 +88,21 @@ static void _1tran_loop (fir_wsinc_t *f, int sign) {
    n_2 = sT>>1;   // Take the half and make it even
    for (fact=i=0 ; i<=n_2 ; ++i) {
       n = i - n_2;
-      f->k[i] = _sinc (f->fc1, n) * f->W (i, sT-1);
-      fact += f->k[i] * 2;
-      f->k[sT - 1 - i] = (f->k[i] *= sign);
+      k[i] = _sinc (f->fc1, n) * f->W (i, sT-1);
+      fact += k[i] * 2;
+      k[sT - 1 - i] = (k[i] *= sign);
    }
-   fact -= f->k[n_2]*sign;
+   fact -= k[n_2]*sign;
    fact = 1/fact;
    // Apply normalise factor
    for (i=0 ; i<=sT ; ++i)
-      f->k[i] *= fact;
+      k[i] *= fact;
 
    // invert symmetry point if needed
-   f->k[n_2] += (sign==-1) ? 1:0;
+   k[n_2] += (sign==-1) ? 1:0;
 }
 
-static void _2tran_loop (fir_wsinc_t *f, int sign) {
+static void _2tran_loop (fir_wsinc_t *f, double *k, int sign) {
    uint32_t i, sT, n_2;
    int32_t  n;
    double fact;
@@ -120,19 +120,406 @@ static void _2tran_loop (fir_wsinc_t *f, int sign) {
    n_2 = sT>>1;   // Take the half and make it even
    for (fact=i=0 ; i<=n_2 ; ++i) {
       n = i - n_2;
-      f->k[i] = ( _sinc (f->fc1, n) * f->W (i, sT-1) +
+      k[i] = ( _sinc (f->fc1, n) * f->W (i, sT-1) +
                   _sinc (f->fc2, n) * f->W (i, sT-1) );
-      fact += f->k[i] * 2;
-      f->k[sT - 1 - i] = (f->k[i] *= sign);
+      fact += k[i] * 2;
+      k[sT - 1 - i] = (k[i] *= sign);
    }
-   fact -= f->k[n_2]*sign;
+   fact -= k[n_2]*sign;
    fact = 1/fact;
    // Apply normalise factor
    for (i=0 ; i<=sT ; ++i)
-      f->k[i] *= fact;
+      k[i] *= fact;
 
    // invert symmetry point if needed
-   f->k[n_2] += (sign==-1) ? 1:0;
+   k[n_2] += (sign==-1) ? 1:0;
+}
+
+/*
+ * ============ Kernel cache ============
+ */
+
+/*!
+ * A designed kernel, shared read-only by all the filters with the same design.
+ * Entries with no users are kept for later inits, until their slot is needed.
+ */
+typedef struct {
+   fir_ftype_en   ftype;   //!< The filter type
+   fir_wtype_en   wtype;   //!< The window type
+   fir_wsinc_prec_en prec; //!< The spectrum storage type
+   double         fc1, fc2;//!< The transition frequencies
+   double         tb;      //!< The transition bandwidth
+   uint32_t       casc;    //!< The number of cascade filters
+   uint32_t       N;       //!< The number of kernel points in frequency domain
+   uint32_t       T;       //!< The number of taps
+   int            ke;      //!< The block exponent of a Q15 spectrum
+   void           *k;      //!< The kernel spectrum, N complex points
+   double         *h;      //!< The time domain kernel, T taps
+   uint32_t       refs;    //!< The number of filters using the entry
+}_fir_wsinc_kc_t;
+
+static _fir_wsinc_kc_t _kc[FIR_WSINC_CACHE_SIZE];
+
+#ifdef TBX_THREADS
+#include <pthread.h>
+static pthread_mutex_t _kc_mx = PTHREAD_MUTEX_INITIALIZER;
+#define  _kc_lock()     pthread_mutex_lock (&_kc_mx)
+#define  _kc_unlock()   pthread_mutex_unlock (&_kc_mx)
+#else
+#define  _kc_lock()
+#define  _kc_unlock()
+#endif
+
+static int _kc_match (_fir_wsinc_kc_t *e, fir_wsinc_t *f) {
+   return e->k && e->ftype == f->ftype && e->wtype == f->wtype &&
+          e->prec == f->prec && e->fc1 == f->fc1 && e->fc2 == f->fc2 &&
+          e->tb == f->tb && e->casc == f->casc && e->N == f->N;
+}
+
+/*!
+ * \brief
+ *    Find the design of f in the cache and share it with f.
+ *    Must be called with the cache locked.
+ * \return  The entry or NULL
+ */
+static _fir_wsinc_kc_t* _kc_find (fir_wsinc_t *f) {
+   uint32_t i;
+   for (i=0 ; i<FIR_WSINC_CACHE_SIZE ; ++i) {
+      if (_kc_match (&_kc[i], f)) {
+         ++_kc[i].refs;
+         f->k = _kc[i].k;  f->h = _kc[i].h;
+         f->T = _kc[i].T;  f->ke = _kc[i].ke;
+         f->kc = (void*)&_kc[i];
+         return &_kc[i];
+      }
+   }
+   return NULL;
+}
+
+/*!
+ * \brief
+ *    Find a free or unused cache entry for a new kernel, freeing
+ *    the kernel it holds. Must be called with the cache locked.
+ * \return  The entry or NULL if the cache is full. In that case the
+ *          kernel of the new filter stays private.
+ */
+static _fir_wsinc_kc_t* _kc_slot (void) {
+   _fir_wsinc_kc_t *e = NULL;
+   uint32_t i;
+   for (i=0 ; i<FIR_WSINC_CACHE_SIZE ; ++i) {
+      if (!_kc[i].k)       { e = &_kc[i]; break; }
+      if (!_kc[i].refs)    e = &_kc[i];
+   }
+   if (e && e->k) {
+      free (e->k);
+      free ((void*)e->h);
+      memset ((void*)e, 0, sizeof (_fir_wsinc_kc_t));
+   }
+   return e;
+}
+
+/*!
+ * \brief
+ *    Move the heap kernel of f to the cache entry e, from _kc_slot().
+ *    Must be called with the cache locked.
+ */
+static void _kc_insert (fir_wsinc_t *f, _fir_wsinc_kc_t *e) {
+   e->ftype = f->ftype;    e->wtype = f->wtype;
+   e->prec = f->prec;      e->fc1 = f->fc1;
+   e->fc2 = f->fc2;        e->tb = f->tb;
+   e->casc = f->casc;      e->N = f->N;
+   e->T = f->T;            e->ke = f->ke;
+   e->k = f->k;            e->h = f->h;
+   e->refs = 1;
+   f->kc = (void*)e;
+}
+
+/*!
+ * \brief
+ *    The size of one spectrum point for each storage type
+ */
+static uint32_t _fir_wsinc_ksize (fir_wsinc_prec_en prec) {
+   switch (prec) {
+      default:
+      case FIR_WSINC_DOUBLE:  return sizeof (complex_d_t);
+      case FIR_WSINC_FLOAT:   return sizeof (complex_f_t);
+      case FIR_WSINC_Q15:     return sizeof (complex_q15_t);
+   }
+}
+
+/*!
+ * \brief
+ *    Convert a double precision spectrum to the Q15 storage of f.
+ *    The spectrum is scaled by 2^-ke, so its largest component fits in Q15.
+ */
+static void _fir_wsinc_to_q15 (fir_wsinc_t *f, complex_d_t *K) {
+   complex_q15_t *kq = (complex_q15_t*)f->k;
+   double mx = 0, sc;
+   uint32_t i;
+
+   for (i=0 ; i<f->N ; ++i) {
+      if (fabs (creal (K[i])) > mx)    mx = fabs (creal (K[i]));
+      if (fabs (cimag (K[i])) > mx)    mx = fabs (cimag (K[i]));
+   }
+   for (f->ke = 0 ; mx >= 32767./32768 ; mx /= 2)
+      ++f->ke;
+   sc = 32768. / (1 << f->ke);
+   for (i=0 ; i<f->N ; ++i) {
+      realq15 (kq[i]) = (int16_t)lround (creal (K[i]) * sc);
+      imagq15 (kq[i]) = (int16_t)lround (cimag (K[i]) * sc);
+   }
+}
+
+/*!
+ * \brief
+ *    Calculate the final number of taps and the kernel points in frequency
+ *    domain of f, as the design will round them, so the memory can be
+ *    sized before the design.
+ */
+static void _fir_wsinc_dims (fir_wsinc_t *f) {
+   uint32_t sT;
+
+   // Calculate taps in time domain
+   f->T = f->tp(f->casc, f->tb);
+   if (f->T < FIR_WSINC_MIN_TAPS)    f->T = FIR_WSINC_MIN_TAPS;
+
+   // Calculate kernel points in frequency domain
+   f->N = _first_pow2_ge (2*f->T);
+
+   // The taps of each cascade stage, odd for the single transition filters
+   sT = (f->T + f->casc - 1)/f->casc;
+   if (f->ftype == FIR_LOW_PASS || f->ftype == FIR_HIGH_PASS)
+      sT += (sT%2) ? 0:1;
+   f->T = f->casc * sT - (f->casc - 1);
+}
+
+/*!
+ * \brief
+ *    Direct convolution y = h * x of the cascade stages, to sh+sx-1 outputs.
+ *    conv_d() is not used as its FFT path takes a plan from the heap.
+ */
+static void _cascade (double *y, const double *h, uint32_t sh, const double *x, uint32_t sx) {
+   uint32_t n, j;
+
+   memset ((void*)y, 0, (sh+sx-1)*sizeof (double));
+   for (j=0 ; j<sh ; ++j)
+      for (n=0 ; n<sx ; ++n)
+         y[n+j] += h[j]*x[n];
+}
+
+/*!
+ * \brief
+ *    Design the kernel of f, in time and frequency domain, to f->h and f->k.
+ *    The design runs in double precision and the spectrum is then converted
+ *    to the storage type of f.
+ *
+ * \param  f      Which filter to use
+ * \param  k      Pointer to cleared scratch memory of 4N doubles
+ * \return        None
+ */
+static void _fir_wsinc_design (fir_wsinc_t *f, double *k) {
+   double *t = &k[2*f->N];
+   uint32_t i, sT, len;
+
+   // Despatch based on filter type
+   switch (f->ftype) {
+      default:
+      case FIR_LOW_PASS:
+         _1tran_loop (f, k, 1);
+         break;
+      case FIR_HIGH_PASS:
+         _1tran_loop (f, k, -1);
+         break;
+      case FIR_BAND_REJECT:
+         _2tran_loop (f, k, 1);
+         break;
+      case FIR_BAND_PASS:
+         _2tran_loop (f, k, -1);
+         break;
+   }
+
+   // Cascade filters in time domain for the streaming functions
+   sT = (f->T + f->casc - 1)/f->casc;
+   memcpy ((void*)f->h, (void*)k, sT*sizeof (double));
+   for (len=sT, i=1 ; i<f->casc ; ++i, len+=sT-1) {
+      _cascade (t, k, sT, f->h, len);
+      memcpy ((void*)f->h, (void*)t, (len+sT-1)*sizeof (double));
+   }
+
+   // Go to Frequency domain, with the cascaded kernel
+   memset ((void*)k, 0, 2*f->N*sizeof (double));
+   memcpy ((void*)k, (void*)f->h, f->T*sizeof (double));
+   fft_r (k, (complex_d_t*)k, f->N);
+   switch (f->prec) {
+      default:
+      case FIR_WSINC_DOUBLE:
+         memcpy (f->k, (void*)k, f->N*sizeof (complex_d_t));
+         break;
+      case FIR_WSINC_FLOAT:
+         for (i=0 ; i<f->N ; ++i)
+            ((complex_f_t*)f->k)[i] = (complex_f_t)((complex_d_t*)k)[i];
+         break;
+      case FIR_WSINC_Q15:
+         _fir_wsinc_to_q15 (f, (complex_d_t*)k);
+         break;
+   }
+}
+
+/*!
+ * \brief
+ *    Design the kernel of f to the heap, for the cache.
+ * \return  The number of kernel points in frequency domain, 0 on failure
+ */
+static uint32_t _fir_wsinc_design_heap (fir_wsinc_t *f) {
+   double *k = (double*)calloc (4*f->N, sizeof (double));
+
+   f->h = (double*)calloc (f->T, sizeof (double));
+   f->k = malloc (f->N * _fir_wsinc_ksize (f->prec));
+   if (k && f->h && f->k) {
+      _fir_wsinc_design (f, k);
+      free ((void*)k);
+      return f->N;
+   }
+   free ((void*)k);
+   free ((void*)f->h);
+   free (f->k);
+   f->h = NULL;
+   f->k = NULL;
+   return 0;
+}
+
+/*!
+ * \brief
+ *    The memory size of the per filter buffers of f
+ */
+static size_t _fir_wsinc_setup_size (fir_wsinc_t *f) {
+   switch (f->prec) {
+      default:
+      case FIR_WSINC_DOUBLE:
+         return ARENA_SIZE (2*f->N*sizeof (double))
+              + ARENA_SIZE (2*f->T*sizeof (complex_d_t))
+              + conv_stream_required_size_d (f->T, CONV_STREAM_AUTO);
+      case FIR_WSINC_FLOAT:
+         return ARENA_SIZE (2*f->N*sizeof (float))
+              + ARENA_SIZE (2*f->T*sizeof (complex_f_t))
+              + conv_stream_required_size_f (f->T, CONV_STREAM_AUTO);
+      case FIR_WSINC_Q15:
+         return ARENA_SIZE (f->N*sizeof (complex_q15_t))
+              + ARENA_SIZE (2*f->T*sizeof (complex_d_t))
+              + conv_stream_required_size_d (f->T, CONV_STREAM_AUTO)
+              + fft_plan_fixed_required_size (f->N);
+   }
+}
+
+/*!
+ * \brief
+ *    The memory size of f. A private kernel comes first and its design
+ *    scratch shares the space of the per filter buffers.
+ */
+static size_t _fir_wsinc_size (fir_wsinc_t *f) {
+   size_t su = _fir_wsinc_setup_size (f);
+   size_t sc = ARENA_SIZE (4*f->N*sizeof (double));
+
+   if (f->kc)
+      return su;
+   return ARENA_SIZE (f->T*sizeof (double))
+        + ARENA_SIZE (f->N*_fir_wsinc_ksize (f->prec))
+        + ((su > sc) ? su : sc);
+}
+
+/*!
+ * \brief
+ *    Place the per filter buffers of f, after its kernel is in place.
+ *    The scratch array, the delay line and the block streaming state are
+ *    single precision for FLOAT filters and double precision for the others.
+ * \return  The number of kernel points in frequency domain, 0 on failure
+ */
+static uint32_t _fir_wsinc_setup (fir_wsinc_t *f, arena_t *a) {
+   uint32_t i;
+   size_t sz;
+
+   switch (f->prec) {
+      default:
+      case FIR_WSINC_DOUBLE:
+         sz = conv_stream_required_size_d (f->T, CONV_STREAM_AUTO);
+         if ( (f->t = arena_calloc (a, 2*f->N*sizeof (double))) == NULL ||
+              (f->d = arena_calloc (a, 2*f->T*sizeof (complex_d_t))) == NULL ||
+              !conv_stream_init_static_d (&f->s, f->h, f->T, CONV_STREAM_AUTO, arena_alloc (a, sz), sz) )
+            return 0;
+         break;
+      case FIR_WSINC_FLOAT:
+         sz = conv_stream_required_size_f (f->T, CONV_STREAM_AUTO);
+         if ( (f->t = arena_calloc (a, 2*f->N*sizeof (float))) == NULL ||
+              (f->d = arena_calloc (a, 2*f->T*sizeof (complex_f_t))) == NULL )
+            return 0;
+         for (i=0 ; i<f->T ; ++i)
+            ((float*)f->t)[i] = (float)f->h[i];
+         if (!conv_stream_init_static_f (&f->s, (float*)f->t, f->T, CONV_STREAM_AUTO, arena_alloc (a, sz), sz))
+            return 0;
+         break;
+      case FIR_WSINC_Q15:
+         sz = conv_stream_required_size_d (f->T, CONV_STREAM_AUTO);
+         if ( (f->t = arena_calloc (a, f->N*sizeof (complex_q15_t))) == NULL ||
+              (f->d = arena_calloc (a, 2*f->T*sizeof (complex_d_t))) == NULL ||
+              !conv_stream_init_static_d (&f->s, f->h, f->T, CONV_STREAM_AUTO, arena_alloc (a, sz), sz) )
+            return 0;
+         sz = fft_plan_fixed_required_size (f->N);
+         if (!fft_plan_fixed_init_static (&f->p, f->N, arena_alloc (a, sz), sz))
+            return 0;
+         break;
+   }
+   f->di = 0;
+   return f->N;
+}
+
+/*!
+ * \brief
+ *    Place a private kernel, when f has no cached one, and the per filter
+ *    buffers of f. The private kernel is copied from kb or designed, using
+ *    the space of the buffers as scratch.
+ *
+ * \param  f      Which filter to use
+ * \param  a      The arena to take the memory from, of _fir_wsinc_size(f)
+ * \param  kb     Pointer to the serialised T taps and spectrum, or NULL to design
+ * \return        The number of kernel points in frequency domain, 0 on failure
+ */
+static uint32_t _fir_wsinc_place (fir_wsinc_t *f, arena_t *a, const byte_t *kb) {
+   uint32_t ks = f->N * _fir_wsinc_ksize (f->prec);
+   double *k;
+   size_t m;
+
+   if (!f->kc) {
+      if ( (f->h = (double*)arena_alloc (a, f->T*sizeof (double))) == NULL ||
+           (f->k = arena_alloc (a, ks)) == NULL )
+         return 0;
+      if (kb) {
+         memcpy ((void*)f->h, (const void*)kb, f->T*sizeof (double));
+         memcpy (f->k, (const void*)(kb + f->T*sizeof (double)), ks);
+      }
+      else {
+         m = arena_mark (a);
+         if ((k = (double*)arena_calloc (a, 4*f->N*sizeof (double))) == NULL)
+            return 0;
+         _fir_wsinc_design (f, k);
+         arena_release (a, m);
+      }
+   }
+   return _fir_wsinc_setup (f, a);
+}
+
+/*!
+ * \brief
+ *    Allocate the memory block of f and place the kernel and the buffers.
+ * \return  The number of kernel points in frequency domain, 0 on failure
+ */
+static uint32_t _fir_wsinc_alloc (fir_wsinc_t *f, const byte_t *kb) {
+   size_t sz = _fir_wsinc_size (f) + ARENA_ALIGN;
+   arena_t a;
+
+   if ((f->blk = malloc (sz)) == NULL)
+      return 0;
+   arena_init (&a, f->blk, sz);
+   return _fir_wsinc_place (f, &a, kb);
 }
 
 /*
@@ -202,18 +589,22 @@ void fir_wsinc_set_wtype (fir_wsinc_t *f, fir_wtype_en w) {
    switch (w) {
       default:
       case FIR_WSINC_BLACKMAN:
+         f->wtype = FIR_WSINC_BLACKMAN;
          f->W = _blackman;
          f->tp = _blackman_taps;
          break;
       case FIR_WSINC_HAMMING:
+         f->wtype = FIR_WSINC_HAMMING;
          f->W = _hamming;
          f->tp = _hamming_taps;
          break;
       case FIR_WSINC_BARLETT:
+         f->wtype = FIR_WSINC_BARLETT;
          f->W = _barlett;
          f->tp = _barlett_taps;
          break;
       case FIR_WSINC_HANNING:
+         f->wtype = FIR_WSINC_HANNING;
          f->W = _hanning;
          f->tp = _hanning_taps;
          break;
@@ -265,6 +656,31 @@ void fir_wsic_set_cascade (fir_wsinc_t *f, uint32_t c) {
    f->casc = c;
 }
 
+/*!
+ * \brief
+ *    Set the kernel storage and processing precision. It takes effect
+ *    on the next fir_wsinc_init().
+ *
+ * \param   f     Which filter to use
+ * \param   p     The precision
+ *    \arg  FIR_WSINC_DOUBLE
+ *    \arg  FIR_WSINC_FLOAT
+ *    \arg  FIR_WSINC_Q15
+ * \return        None
+*/
+void fir_wsinc_set_prec (fir_wsinc_t *f, fir_wsinc_prec_en p) {
+   switch (p) {
+      case FIR_WSINC_DOUBLE:
+      case FIR_WSINC_FLOAT:
+      case FIR_WSINC_Q15:
+         f->prec = p;
+         break;
+      default:
+         f->prec = FIR_WSINC_DOUBLE;
+         break;
+   }
+}
+
 /*
  * User Functions
  */
@@ -272,92 +688,940 @@ void fir_wsic_set_cascade (fir_wsinc_t *f, uint32_t c) {
 /*!
  * \brief
  *    Windowed sinc filter de-initialisation.
+ *    A cached kernel is released, not freed, so a later init of the
+ *    same design can reuse it. The memory of a filter from
+ *    fir_wsinc_init_static() stays to the caller.
  *
  * \param  f      Which filter to free
  * \return none
 */
 void fir_wsinc_deinit (fir_wsinc_t* f) {
-   if ( f->k )
-      free ((void*)f->k);
+   if ( f->kc ) {
+      _kc_lock ();
+      --((_fir_wsinc_kc_t*)f->kc)->refs;
+      _kc_unlock ();
+   }
+   conv_stream_deinit (&f->s);
+   fft_plan_deinit (&f->p);
+   if ( f->blk )
+      free (f->blk);
    memset ((void*)f, 0, sizeof (fir_wsinc_t));
 }
 
+/*!
+ * \brief
+ *    Clear the inner data of f before an init.
+ */
+static void _fir_wsinc_clear (fir_wsinc_t *f) {
+   f->k = f->t = f->d = f->kc = f->blk = NULL;
+   f->h = NULL;
+   f->ke = 0;
+   memset ((void*)&f->s, 0, sizeof (conv_stream_t));
+   memset ((void*)&f->p, 0, sizeof (fft_plan_t));
+}
 
 /*!
  * \brief
  *    Windowed sinc filter initialisation.
+ *    Designs the kernel and prepares the frequency domain kernel for
+ *    the block functions, the delay line for the per-sample functions and
+ *    the overlap-save state for fir_wsinc_block().
+ *    The designed kernels are cached. Filters with the same design
+ *    (ftype, window, fc1, fc2, tb, casc, precision) share one read-only kernel.
+ *    When the cache is full the kernel is private to the filter.
  *
  * \param  f      Which filter to use
- * \param  fc     The normalised cutoff frequency [0fs - 0.5fs]
- * \return        None
+ * \return        The number of kernel points in frequency domain, 0 on failure
  */
 uint32_t fir_wsinc_init (fir_wsinc_t* f)
 {
-   uint32_t i;
+   _fir_wsinc_kc_t *e;
 
-   // Calculate taps in time domain
-   f->T = f->tp(f->casc, f->tb);
-   if (f->T < FIR_WSINC_MIN_TAPS)    f->T = FIR_WSINC_MIN_TAPS;
+   _fir_wsinc_dims (f);
+   _fir_wsinc_clear (f);
 
-   // Calculate kernel points in frequency domain
-   f->N = _first_pow2_ge (2*f->T);
+   // Take the kernel from the cache or design it to a new entry
+   _kc_lock ();
+   if (_kc_find (f) == NULL && (e = _kc_slot ()) != NULL && _fir_wsinc_design_heap (f))
+      _kc_insert (f, e);
+   _kc_unlock ();
 
-   // Try to allocate kernel in memory
-   if ( (f->k = (void*)calloc (2*f->N, sizeof (double))) != NULL &&
-        (f->t = (void*)calloc (2*f->N, sizeof (double))) != NULL ) {
-      // Despatch based on filter type
-      switch (f->ftype) {
-         default:
-         case FIR_LOW_PASS:
-            _1tran_loop (f, 1);
-            break;
-         case FIR_HIGH_PASS:
-            _1tran_loop (f, -1);
-            break;
-         case FIR_BAND_REJECT:
-            _2tran_loop (f, 1);
-            break;
-         case FIR_BAND_PASS:
-            _2tran_loop (f, -1);
-            break;
+   if (!_fir_wsinc_alloc (f, NULL)) {
+      fir_wsinc_deinit (f);
+      return 0;
+   }
+   return f->N;
+}
+
+/*!
+ * \brief
+ *    Get the memory size of a filter, for fir_wsinc_init_static().
+ *    The filter options must be set first.
+ *
+ * \param  f      Which filter to use
+ * \return        The size in bytes
+ */
+size_t fir_wsinc_required_size (fir_wsinc_t* f)
+{
+   fir_wsinc_t t = *f;
+
+   _fir_wsinc_dims (&t);
+   t.kc = NULL;
+   return _fir_wsinc_size (&t);
+}
+
+/*!
+ * \brief
+ *    Windowed sinc filter initialisation over caller supplied memory,
+ *    with no heap use. The kernel is designed in the memory and is private
+ *    to the filter, the cache is not used. The memory must stay valid for
+ *    the life of the filter and is not freed by fir_wsinc_deinit().
+ *
+ * \param  f      Which filter to use
+ * \param  mem    Pointer to memory, aligned to ARENA_ALIGN
+ * \param  size   The size of the memory, at least fir_wsinc_required_size()
+ * \return        The number of kernel points in frequency domain, 0 on failure
+ */
+uint32_t fir_wsinc_init_static (fir_wsinc_t* f, void *mem, size_t size)
+{
+   arena_t a;
+
+   _fir_wsinc_dims (f);
+   _fir_wsinc_clear (f);
+   arena_init (&a, mem, size);
+   if (!_fir_wsinc_place (f, &a, NULL)) {
+      _fir_wsinc_clear (f);
+      return 0;
+   }
+   return f->N;
+}
+
+/*!
+ * \brief
+ *    Frees the cached kernels that no filter uses.
+ *
+ * \return        None
+ */
+void fir_wsinc_cache_clear (void) {
+   uint32_t i;
+
+   _kc_lock ();
+   for (i=0 ; i<FIR_WSINC_CACHE_SIZE ; ++i) {
+      if (_kc[i].k && !_kc[i].refs) {
+         free (_kc[i].k);
+         free ((void*)_kc[i].h);
+         memset ((void*)&_kc[i], 0, sizeof (_fir_wsinc_kc_t));
       }
+   }
+   _kc_unlock ();
+}
 
-      // Go to Frequency domain
-      fft_r (f->k, (complex_d_t*)f->k, f->N);
+/*!
+ * Header of a serialised kernel, followed by the T taps as doubles and
+ * the N complex points of the spectrum in the filter's storage type.
+ */
+typedef struct {
+   uint32_t       magic;   //!< FIR_WSINC_MAGIC
+   uint32_t       ftype;   //!< The filter type
+   uint32_t       wtype;   //!< The window type
+   uint32_t       prec;    //!< The spectrum storage type
+   uint32_t       casc;    //!< The number of cascade filters
+   uint32_t       T;       //!< The number of taps
+   uint32_t       N;       //!< The number of kernel points in frequency domain
+   int32_t        ke;      //!< The block exponent of a Q15 spectrum
+   double         fc1, fc2;//!< The transition frequencies
+   double         tb;      //!< The transition bandwidth
+}_fir_wsinc_hdr_t;
 
-      // Cascade filters
-      for (i=1 ; i<f->casc ; ++i)
-         vemul_cd ((complex_d_t*)f->k, (complex_d_t*)f->k, (complex_d_t*)f->k, f->N);
+#define  FIR_WSINC_MAGIC      (0x4B535746)   //!< "FWSK"
 
-      return f->N;
+/*!
+ * \brief
+ *    Check the header of a serialised kernel. The options must be in range
+ *    and the taps and kernel points must be the ones the design gives them.
+ *
+ * \param  hd     Pointer to the header
+ * \return        1 for a valid header, 0 otherwise
+ */
+static int _fir_wsinc_hdr_check (const _fir_wsinc_hdr_t *hd) {
+   fir_wsinc_t t;
+
+   if (hd->magic != FIR_WSINC_MAGIC)
+      return 0;
+   if (hd->ftype > FIR_BAND_REJECT || hd->wtype > FIR_WSINC_HANNING || hd->prec > FIR_WSINC_Q15)
+      return 0;
+   // The kernel exponent is set only for Q15, in the range of _fir_wsinc_to_q15()
+   if ((hd->prec == FIR_WSINC_Q15) ? (hd->ke < 0 || hd->ke > 15) : (hd->ke != 0))
+      return 0;
+   // The kernel points are a power of 2 above the taps
+   if (!hd->N || (hd->N & (hd->N - 1)) || !hd->T || hd->T > hd->N)
+      return 0;
+   // Each cascade stage has taps and the design taps fit in N. This also
+   // keeps tb in range for the taps calculation below.
+   if (!hd->casc || hd->casc > hd->T || !(hd->tb > 0)
+         || _WSINC_BLACKMAN_TAPS*hd->casc/hd->tb > hd->N)
+      return 0;
+
+   memset ((void*)&t, 0, sizeof (t));
+   fir_wsinc_set_ftype (&t, (fir_ftype_en)hd->ftype);
+   fir_wsinc_set_wtype (&t, (fir_wtype_en)hd->wtype);
+   fir_wsinc_set_tb (&t, hd->tb);
+   fir_wsic_set_cascade (&t, hd->casc);
+   _fir_wsinc_dims (&t);
+   return (t.T == hd->T && t.N == hd->N);
+}
+
+/*!
+ * \brief
+ *    Serialises the designed kernel of an initialised filter, so a later
+ *    fir_wsinc_load() can skip the design step. The data are in the
+ *    target's native byte order and floating point format.
+ *
+ * \param  f      Which filter to use
+ * \param  buf    Pointer to the output buffer, or NULL to query the size
+ * \param  size   The size of buf in bytes
+ * \return        The number of bytes written (or needed when buf is NULL),
+ *                0 if buf is too small
+ */
+uint32_t fir_wsinc_save (fir_wsinc_t *f, void *buf, uint32_t size) {
+   _fir_wsinc_hdr_t hd;
+   uint64_t ks = (uint64_t)f->N * _fir_wsinc_ksize (f->prec);
+   uint64_t sz = sizeof (_fir_wsinc_hdr_t) + (uint64_t)f->T*sizeof (double) + ks;
+   byte_t *b = (byte_t*)buf;
+
+   if (sz > UINT32_MAX)          return 0;
+   if (buf == NULL)              return (uint32_t)sz;
+   if ((uint64_t)size < sz)      return 0;
+   memset ((void*)&hd, 0, sizeof (hd));
+   hd.magic = FIR_WSINC_MAGIC;
+   hd.ftype = f->ftype;    hd.wtype = f->wtype;
+   hd.prec = f->prec;      hd.casc = f->casc;
+   hd.T = f->T;            hd.N = f->N;
+   hd.ke = f->ke;          hd.fc1 = f->fc1;
+   hd.fc2 = f->fc2;        hd.tb = f->tb;
+   memcpy ((void*)b, (void*)&hd, sizeof (hd));
+   b += sizeof (hd);
+   memcpy ((void*)b, (void*)f->h, f->T*sizeof (double));
+   b += f->T*sizeof (double);
+   memcpy ((void*)b, f->k, (size_t)ks);
+   return (uint32_t)sz;
+}
+
+/*!
+ * \brief
+ *    Windowed sinc filter initialisation from a kernel serialised by
+ *    fir_wsinc_save(). The filter options are restored from the data and
+ *    no design takes place. The kernel joins the cache as fir_wsinc_init()
+ *    would.
+ *
+ * \param  f      Which filter to use
+ * \param  buf    Pointer to the serialised kernel
+ * \param  size   The size of buf in bytes
+ * \return        The number of kernel points in frequency domain, 0 on failure
+ */
+uint32_t fir_wsinc_load (fir_wsinc_t *f, const void *buf, uint32_t size) {
+   _fir_wsinc_hdr_t hd;
+   const byte_t *b = (const byte_t*)buf;
+   _fir_wsinc_kc_t *e;
+   uint64_t ks;
+
+   memset ((void*)f, 0, sizeof (fir_wsinc_t));
+   if (size < sizeof (hd))
+      return 0;
+   memcpy ((void*)&hd, (const void*)b, sizeof (hd));
+   if (!_fir_wsinc_hdr_check (&hd))
+      return 0;
+   // In 64 bits, so the sizes can not wrap before the check
+   ks = (uint64_t)hd.N * _fir_wsinc_ksize ((fir_wsinc_prec_en)hd.prec);
+   if ((uint64_t)size < sizeof (hd) + (uint64_t)hd.T*sizeof (double) + ks)
+      return 0;
+   b += sizeof (hd);
+
+   fir_wsinc_set_ftype (f, (fir_ftype_en)hd.ftype);
+   fir_wsinc_set_wtype (f, (fir_wtype_en)hd.wtype);
+   fir_wsinc_set_prec (f, (fir_wsinc_prec_en)hd.prec);
+   fir_wsinc_set_fc (f, hd.fc1, hd.fc2);
+   fir_wsinc_set_tb (f, hd.tb);
+   fir_wsic_set_cascade (f, hd.casc);
+   f->T = hd.T;
+   f->N = hd.N;
+   f->ke = hd.ke;
+
+   _kc_lock ();
+   if (_kc_find (f) == NULL && (e = _kc_slot ()) != NULL) {
+      f->k = malloc ((size_t)ks);
+      f->h = (double*)malloc (f->T*sizeof (double));
+      if (f->k && f->h) {
+         memcpy ((void*)f->h, (const void*)b, f->T*sizeof (double));
+         memcpy (f->k, (const void*)(b + f->T*sizeof (double)), (size_t)ks);
+         _kc_insert (f, e);
+      }
+      else {
+         free (f->k);
+         free ((void*)f->h);
+         f->k = NULL;
+         f->h = NULL;
+      }
+   }
+   _kc_unlock ();
+
+   if (!_fir_wsinc_alloc (f, b)) {
+      fir_wsinc_deinit (f);
+      return 0;
    }
+   return f->N;
+}
+
+/*!
+ * \brief
+ *    Clears the filter history, the delay line of the per-sample functions
+ *    and the overlap-save state of the block streaming.
+ *
+ * \param  f      Which filter to use
+ * \return        None
+ */
+void fir_wsinc_reset (fir_wsinc_t* f) {
+   uint32_t sz = (f->prec == FIR_WSINC_FLOAT) ? sizeof (complex_f_t) : sizeof (complex_d_t);
+   memset (f->d, 0, 2*f->T*sz);
+   f->di = 0;
+   conv_stream_reset (&f->s);
+}
+
+/*!
+ * \brief
+ *    The per-sample filter body. The delay line keeps each sample twice,
+ *    at di and di+T, so the last T samples are always contiguous from the
+ *    newest one, d[di+j] = x[n-j]. FLOAT filters use the single precision
+ *    taps of the block streaming state.
+ *
+ * \param  _type     The delay line type
+ * \param  _dot      The dot product of the kernel with the delay line
+ * \param  _h        The kernel
+ */
+#define  _fir_wsinc_body(_type, _dot, _h) {        \
+   _type *d = (_type*)f->d;                        \
+   uint32_t T = f->T;                              \
+                                                   \
+   f->di = (f->di) ? f->di-1 : T-1;                \
+   d[f->di] = d[f->di+T] = (_type)in;              \
+   return _dot (_h, &d[f->di], T);                 \
+}
+
+#define  _dot_rc_body(_type, _ctype) {             \
+   _type re0=0, im0=0, re1=0, im1=0;               \
+   uint32_t j;                                     \
+   for (j=0 ; j+2<=n ; j+=2) {                     \
+      re0 += h[j]*__real__ x[j];                   \
+      im0 += h[j]*__imag__ x[j];                   \
+      re1 += h[j+1]*__real__ x[j+1];               \
+      im1 += h[j+1]*__imag__ x[j+1];               \
+   }                                               \
+   if (j<n) {                                      \
+      re0 += h[j]*__real__ x[j];                   \
+      im0 += h[j]*__imag__ x[j];                   \
+   }                                               \
+   return (re0 + re1) + I*(im0 + im1);             \
+}
+static complex_d_t _dot_rc (double *h, complex_d_t *x, uint32_t n) { _dot_rc_body (double, complex_d_t); }
+static complex_f_t _dot_rcf (float *h, complex_f_t *x, uint32_t n) { _dot_rc_body (float, complex_f_t); }
+#undef _dot_rc_body
+
+#define  _fir_wsinc_r_body()                                   \
+   if (f->prec == FIR_WSINC_FLOAT)                             \
+      _fir_wsinc_body (float, vdot_f, (float*)f->s.h)          \
+   else                                                        \
+      _fir_wsinc_body (double, vdot_d, f->h)
+
+#define  _fir_wsinc_c_body()                                   \
+   if (f->prec == FIR_WSINC_FLOAT)                             \
+      _fir_wsinc_body (complex_f_t, _dot_rcf, (float*)f->s.h)  \
+   else                                                        \
+      _fir_wsinc_body (complex_d_t, _dot_rc, f->h)
+
+/*!
+ * \brief
+ *    Double precision streaming windowed sinc filter.
+ *    Output = Kernel * Input, one sample per call.
+ *
+ * \param  f      Which filter to use
+ * \param  in     The input value.
+ *
+ * \return        Filtered value
+ */
+double fir_wsinc_d (fir_wsinc_t* f, double in) {
+   _fir_wsinc_r_body ();
+}
+
+/*!
+ * \brief
+ *    Single precision streaming windowed sinc filter.
+ *    Output = Kernel * Input, one sample per call.
+ *
+ * \param  f      Which filter to use
+ * \param  in     The input value.
+ *
+ * \return        Filtered value
+ */
+float fir_wsinc_f (fir_wsinc_t* f, float in) {
+   _fir_wsinc_r_body ();
+}
+
+/*!
+ * \brief
+ *    Integer streaming windowed sinc filter returning single precision float.
+ *    Output = Kernel * Input, one sample per call.
+ *
+ * \param  f      Which filter to use
+ * \param  in     The input value.
+ *
+ * \return        Filtered value
+ */
+float fir_wsinc_i (fir_wsinc_t* f, int in) {
+   _fir_wsinc_r_body ();
+}
+
+/*!
+ * \brief
+ *    Double precision complex streaming windowed sinc filter.
+ *    Output = Kernel * Input, one sample per call.
+ *
+ * \param  f      Which filter to use
+ * \param  in     The input value.
+ *
+ * \return        Filtered value
+ */
+complex_d_t fir_wsinc_cd (fir_wsinc_t* f, complex_d_t in) {
+   _fir_wsinc_c_body ();
+}
+
+/*!
+ * \brief
+ *    Single precision complex streaming windowed sinc filter.
+ *    Output = Kernel * Input, one sample per call.
+ *
+ * \param  f      Which filter to use
+ * \param  in     The input value.
+ *
+ * \return        Filtered value
+ */
+complex_f_t fir_wsinc_cf (fir_wsinc_t* f, complex_f_t in) {
+   _fir_wsinc_c_body ();
+}
+
+/*!
+ * \brief
+ *    Integer complex streaming windowed sinc filter returning single
+ *    precision complex float.
+ *    Output = Kernel * Input, one sample per call.
+ *
+ * \param  f      Which filter to use
+ * \param  in     The input value.
+ *
+ * \return        Filtered value
+ */
+complex_f_t fir_wsinc_ci (fir_wsinc_t* f, complex_i_t in) {
+   _fir_wsinc_c_body ();
+}
+
+#undef _fir_wsinc_body
+#undef _fir_wsinc_r_body
+#undef _fir_wsinc_c_body
+
+/*!
+ * \brief
+ *    The block filter body for the other stream precision. The samples
+ *    are converted through a stack buffer of FIR_WSINC_CONV_BLK samples.
+ *
+ * \param  _type     The stream data type
+ * \param  _stream   The block streaming function of the stream type
+ */
+#define  _fir_wsinc_block_conv(_type, _stream) {             \
+   _type b[FIR_WSINC_CONV_BLK];                              \
+   uint32_t i, j, m;                                         \
+                                                             \
+   for (i=0 ; i<n ; i+=m) {                                  \
+      m = (n-i < FIR_WSINC_CONV_BLK) ? n-i : FIR_WSINC_CONV_BLK; \
+      for (j=0 ; j<m ; ++j)   b[j] = (_type)in[i+j];         \
+      _stream (&f->s, b, b, m);                              \
+      for (j=0 ; j<m ; ++j)   out[i+j] = b[j];               \
+   }                                                         \
+}
+
+/*!
+ * \brief
+ *    Double precision block streaming windowed sinc filter.
+ *    Each call outputs exactly n samples, with no latency. The history of
+ *    the previous blocks is kept by the filter's overlap-save state, so
+ *    the blocks can have any size.
+ *
+ * \note
+ *    The block and the per-sample functions keep separate histories.
+ *    Do not mix them on the same filter without fir_wsinc_reset().
+ *    FLOAT filters stream in single precision and the samples are
+ *    converted at the boundary.
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block, size n. It can be the same as in.
+ * \param  n      The block size
+ * \return        None
+ */
+void fir_wsinc_block_d (fir_wsinc_t *f, double *in, double *out, uint32_t n) {
+   if (f->s.it_size == sizeof (double))
+      conv_stream_d (&f->s, out, in, n);
    else
+      _fir_wsinc_block_conv (float, conv_stream_f);
+}
+
+/*!
+ * \brief
+ *    Single precision block streaming windowed sinc filter.
+ *    Each call outputs exactly n samples, with no latency.
+ *
+ * \note
+ *    The block and the per-sample functions keep separate histories.
+ *    Do not mix them on the same filter without fir_wsinc_reset().
+ *    DOUBLE and Q15 filters stream in double precision and the samples
+ *    are converted at the boundary.
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  out    Pointer to the output block, size n. It can be the same as in.
+ * \param  n      The block size
+ * \return        None
+ */
+void fir_wsinc_block_f (fir_wsinc_t *f, float *in, float *out, uint32_t n) {
+   if (f->s.it_size == sizeof (float))
+      conv_stream_f (&f->s, out, in, n);
+   else
+      _fir_wsinc_block_conv (double, conv_stream_d);
+}
+
+#undef _fir_wsinc_block_conv
+
+static int16_t _sat_q15 (int64_t v) {
+   return (v > INT16_MAX) ? INT16_MAX : ((v < INT16_MIN) ? INT16_MIN : (int16_t)v);
+}
+
+/*!
+ * \brief
+ *    Scale a Q15 value by 2^e with rounding
+ */
+static int64_t _scale_q15 (int32_t v, int e) {
+   if (e >= 0)    return (int64_t)v * ((int64_t)1 << e);
+   else           return ((int64_t)v + ((int64_t)1 << (-e-1))) >> -e;
+}
+
+/*
+ * Sample conversions at the boundary of the whole signal filters, for
+ * a signal type other than the filter precision. Q15 samples are
+ * fractions of 2^15.
+ *    _rd_*:   Input sample to the processing type
+ *    _acc_*:  Add a processed value to an output sample
+ */
+#define  _rd_fp(_x)           (_x)
+#define  _rd_q15(_x)          ((_x) * (1.0/32768))
+#define  _rd_fp_q15(_x)       _sat_q15 (llrint ((_x) * 32768.0))
+#define  _acc_fp(_o, _v)      ((_o) += (_v))
+#define  _acc_q15(_o, _v)     ((_o) = _sat_q15 ((_o) + llrint ((_v) * 32768.0)))
+
+/*!
+ * \brief
+ *    The main body of the floating point block filters. Each input segment
+ *    of N-T+1 samples is transformed, multiplied with the kernel spectrum,
+ *    transformed back and added to the output.
+ *
+ * \param  _type     The real data type
+ * \param  _ctype    The complex data type
+ * \param  _fft      The real FFT
+ * \param  _ifft     The real inverse FFT
+ * \param  _vemul    The complex element-wise multiplication
+ * \param  _rd       The input sample conversion
+ * \param  _acc      The output sample accumulation
+ */
+#define  _fir_wsinc_ola_body(_type, _ctype, _fft, _ifft, _vemul, _rd, _acc) { \
+   _type *t = (_type*)f->t;                                                \
+   uint32_t i, j, seg, len, out_sz;                                        \
+                                                                           \
+   /* Calculate segment and clear output signal */                         \
+   seg = f->N - f->T + 1;                                                  \
+   out_sz = _first_pow2_ge(n);                                             \
+   memset ((void*)out, 0, out_sz*sizeof (*out));                           \
+                                                                           \
+   /* Loop the filter */                                                   \
+   for (i=0 ; i<n ; i+=seg) {                                              \
+      len = (i+seg<=n) ? seg : n-i;                                        \
+      memset ((void*)t, 0, 2*f->N*sizeof (_type));                         \
+      for (j=0 ; j<len ; ++j)                                              \
+         t[j] = _rd (in[i+j]);                                             \
+      _fft (t, (_ctype*)t, f->N);                                          \
+      _vemul ((_ctype*)t, (_ctype*)t, (_ctype*)f->k, f->N);                \
+      _ifft ((_ctype*)t, t, f->N);                                         \
+      for (j=0 ; j<f->N && i+j<out_sz; ++j)                                \
+         _acc (out[j+i], t[j]);                                            \
+   }                                                                       \
+}
+
+/*!
+ * \brief
+ *    The main body of the Q15 block filters.
+ *    Two input segments are filtered with one complex block floating point
+ *    transform, as the real and the imaginary part, since the kernel is real.
+ *    The block exponents of the transforms and the kernel are applied to the
+ *    output, which is saturated.
+ *
+ * \param  _rd       The input sample conversion to Q15
+ * \param  _acc_e    The output accumulation of a Q15 value v scaled by 2^e
+ */
+#define  _fir_wsinc_q15_body(_rd, _acc_e) {                                \
+   complex_q15_t *t = (complex_q15_t*)f->t;                                \
+   complex_q15_t *k = (complex_q15_t*)f->k;                                \
+   uint32_t i, j, seg, out_sz, la, lb;                                     \
+   int32_t ar, ai, kr, ki;                                                 \
+   int e;                                                                  \
+                                                                           \
+   seg = f->N - f->T + 1;                                                  \
+   out_sz = _first_pow2_ge(n);                                             \
+   memset ((void*)out, 0, out_sz*sizeof (*out));                           \
+                                                                           \
+   for (i=0 ; i<n ; i+=2*seg) {                                            \
+      la = (i+seg <= n) ? seg : n-i;                                       \
+      lb = (i+seg >= n) ? 0 : ((i+2*seg <= n) ? seg : n-i-seg);            \
+      memset ((void*)t, 0, f->N*sizeof (complex_q15_t));                   \
+      for (j=0 ; j<la ; ++j)  realq15 (t[j]) = _rd (in[i+j]);              \
+      for (j=0 ; j<lb ; ++j)  imagq15 (t[j]) = _rd (in[i+seg+j]);          \
+                                                                           \
+      e = fftp_q15 (&f->p, t, t);                                          \
+      /* Multiply with the kernel, scaled by 1/2 so the product can not overflow */ \
+      for (j=0 ; j<f->N ; ++j) {                                           \
+         ar = realq15 (t[j]);    ai = imagq15 (t[j]);                      \
+         kr = realq15 (k[j]);    ki = imagq15 (k[j]);                      \
+         realq15 (t[j]) = (int16_t)((ar*kr - ai*ki + (1<<15)) >> 16);      \
+         imagq15 (t[j]) = (int16_t)((ar*ki + ai*kr + (1<<15)) >> 16);      \
+      }                                                                    \
+      e += ifftp_q15 (&f->p, t, t) + f->ke + 1;                            \
+                                                                           \
+      /* Output data, scaled by 2^e */                                     \
+      for (j=0 ; j<f->N ; ++j) {                                           \
+         if (i+j < out_sz)                                                 \
+            _acc_e (out[i+j], realq15 (t[j]), e);                          \
+         if (lb && i+seg+j < out_sz)                                       \
+            _acc_e (out[i+seg+j], imagq15 (t[j]), e);                      \
+      }                                                                    \
+   }                                                                       \
+}
+
+#define  _acc_e_q15(_o, _v, _e)  ((_o) = _sat_q15 ((_o) + _scale_q15 ((_v), (_e))))
+#define  _acc_e_fp(_o, _v, _e)   ((_o) += ldexp ((double)(_v), (_e) - 15))
+
+/*!
+ * \brief
+ *    Double precision windowed sinc filter of a whole signal.
+ *    FLOAT and Q15 filters process in their own precision and the samples
+ *    are converted at the boundary.
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input signal
+ * \param  out    Pointer to the output signal. Its size must be the first
+ *                power of 2 greater than n.
+ * \param  n      The input size
+ * \return        None
+ */
+void fir_wsinc (fir_wsinc_t *f, double *in, double *out, uint32_t n) {
+   switch (f->prec) {
+      default:
+      case FIR_WSINC_DOUBLE:
+         _fir_wsinc_ola_body (double, complex_d_t, fft_r, ifft_r, vemul_cd, _rd_fp, _acc_fp);
+         break;
+      case FIR_WSINC_FLOAT:
+         _fir_wsinc_ola_body (float, complex_f_t, fft_rf, ifft_rf, vemul_cf, _rd_fp, _acc_fp);
+         break;
+      case FIR_WSINC_Q15:
+         _fir_wsinc_q15_body (_rd_fp_q15, _acc_e_fp);
+         break;
+   }
+}
+
+/*!
+ * \brief
+ *    Single precision windowed sinc filter of a whole signal. FLOAT
+ *    filters run the kernel spectrum, the scratch array and the transforms
+ *    in single precision. DOUBLE and Q15 filters process in their own
+ *    precision and the samples are converted at the boundary.
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input signal
+ * \param  out    Pointer to the output signal. Its size must be the first
+ *                power of 2 greater than n.
+ * \param  n      The input size
+ * \return        None
+ */
+void fir_wsinc_rf (fir_wsinc_t *f, float *in, float *out, uint32_t n) {
+   switch (f->prec) {
+      default:
+      case FIR_WSINC_DOUBLE:
+         _fir_wsinc_ola_body (double, complex_d_t, fft_r, ifft_r, vemul_cd, _rd_fp, _acc_fp);
+         break;
+      case FIR_WSINC_FLOAT:
+         _fir_wsinc_ola_body (float, complex_f_t, fft_rf, ifft_rf, vemul_cf, _rd_fp, _acc_fp);
+         break;
+      case FIR_WSINC_Q15:
+         _fir_wsinc_q15_body (_rd_fp_q15, _acc_e_fp);
+         break;
+   }
+}
+
+/*!
+ * \brief
+ *    Q15 windowed sinc filter of a whole signal. Q15 filters use block
+ *    floating point transforms, which limit the SNR to about 55-65 dB,
+ *    depending on N. Use a FLOAT filter where this is not enough. DOUBLE
+ *    and FLOAT filters process in their own precision and the samples are
+ *    converted at the boundary, with saturation.
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the Q15 input signal
+ * \param  out    Pointer to the Q15 output signal. Its size must be the
+ *                first power of 2 greater than n.
+ * \param  n      The input size
+ * \return        None
+ */
+void fir_wsinc_q15 (fir_wsinc_t *f, int16_t *in, int16_t *out, uint32_t n) {
+   switch (f->prec) {
+      default:
+      case FIR_WSINC_DOUBLE:
+         _fir_wsinc_ola_body (double, complex_d_t, fft_r, ifft_r, vemul_cd, _rd_q15, _acc_q15);
+         break;
+      case FIR_WSINC_FLOAT:
+         _fir_wsinc_ola_body (float, complex_f_t, fft_rf, ifft_rf, vemul_cf, _rd_q15, _acc_q15);
+         break;
+      case FIR_WSINC_Q15:
+         _fir_wsinc_q15_body (_rd_fp, _acc_e_q15);
+         break;
+   }
+}
+
+#undef _fir_wsinc_ola_body
+#undef _fir_wsinc_q15_body
+#undef _rd_fp
+#undef _rd_q15
+#undef _rd_fp_q15
+#undef _acc_fp
+#undef _acc_q15
+#undef _acc_e_q15
+#undef _acc_e_fp
+
+
+/*
+ * ============ Polyphase filters ============
+ */
+
+static uint32_t _gcd (uint32_t a, uint32_t b) {
+   uint32_t t;
+   while (b) {
+      t = a % b;
+      a = b;
+      b = t;
+   }
+   return a;
+}
+
+/*!
+ * \brief
+ *    Polyphase filter de-initialisation.
+ *    The memory of a filter from fir_poly_init_static() stays to the caller.
+ *
+ * \param  f      Which filter to free
+ * \return none
+*/
+void fir_poly_deinit (fir_poly_t *f) {
+   if ( f->blk )
+      free (f->blk);
+   memset ((void*)f, 0, sizeof (fir_poly_t));
+}
+
+/*!
+ * \brief
+ *    Calculate the factors and the sizes of a polyphase filter and prepare
+ *    the prototype low pass design at the L times upsampled rate, with the
+ *    stop band starting at the Nyquist frequency of the lower of the input
+ *    and output rates.
+ * \return  The number of taps per phase, 0 for invalid arguments
+ */
+static uint32_t _fir_poly_dims (fir_poly_t *f, fir_wsinc_t *k, uint32_t L, uint32_t M, fir_wtype_en w, double tb)
+{
+   uint32_t g, K;
+
+   memset ((void*)f, 0, sizeof (fir_poly_t));
+   if (!L || !M || tb <= 0 || tb >= 0.5)
       return 0;
+   g = _gcd (L, M);
+   f->L = L/g;
+   f->M = M/g;
+   K = (f->L > f->M) ? f->L : f->M;
+
+   memset ((void*)k, 0, sizeof (fir_wsinc_t));
+   fir_wsinc_set_wtype (k, w);
+   k->casc = 1;
+   k->fc1 = (0.5 - tb/2) / K;
+   k->T = k->tp (1, tb/K);
+   if (k->T < FIR_WSINC_MIN_TAPS)   k->T = FIR_WSINC_MIN_TAPS;
+   k->T += (k->T%2) ? 0:1;          // As the design rounds it
+   f->T = k->T;
+   f->P = (f->T + f->L - 1) / f->L;
+   return f->P;
 }
 
+//! The delay line items, also the design scratch of T+2 items
+#define  _fir_poly_dsize(_f)     ( ((_f)->T + 2 > 2*(_f)->P) ? (_f)->T + 2 : 2*(_f)->P )
 
-void fir_wsinc (fir_wsinc_t *f, double *in, double *out, uint32_t n)
+/*!
+ * \brief
+ *    Get the memory size of a polyphase filter, for fir_poly_init_static().
+ *
+ * \param  L      The interpolation factor
+ * \param  M      The decimation factor
+ * \param  w      The window type
+ * \param  tb     The transition bandwidth
+ * \return        The size in bytes, 0 for invalid arguments
+ */
+size_t fir_poly_required_size (uint32_t L, uint32_t M, fir_wtype_en w, double tb)
 {
-   uint32_t i, j, seg, out_sz;
+   fir_wsinc_t k;
+   fir_poly_t f;
+
+   if (!_fir_poly_dims (&f, &k, L, M, w, tb))
+      return 0;
+   return ARENA_SIZE (f.L*f.P*sizeof (double))
+        + ARENA_SIZE (_fir_poly_dsize (&f)*sizeof (double));
+}
 
-   // Calculate segment and clear output signal
-   seg = f->N - f->T + 1;
-   out_sz = _first_pow2_ge(n);
-   memset ((void*)out, 0, out_sz*sizeof (double));
+/*!
+ * \brief
+ *    Polyphase filter initialisation, for sample rate conversion by L/M.
+ *    The low pass kernel is designed by the windowed sinc code at the
+ *    L times upsampled rate, with the stop band starting at the Nyquist
+ *    frequency of the lower of the input and output rates. Its gain is L,
+ *    to make up for the zero stuffing.
+ *
+ * \param  f      Which filter to use
+ * \param  L      The interpolation factor
+ * \param  M      The decimation factor
+ * \param  w      The window type
+ * \param  tb     The transition bandwidth, normalised to the lower of the
+ *                input and output rates (0 .. 0.5)
+ * \return        The number of taps per phase, 0 on failure
+ */
+uint32_t fir_poly_init (fir_poly_t *f, uint32_t L, uint32_t M, fir_wtype_en w, double tb)
+{
+   size_t sz = fir_poly_required_size (L, M, w, tb);
+   void *mem;
 
-   // Loop the filter
-   for (i=0 ; i<n ; i+=seg) {
-      memset ((void*)f->t, 0, 2*f->N*sizeof (double));         // Clear temporary table
-      if (i+seg-1<=n)                                          // Copy input segment
-         memcpy ((void*)f->t, (void*)&in[i], seg * sizeof (double));
-      else  // last segment
-         memcpy ((void*)f->t, (void*)&in[i], (n-i) * sizeof (double));
-      fft_r (f->t, (complex_d_t*)f->t, f->N);                  // Transform input signal
-      vemul_cd ((complex_d_t*)f->t, (complex_d_t*)f->t, (complex_d_t*)f->k, f->N);
-                                                               // Frequency domain multiplication
-      ifft_r ((complex_d_t*)f->t, f->t, f->N);                 // Transform back to time domain
-      for (j=0 ; j<f->N && i+j<out_sz; ++j)                    // Output data
-         out[j+i] += f->t[j];
+   memset ((void*)f, 0, sizeof (fir_poly_t));
+   if (!sz || (mem = malloc (sz + ARENA_ALIGN)) == NULL)
+      return 0;
+   if (fir_poly_init_static (f, L, M, w, tb, mem, sz + ARENA_ALIGN) == 0) {
+      free (mem);
+      return 0;
    }
+   f->blk = mem;
+   return f->P;
 }
 
+/*!
+ * \brief
+ *    Polyphase filter initialisation over caller supplied memory, with no
+ *    heap use. The memory must stay valid for the life of the filter and
+ *    is not freed by fir_poly_deinit().
+ *
+ * \param  f      Which filter to use
+ * \param  L      The interpolation factor
+ * \param  M      The decimation factor
+ * \param  w      The window type
+ * \param  tb     The transition bandwidth, normalised to the lower of the
+ *                input and output rates (0 .. 0.5)
+ * \param  mem    Pointer to memory, aligned to ARENA_ALIGN
+ * \param  size   The size of the memory, at least fir_poly_required_size()
+ * \return        The number of taps per phase, 0 on failure
+ */
+uint32_t fir_poly_init_static (fir_poly_t *f, uint32_t L, uint32_t M, fir_wtype_en w, double tb, void *mem, size_t size)
+{
+   fir_wsinc_t k;
+   arena_t a;
+   double *kd;
+   uint32_t p, j;
+
+   if (!_fir_poly_dims (f, &k, L, M, w, tb))
+      return 0;
+   arena_init (&a, mem, size);
+   f->h = (double*)arena_calloc (&a, f->L*f->P*sizeof (double));
+   kd = (double*)arena_calloc (&a, _fir_poly_dsize (f)*sizeof (double));
+   if (!f->h || !kd) {
+      memset ((void*)f, 0, sizeof (fir_poly_t));
+      return 0;
+   }
+   // Design the prototype low pass to the delay line space and split to phases
+   _1tran_loop (&k, kd, 1);
+   for (p=0 ; p<f->L ; ++p)
+      for (j=0 ; p+j*f->L < f->T ; ++j)
+         f->h[p*f->P + j] = f->L * kd[p + j*f->L];
+   f->d = kd;
+   fir_poly_reset (f);
+   return f->P;
+}
+
+/*!
+ * \brief
+ *    Clears the filter history. The next input is aligned to an output.
+ *
+ * \param  f      Which filter to use
+ * \return        None
+ */
+void fir_poly_reset (fir_poly_t *f) {
+   memset ((void*)f->d, 0, 2*f->P*sizeof (double));
+   f->di = f->o = 0;
+}
+
+/*!
+ * \brief
+ *    The number of outputs the next fir_poly_d() call of n inputs produces.
+ *    Use it to size the output block.
+ *
+ * \param  f      Which filter to use
+ * \param  n      The number of inputs
+ * \return        The number of outputs
+ */
+uint32_t fir_poly_outputs (fir_poly_t *f, uint32_t n) {
+   uint64_t t = (uint64_t)n * f->L;
+   return (f->o < t) ? (uint32_t)((t - f->o - 1)/f->M + 1) : 0;
+}
+
+/*!
+ * \brief
+ *    Double precision polyphase filtering of a block of any size.
+ *    Each input is pushed to the delay line and only the outputs of the
+ *    L/M rate are computed, each one from P taps of one phase.
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to the input block
+ * \param  n      The input block size
+ * \param  out    Pointer to the output block, fir_poly_outputs(f, n) items
+ * \return        The number of outputs
+ */
+uint32_t fir_poly_d (fir_poly_t *f, double *in, uint32_t n, double *out)
+{
+   double *d = f->d;
+   uint32_t i, m, di = f->di, o = f->o;
+   uint32_t L = f->L, M = f->M, P = f->P;
+
+   for (i=m=0 ; i<n ; ++i) {
+      di = (di) ? di-1 : P-1;
+      d[di] = d[di+P] = in[i];
+      for ( ; o < L ; o += M)
+         out[m++] = vdot_d (&f->h[o*P], &d[di], P);
+      o -= L;
+   }
+   f->di = di;
+   f->o = o;
+   return m;
+}
@@ -60,3 +60,59 @@ __O3__ double leaky_int (leaky_int_t* li, double value) {
       return (li->out = 0);
    return (li->out = li->out*li->lambda + (1-li->lambda)*value);
 }
+
+/*!
+ * \brief
+ *    The leaky integrator function over a block. The state is kept
+ *    in locals for the whole block, the results are the same as of
+ *    leaky_int().
+ *
+ * \param   li,      which filter to use
+ * \param   in,      pointer to the input block
+ * \param   out,     pointer to the output block. Can be the same as in
+ * \param   n,       the block size
+ */
+__O3__ void leaky_int_block (leaky_int_t* li, double *in, double *out, uint32_t n) {
+   double y = li->out, l = li->lambda, x;
+   uint32_t i;
+
+   for (i=0 ; i<n ; ++i) {
+      x = in[i];
+      out[i] = y = (isnan (x)) ? 0 : y*l + (1-l)*x;
+   }
+   li->out = y;
+}
+
+/*!
+ * \brief
+ *    The leaky integrator bank. Filters ch channels of interleaved frames,
+ *    in[i*ch + k] is the sample i of channel k, each one with its own
+ *    filter li[k]. Up to LEAKY_INT_BANK_BLK channels are updated in
+ *    lock-step from locals, so the channel loop can be vectorised.
+ *
+ * \param   li,      pointer to an array of ch filters
+ * \param   ch,      the number of channels
+ * \param   in,      pointer to the input frames, n*ch items
+ * \param   out,     pointer to the output frames, n*ch items. Can be the same as in
+ * \param   n,       the number of frames
+ */
+__O3__ void leaky_int_bank (leaky_int_t* li, uint32_t ch, double *in, double *out, uint32_t n) {
+   double y[LEAKY_INT_BANK_BLK], l[LEAKY_INT_BANK_BLK], x;
+   uint32_t i, k, k0, m;
+
+   for (k0=0 ; k0<ch ; k0+=m) {
+      m = (ch - k0 < LEAKY_INT_BANK_BLK) ? ch - k0 : LEAKY_INT_BANK_BLK;
+      for (k=0 ; k<m ; ++k) {
+         y[k] = li[k0+k].out;
+         l[k] = li[k0+k].lambda;
+      }
+      for (i=0 ; i<n ; ++i) {
+         for (k=0 ; k<m ; ++k) {
+            x = in[i*ch + k0+k];
+            out[i*ch + k0+k] = y[k] = (isnan (x)) ? 0 : y[k]*l[k] + (1-l[k])*x;
+         }
+      }
+      for (k=0 ; k<m ; ++k)
+         li[k0+k].out = y[k];
+   }
+}
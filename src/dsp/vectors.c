@@ -22,6 +22,784 @@
  *
  */
 #include <dsp/vectors.h>
+#include <float.h>
+#ifdef TBX_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * ============ Kernels ============
+ *
+ * The float, double and complex float (and complex double vemul) functions
+ * run on kernels from tables of {scalar, SSE2, AVX2} entries, indexed by
+ * the host instruction set, detected at the first call.
+ * The element-wise kernels load all the inputs of a vector before they
+ * store it, so y can be the same as a or b. The reductions only read, so
+ * they use restrict pointers.
+ */
+typedef void  (*_vop_f_pt) (float *y, float *a, float *b, int n);
+typedef void  (*_vop_d_pt) (double *y, double *a, double *b, int n);
+typedef void  (*_vop_cf_pt) (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n);
+typedef void  (*_vop_cd_pt) (complex_d_t *y, complex_d_t *a, complex_d_t *b, int n);
+typedef int   (*_vdiv_f_pt) (float *y, float *a, float *b, int n);
+typedef int   (*_vdiv_d_pt) (double *y, double *a, double *b, int n);
+typedef int   (*_vdiv_cf_pt) (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n);
+typedef float (*_vdot_f_pt) (const float *restrict a, const float *restrict b, int n);
+typedef double (*_vdot_d_pt) (const double *restrict a, const double *restrict b, int n);
+typedef complex_f_t (*_vdot_cf_pt) (const complex_f_t *restrict a, const complex_f_t *restrict b, int n);
+typedef void  (*_vaxpy_f_pt) (float *y, float a, float *x, int n);
+typedef void  (*_vaxpy_d_pt) (double *y, double a, double *x, int n);
+typedef void  (*_vaxpy_cf_pt) (complex_f_t *y, complex_f_t a, complex_f_t *x, int n);
+typedef void  (*_vscale_f_pt) (float *y, float *x, float a, float b, int n);
+typedef void  (*_vscale_d_pt) (double *y, double *x, double a, double b, int n);
+typedef void  (*_vscale_cf_pt) (complex_f_t *y, complex_f_t *x, complex_f_t a, complex_f_t b, int n);
+typedef void  (*_vclamp_f_pt) (float *y, float *x, float lo, float hi, int n);
+typedef void  (*_vclamp_d_pt) (double *y, double *x, double lo, double hi, int n);
+typedef void  (*_vemul_sf_pt) (float *yr, float *yi, float *ar, float *ai, float *br, float *bi, int n);
+typedef void  (*_vemul_sd_pt) (double *yr, double *yi, double *ar, double *ai, double *br, double *bi, int n);
+typedef complex_f_t (*_vdot_sf_pt) (const float *restrict ar, const float *restrict ai,
+                                    const float *restrict br, const float *restrict bi, int n);
+typedef complex_d_t (*_vdot_sd_pt) (const double *restrict ar, const double *restrict ai,
+                                    const double *restrict br, const double *restrict bi, int n);
+
+/*!
+ * Scalar element-wise kernel
+ * \param   _name    Kernel name
+ * \param   _type    Data type
+ * \param   _op      The C operator
+ */
+#define  _vop_scalar(_name, _type, _op)                              \
+static void _name (_type *y, _type *a, _type *b, int n) {            \
+   int i;                                                            \
+   for (i=0 ; i<n ; ++i)                                             \
+      y[i] = a[i] _op b[i];                                          \
+}
+
+/*!
+ * Scalar element-wise division kernel
+ * \param   _name    Kernel name
+ * \param   _type    Data type
+ */
+#define  _vdiv_scalar(_name, _type)                                  \
+static int _name (_type *y, _type *a, _type *b, int n) {             \
+   int i;                                                            \
+   for (i=0 ; i<n ; ++i) {                                           \
+      if (b[i] == 0)                                                 \
+         return 1;                                                   \
+      y[i] = a[i] / b[i];                                            \
+   }                                                                 \
+   return 0;                                                         \
+}
+
+/*!
+ * Scalar dot product kernel, four independent accumulators
+ * \param   _name    Kernel name
+ * \param   _type    Data type
+ * \param   _conj    Conjugate function, empty for real data
+ */
+#define  _vdot_scalar(_name, _type, _conj)                           \
+static _type _name (const _type *restrict a, const _type *restrict b, int n) { \
+   _type s0 = 0, s1 = 0, s2 = 0, s3 = 0;                             \
+   int i;                                                            \
+   for (i=0 ; i+4<=n ; i+=4) {                                       \
+      s0 += _conj (a[i])   * b[i];                                   \
+      s1 += _conj (a[i+1]) * b[i+1];                                 \
+      s2 += _conj (a[i+2]) * b[i+2];                                 \
+      s3 += _conj (a[i+3]) * b[i+3];                                 \
+   }                                                                 \
+   for ( ; i<n ; ++i)                                                \
+      s0 += _conj (a[i]) * b[i];                                     \
+   return (s0 + s1) + (s2 + s3);                                     \
+}
+
+_vop_scalar (_vadd_f_scalar, float, +)
+_vop_scalar (_vsub_f_scalar, float, -)
+_vop_scalar (_vemul_f_scalar, float, *)
+_vop_scalar (_vadd_d_scalar, double, +)
+_vop_scalar (_vsub_d_scalar, double, -)
+_vop_scalar (_vemul_d_scalar, double, *)
+_vop_scalar (_vemul_cf_scalar, complex_f_t, *)
+_vop_scalar (_vemul_cd_scalar, complex_d_t, *)
+_vdiv_scalar (_vediv_f_scalar, float)
+_vdiv_scalar (_vediv_d_scalar, double)
+_vdiv_scalar (_vediv_cf_scalar, complex_f_t)
+_vdot_scalar (_vdot_f_scalar, float, )
+_vdot_scalar (_vdot_d_scalar, double, )
+_vdot_scalar (_vdot_cf_scalar, complex_f_t, conjf)
+
+/*!
+ * Scalar fused kernels
+ * \param   _name    Kernel name
+ * \param   _type    Data type
+ * \param   _conj    Conjugate function, empty for real data
+ */
+#define  _vaxpy_scalar(_name, _type)                                 \
+static void _name (_type *y, _type a, _type *x, int n) {             \
+   int i;                                                            \
+   for (i=0 ; i<n ; ++i)                                             \
+      y[i] += a * x[i];                                              \
+}
+#define  _vscale_scalar(_name, _type)                                \
+static void _name (_type *y, _type *x, _type a, _type b, int n) {    \
+   int i;                                                            \
+   for (i=0 ; i<n ; ++i)                                             \
+      y[i] = a * x[i] + b;                                           \
+}
+#define  _vmac_scalar(_name, _type, _conj)                           \
+static void _name (_type *y, _type *a, _type *b, int n) {            \
+   int i;                                                            \
+   for (i=0 ; i<n ; ++i)                                             \
+      y[i] += _conj (a[i]) * b[i];                                   \
+}
+#define  _vclamp_scalar(_name, _type)                                \
+static void _name (_type *y, _type *x, _type lo, _type hi, int n) {  \
+   int i;                                                            \
+   for (i=0 ; i<n ; ++i)                                             \
+      y[i] = (x[i] < lo) ? lo : ((x[i] > hi) ? hi : x[i]);           \
+}
+
+_vaxpy_scalar (_vaxpy_f_scalar, float)
+_vaxpy_scalar (_vaxpy_d_scalar, double)
+_vaxpy_scalar (_vaxpy_cf_scalar, complex_f_t)
+_vscale_scalar (_vscale_f_scalar, float)
+_vscale_scalar (_vscale_d_scalar, double)
+_vscale_scalar (_vscale_cf_scalar, complex_f_t)
+_vmac_scalar (_vmac_f_scalar, float, )
+_vmac_scalar (_vmac_d_scalar, double, )
+_vmac_scalar (_vmac_cf_scalar, complex_f_t, )
+_vmac_scalar (_vcmac_cf_scalar, complex_f_t, conjf)
+_vclamp_scalar (_vclamp_f_scalar, float)
+_vclamp_scalar (_vclamp_d_scalar, double)
+
+/*!
+ * Scalar split complex kernels
+ * \param   _name    Kernel name
+ * \param   _type    Real data type
+ * \param   _ctype   Complex data type
+ */
+#define  _vemul_split_scalar(_name, _type)                           \
+static void _name (_type *yr, _type *yi, _type *ar, _type *ai, _type *br, _type *bi, int n) { \
+   _type r, m;                                                       \
+   int i;                                                            \
+   for (i=0 ; i<n ; ++i) {                                           \
+      r = ar[i]*br[i] - ai[i]*bi[i];                                 \
+      m = ar[i]*bi[i] + ai[i]*br[i];                                 \
+      yr[i] = r;                                                     \
+      yi[i] = m;                                                     \
+   }                                                                 \
+}
+#define  _vdot_split_scalar(_name, _type, _ctype)                    \
+static _ctype _name (const _type *restrict ar, const _type *restrict ai, \
+                     const _type *restrict br, const _type *restrict bi, int n) { \
+   _type r0 = 0, r1 = 0, m0 = 0, m1 = 0;                             \
+   int i;                                                            \
+   for (i=0 ; i+2<=n ; i+=2) {                                       \
+      r0 += ar[i]*br[i] + ai[i]*bi[i];                               \
+      m0 += ar[i]*bi[i] - ai[i]*br[i];                               \
+      r1 += ar[i+1]*br[i+1] + ai[i+1]*bi[i+1];                       \
+      m1 += ar[i+1]*bi[i+1] - ai[i+1]*br[i+1];                       \
+   }                                                                 \
+   for ( ; i<n ; ++i) {                                              \
+      r0 += ar[i]*br[i] + ai[i]*bi[i];                               \
+      m0 += ar[i]*bi[i] - ai[i]*br[i];                               \
+   }                                                                 \
+   return (r0 + r1) + I*(m0 + m1);                                   \
+}
+
+_vemul_split_scalar (_vemul_sf_scalar, float)
+_vemul_split_scalar (_vemul_sd_scalar, double)
+_vdot_split_scalar (_vdot_sf_scalar, float, complex_f_t)
+_vdot_split_scalar (_vdot_sd_scalar, double, complex_d_t)
+
+#ifdef TBX_SIMD_X86
+/*
+ * ============ x86 SIMD kernels ============
+ */
+
+/*!
+ * Element-wise kernel, two vectors per step and scalar tail
+ * \param   _name    Kernel name
+ * \param   _target  Target attribute
+ * \param   _type    Data type
+ * \param   _vt      Vector type
+ * \param   _w       Items per vector
+ * \param   _ld      Unaligned load
+ * \param   _st      Unaligned store
+ * \param   _vop     The vector operation
+ * \param   _op      The C operator for the tail
+ */
+#define  _vop_simd(_name, _target, _type, _vt, _w, _ld, _st, _vop, _op)     \
+_target static void _name (_type *y, _type *a, _type *b, int n) {            \
+   _vt y0, y1;                                                               \
+   int i;                                                                    \
+   for (i=0 ; i+2*(_w)<=n ; i+=2*(_w)) {                                     \
+      y0 = _vop (_ld (&a[i]), _ld (&b[i]));                                  \
+      y1 = _vop (_ld (&a[i+(_w)]), _ld (&b[i+(_w)]));                        \
+      _st (&y[i], y0);                                                       \
+      _st (&y[i+(_w)], y1);                                                  \
+   }                                                                         \
+   for ( ; i<n ; ++i)                                                        \
+      y[i] = a[i] _op b[i];                                                  \
+}
+
+/*!
+ * Element-wise division kernel. Checks a whole vector of b for zeros
+ * before it divides.
+ * \param   _name    Kernel name
+ * \param   _target  Target attribute
+ * \param   _type    Data type
+ * \param   _vt      Vector type
+ * \param   _w       Items per vector
+ * \param   _ld      Unaligned load
+ * \param   _st      Unaligned store
+ * \param   _div     Vector division
+ * \param   _zero    Vector of zeros
+ * \param   _anyeq   Non zero if any item of the two vectors is equal
+ */
+#define  _vdiv_simd(_name, _target, _type, _vt, _w, _ld, _st, _div, _zero, _anyeq) \
+_target static int _name (_type *y, _type *a, _type *b, int n) {             \
+   _vt vb, z = _zero ();                                                     \
+   int i;                                                                    \
+   for (i=0 ; i+(_w)<=n ; i+=(_w)) {                                         \
+      vb = _ld (&b[i]);                                                      \
+      if (_anyeq (vb, z))                                                    \
+         return 1;                                                           \
+      _st (&y[i], _div (_ld (&a[i]), vb));                                   \
+   }                                                                         \
+   for ( ; i<n ; ++i) {                                                      \
+      if (b[i] == 0)                                                         \
+         return 1;                                                           \
+      y[i] = a[i] / b[i];                                                    \
+   }                                                                         \
+   return 0;                                                                 \
+}
+
+/*!
+ * Real dot product kernel, four vector accumulators and scalar tail
+ * \param   _name    Kernel name
+ * \param   _target  Target attribute
+ * \param   _type    Data type
+ * \param   _vt      Vector type
+ * \param   _w       Items per vector
+ * \param   _ld      Unaligned load
+ * \param   _st      Unaligned store
+ * \param   _add     Vector addition
+ * \param   _mul     Vector multiplication
+ * \param   _zero    Vector of zeros
+ */
+#define  _vdot_simd(_name, _target, _type, _vt, _w, _ld, _st, _add, _mul, _zero) \
+_target static _type _name (const _type *restrict a, const _type *restrict b, int n) { \
+   _vt s0 = _zero (), s1 = _zero (), s2 = _zero (), s3 = _zero ();           \
+   _type t[_w], res = 0;                                                     \
+   int i;                                                                    \
+   for (i=0 ; i+4*(_w)<=n ; i+=4*(_w)) {                                     \
+      s0 = _add (s0, _mul (_ld (&a[i]), _ld (&b[i])));                       \
+      s1 = _add (s1, _mul (_ld (&a[i+(_w)]), _ld (&b[i+(_w)])));             \
+      s2 = _add (s2, _mul (_ld (&a[i+2*(_w)]), _ld (&b[i+2*(_w)])));         \
+      s3 = _add (s3, _mul (_ld (&a[i+3*(_w)]), _ld (&b[i+3*(_w)])));         \
+   }                                                                         \
+   for ( ; i+(_w)<=n ; i+=(_w))                                              \
+      s0 = _add (s0, _mul (_ld (&a[i]), _ld (&b[i])));                       \
+   _st (t, _add (_add (s0, s1), _add (s2, s3)));                             \
+   for (int j=0 ; j<(_w) ; ++j)                                              \
+      res += t[j];                                                           \
+   for ( ; i<n ; ++i)                                                        \
+      res += a[i] * b[i];                                                    \
+   return res;                                                               \
+}
+
+#define  _anyeq_ps(_a, _b)       _mm_movemask_ps (_mm_cmpeq_ps (_a, _b))
+#define  _anyeq_pd(_a, _b)       _mm_movemask_pd (_mm_cmpeq_pd (_a, _b))
+#define  _anyeq256_ps(_a, _b)    _mm256_movemask_ps (_mm256_cmp_ps (_a, _b, _CMP_EQ_OQ))
+#define  _anyeq256_pd(_a, _b)    _mm256_movemask_pd (_mm256_cmp_pd (_a, _b, _CMP_EQ_OQ))
+
+_vop_simd (_vadd_f_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, +)
+_vop_simd (_vsub_f_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_sub_ps, -)
+_vop_simd (_vemul_f_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_mul_ps, *)
+_vop_simd (_vadd_d_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, +)
+_vop_simd (_vsub_d_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_sub_pd, -)
+_vop_simd (_vemul_d_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_mul_pd, *)
+_vop_simd (_vadd_f_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, +)
+_vop_simd (_vsub_f_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sub_ps, -)
+_vop_simd (_vemul_f_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_mul_ps, *)
+_vop_simd (_vadd_d_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_add_pd, +)
+_vop_simd (_vsub_d_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_sub_pd, -)
+_vop_simd (_vemul_d_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_mul_pd, *)
+
+_vdiv_simd (_vediv_f_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_div_ps, _mm_setzero_ps, _anyeq_ps)
+_vdiv_simd (_vediv_d_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_div_pd, _mm_setzero_pd, _anyeq_pd)
+_vdiv_simd (_vediv_f_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_div_ps, _mm256_setzero_ps, _anyeq256_ps)
+_vdiv_simd (_vediv_d_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_div_pd, _mm256_setzero_pd, _anyeq256_pd)
+
+_vdot_simd (_vdot_f_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_mul_ps, _mm_setzero_ps)
+_vdot_simd (_vdot_d_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_mul_pd, _mm_setzero_pd)
+_vdot_simd (_vdot_f_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, _mm256_mul_ps, _mm256_setzero_ps)
+_vdot_simd (_vdot_d_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_add_pd, _mm256_mul_pd, _mm256_setzero_pd)
+
+/*!
+ * \brief
+ *    Complex multiplication of two interleaved complex float pairs using SSE2
+ */
+__target_sse2__ static inline __m128 _vcmul_sse2 (__m128 a, __m128 b) {
+   const __m128 neg_re = _mm_castsi128_ps (_mm_set_epi32 (0, 0x80000000, 0, 0x80000000));
+   __m128 br = _mm_shuffle_ps (b, b, _MM_SHUFFLE (2,2,0,0));
+   __m128 bi = _mm_shuffle_ps (b, b, _MM_SHUFFLE (3,3,1,1));
+   __m128 as = _mm_shuffle_ps (a, a, _MM_SHUFFLE (2,3,0,1));
+   return _mm_add_ps (_mm_mul_ps (a, br), _mm_xor_ps (_mm_mul_ps (as, bi), neg_re));
+}
+
+/*!
+ * \brief
+ *    Complex multiplication of four interleaved complex floats using AVX
+ */
+__target_avx2__ static inline __m256 _vcmul_avx2 (__m256 a, __m256 b) {
+   __m256 br = _mm256_moveldup_ps (b);
+   __m256 bi = _mm256_movehdup_ps (b);
+   __m256 as = _mm256_permute_ps (a, _MM_SHUFFLE (2,3,0,1));
+   return _mm256_addsub_ps (_mm256_mul_ps (a, br), _mm256_mul_ps (as, bi));
+}
+
+/*!
+ * \brief
+ *    Complex multiplication of one complex double using SSE2
+ */
+__target_sse2__ static inline __m128d _vcmul_pd_sse2 (__m128d a, __m128d b) {
+   const __m128d neg_re = _mm_castsi128_pd (_mm_set_epi32 (0, 0, 0x80000000, 0));
+   __m128d br = _mm_unpacklo_pd (b, b);
+   __m128d bi = _mm_unpackhi_pd (b, b);
+   __m128d as = _mm_shuffle_pd (a, a, 1);
+   return _mm_add_pd (_mm_mul_pd (a, br), _mm_xor_pd (_mm_mul_pd (as, bi), neg_re));
+}
+
+/*!
+ * \brief
+ *    Complex multiplication of two interleaved complex doubles using AVX
+ */
+__target_avx2__ static inline __m256d _vcmul_pd_avx2 (__m256d a, __m256d b) {
+   __m256d br = _mm256_movedup_pd (b);
+   __m256d bi = _mm256_permute_pd (b, 0xF);
+   __m256d as = _mm256_permute_pd (a, 0x5);
+   return _mm256_addsub_pd (_mm256_mul_pd (a, br), _mm256_mul_pd (as, bi));
+}
+
+__target_sse2__ static void _vemul_cf_sse2 (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n) {
+   int i;
+   for (i=0 ; i+2<=n ; i+=2)
+      _mm_storeu_ps ((float*)&y[i], _vcmul_sse2 (_mm_loadu_ps ((float*)&a[i]), _mm_loadu_ps ((float*)&b[i])));
+   for ( ; i<n ; ++i)
+      y[i] = a[i] * b[i];
+}
+
+__target_avx2__ static void _vemul_cf_avx2 (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n) {
+   int i;
+   for (i=0 ; i+4<=n ; i+=4)
+      _mm256_storeu_ps ((float*)&y[i], _vcmul_avx2 (_mm256_loadu_ps ((float*)&a[i]), _mm256_loadu_ps ((float*)&b[i])));
+   for ( ; i<n ; ++i)
+      y[i] = a[i] * b[i];
+}
+
+__target_sse2__ static void _vemul_cd_sse2 (complex_d_t *y, complex_d_t *a, complex_d_t *b, int n) {
+   int i;
+   for (i=0 ; i<n ; ++i)
+      _mm_storeu_pd ((double*)&y[i], _vcmul_pd_sse2 (_mm_loadu_pd ((double*)&a[i]), _mm_loadu_pd ((double*)&b[i])));
+}
+
+__target_avx2__ static void _vemul_cd_avx2 (complex_d_t *y, complex_d_t *a, complex_d_t *b, int n) {
+   int i;
+   for (i=0 ; i+2<=n ; i+=2)
+      _mm256_storeu_pd ((double*)&y[i], _vcmul_pd_avx2 (_mm256_loadu_pd ((double*)&a[i]), _mm256_loadu_pd ((double*)&b[i])));
+   for ( ; i<n ; ++i)
+      y[i] = a[i] * b[i];
+}
+
+/*!
+ * \brief
+ *    Complex float division a*b'/|b|^2 of two complex pairs using SSE2.
+ *    Smith's scaling: b is divided by s = max(|br|,|bi|) first, so |b|^2
+ *    stays in [1..2] and a*b' can not overflow. A vector with a denormal a
+ *    or b, an infinite or NaN b, or a result that is not finite is done
+ *    again by the scalar kernel.
+ */
+__target_sse2__ static int _vediv_cf_sse2 (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n) {
+   const __m128 neg_im = _mm_castsi128_ps (_mm_set_epi32 (0x80000000, 0, 0x80000000, 0));
+   const __m128 msk = _mm_castsi128_ps (_mm_set1_epi32 (0x7FFFFFFF));
+   const __m128 lo = _mm_set1_ps (FLT_MIN), hi = _mm_set1_ps (FLT_MAX);
+   __m128 va, vb, sb, d, r, e;
+   int i, m;
+   for (i=0 ; i+2<=n ; i+=2) {
+      va = _mm_loadu_ps ((float*)&a[i]);
+      vb = _mm_loadu_ps ((float*)&b[i]);
+      m = _anyeq_ps (vb, _mm_setzero_ps ());
+      if (m & (m>>1) & 0x5)
+         return 1;
+      sb = _mm_and_ps (vb, msk);
+      sb = _mm_max_ps (sb, _mm_shuffle_ps (sb, sb, _MM_SHUFFLE (2,3,0,1)));
+      vb = _mm_div_ps (vb, sb);
+      d = _mm_mul_ps (vb, vb);
+      d = _mm_add_ps (d, _mm_shuffle_ps (d, d, _MM_SHUFFLE (2,3,0,1)));
+      vb = _mm_xor_ps (vb, neg_im);
+      r = _mm_div_ps (_mm_div_ps (_vcmul_sse2 (va, vb), d), sb);
+      e = _mm_or_ps (_mm_cmplt_ps (sb, lo), _mm_cmpnle_ps (sb, hi));
+      e = _mm_or_ps (e, _mm_cmpnle_ps (_mm_and_ps (r, msk), hi));
+      e = _mm_or_ps (e, _mm_and_ps (_mm_cmplt_ps (_mm_and_ps (va, msk), lo), _mm_cmpneq_ps (va, _mm_setzero_ps ())));
+      if (_mm_movemask_ps (e))
+         _vediv_cf_scalar (&y[i], &a[i], &b[i], 2);
+      else
+         _mm_storeu_ps ((float*)&y[i], r);
+   }
+   return _vediv_cf_scalar (&y[i], &a[i], &b[i], n-i);
+}
+
+/*!
+ * \brief
+ *    Complex float division a*b'/|b|^2 of four complex numbers using AVX,
+ *    with the scaling and the checks of _vediv_cf_sse2().
+ */
+__target_avx2__ static int _vediv_cf_avx2 (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n) {
+   const __m256 neg_im = _mm256_castsi256_ps (_mm256_set_epi32 (0x80000000, 0, 0x80000000, 0,
+                                                                0x80000000, 0, 0x80000000, 0));
+   const __m256 msk = _mm256_castsi256_ps (_mm256_set1_epi32 (0x7FFFFFFF));
+   const __m256 lo = _mm256_set1_ps (FLT_MIN), hi = _mm256_set1_ps (FLT_MAX);
+   __m256 va, vb, sb, d, r, e;
+   int i, m;
+   for (i=0 ; i+4<=n ; i+=4) {
+      va = _mm256_loadu_ps ((float*)&a[i]);
+      vb = _mm256_loadu_ps ((float*)&b[i]);
+      m = _anyeq256_ps (vb, _mm256_setzero_ps ());
+      if (m & (m>>1) & 0x55)
+         return 1;
+      sb = _mm256_and_ps (vb, msk);
+      sb = _mm256_max_ps (sb, _mm256_permute_ps (sb, _MM_SHUFFLE (2,3,0,1)));
+      vb = _mm256_div_ps (vb, sb);
+      d = _mm256_mul_ps (vb, vb);
+      d = _mm256_add_ps (d, _mm256_permute_ps (d, _MM_SHUFFLE (2,3,0,1)));
+      vb = _mm256_xor_ps (vb, neg_im);
+      r = _mm256_div_ps (_mm256_div_ps (_vcmul_avx2 (va, vb), d), sb);
+      e = _mm256_or_ps (_mm256_cmp_ps (sb, lo, _CMP_LT_OQ), _mm256_cmp_ps (sb, hi, _CMP_NLE_UQ));
+      e = _mm256_or_ps (e, _mm256_cmp_ps (_mm256_and_ps (r, msk), hi, _CMP_NLE_UQ));
+      e = _mm256_or_ps (e, _mm256_and_ps (_mm256_cmp_ps (_mm256_and_ps (va, msk), lo, _CMP_LT_OQ),
+                                          _mm256_cmp_ps (va, _mm256_setzero_ps (), _CMP_NEQ_UQ)));
+      if (_mm256_movemask_ps (e))
+         _vediv_cf_scalar (&y[i], &a[i], &b[i], 4);
+      else
+         _mm256_storeu_ps ((float*)&y[i], r);
+   }
+   return _vediv_cf_scalar (&y[i], &a[i], &b[i], n-i);
+}
+
+/*!
+ * \brief
+ *    Complex float dot product. With P = a.*b and Q = a.*swap(b)
+ *    Re{a'b} = Sum P, Im{a'b} = Sum Q[even] - Sum Q[odd]
+ */
+__target_sse2__ static complex_f_t _vdot_cf_sse2 (const complex_f_t *restrict a, const complex_f_t *restrict b, int n) {
+   __m128 va, vb, p0 = _mm_setzero_ps (), q0 = _mm_setzero_ps ();
+   __m128 p1 = _mm_setzero_ps (), q1 = _mm_setzero_ps ();
+   float tp[4], tq[4];
+   complex_f_t res;
+   int i;
+   for (i=0 ; i+4<=n ; i+=4) {
+      va = _mm_loadu_ps ((const float*)&a[i]);
+      vb = _mm_loadu_ps ((const float*)&b[i]);
+      p0 = _mm_add_ps (p0, _mm_mul_ps (va, vb));
+      q0 = _mm_add_ps (q0, _mm_mul_ps (va, _mm_shuffle_ps (vb, vb, _MM_SHUFFLE (2,3,0,1))));
+      va = _mm_loadu_ps ((const float*)&a[i+2]);
+      vb = _mm_loadu_ps ((const float*)&b[i+2]);
+      p1 = _mm_add_ps (p1, _mm_mul_ps (va, vb));
+      q1 = _mm_add_ps (q1, _mm_mul_ps (va, _mm_shuffle_ps (vb, vb, _MM_SHUFFLE (2,3,0,1))));
+   }
+   _mm_storeu_ps (tp, _mm_add_ps (p0, p1));
+   _mm_storeu_ps (tq, _mm_add_ps (q0, q1));
+   res = (tp[0]+tp[1]+tp[2]+tp[3]) + I*((tq[0]+tq[2]) - (tq[1]+tq[3]));
+   return res + _vdot_cf_scalar (&a[i], &b[i], n-i);
+}
+
+__target_avx2__ static complex_f_t _vdot_cf_avx2 (const complex_f_t *restrict a, const complex_f_t *restrict b, int n) {
+   __m256 va, vb, p0 = _mm256_setzero_ps (), q0 = _mm256_setzero_ps ();
+   __m256 p1 = _mm256_setzero_ps (), q1 = _mm256_setzero_ps ();
+   float tp[8], tq[8];
+   complex_f_t res;
+   int i;
+   for (i=0 ; i+8<=n ; i+=8) {
+      va = _mm256_loadu_ps ((const float*)&a[i]);
+      vb = _mm256_loadu_ps ((const float*)&b[i]);
+      p0 = _mm256_add_ps (p0, _mm256_mul_ps (va, vb));
+      q0 = _mm256_add_ps (q0, _mm256_mul_ps (va, _mm256_permute_ps (vb, _MM_SHUFFLE (2,3,0,1))));
+      va = _mm256_loadu_ps ((const float*)&a[i+4]);
+      vb = _mm256_loadu_ps ((const float*)&b[i+4]);
+      p1 = _mm256_add_ps (p1, _mm256_mul_ps (va, vb));
+      q1 = _mm256_add_ps (q1, _mm256_mul_ps (va, _mm256_permute_ps (vb, _MM_SHUFFLE (2,3,0,1))));
+   }
+   _mm256_storeu_ps (tp, _mm256_add_ps (p0, p1));
+   _mm256_storeu_ps (tq, _mm256_add_ps (q0, q1));
+   res = ((tp[0]+tp[1]+tp[2]+tp[3]) + (tp[4]+tp[5]+tp[6]+tp[7]))
+       + I*(((tq[0]+tq[2]) + (tq[4]+tq[6])) - ((tq[1]+tq[3]) + (tq[5]+tq[7])));
+   return res + _vdot_cf_scalar (&a[i], &b[i], n-i);
+}
+
+/*!
+ * Fused real kernels, two vectors per step and scalar tail
+ * \param   _name    Kernel name
+ * \param   _target  Target attribute
+ * \param   _type    Data type
+ * \param   _vt      Vector type
+ * \param   _w       Items per vector
+ * \param   _ld      Unaligned load
+ * \param   _st      Unaligned store
+ * \param   _set1    Broadcast
+ * \param   _add     Vector addition
+ * \param   _mul     Vector multiplication
+ */
+#define  _vaxpy_simd(_name, _target, _type, _vt, _w, _ld, _st, _set1, _add, _mul)  \
+_target static void _name (_type *y, _type a, _type *x, int n) {             \
+   _vt va = _set1 (a);                                                       \
+   int i;                                                                    \
+   for (i=0 ; i+2*(_w)<=n ; i+=2*(_w)) {                                     \
+      _st (&y[i], _add (_ld (&y[i]), _mul (va, _ld (&x[i]))));               \
+      _st (&y[i+(_w)], _add (_ld (&y[i+(_w)]), _mul (va, _ld (&x[i+(_w)])))); \
+   }                                                                         \
+   for ( ; i<n ; ++i)                                                        \
+      y[i] += a * x[i];                                                      \
+}
+#define  _vscale_simd(_name, _target, _type, _vt, _w, _ld, _st, _set1, _add, _mul) \
+_target static void _name (_type *y, _type *x, _type a, _type b, int n) {    \
+   _vt va = _set1 (a), vb = _set1 (b);                                       \
+   int i;                                                                    \
+   for (i=0 ; i+2*(_w)<=n ; i+=2*(_w)) {                                     \
+      _st (&y[i], _add (_mul (va, _ld (&x[i])), vb));                        \
+      _st (&y[i+(_w)], _add (_mul (va, _ld (&x[i+(_w)])), vb));              \
+   }                                                                         \
+   for ( ; i<n ; ++i)                                                        \
+      y[i] = a * x[i] + b;                                                   \
+}
+#define  _vmac_simd(_name, _target, _type, _vt, _w, _ld, _st, _add, _mul)    \
+_target static void _name (_type *y, _type *a, _type *b, int n) {            \
+   int i;                                                                    \
+   for (i=0 ; i+2*(_w)<=n ; i+=2*(_w)) {                                     \
+      _st (&y[i], _add (_ld (&y[i]), _mul (_ld (&a[i]), _ld (&b[i]))));      \
+      _st (&y[i+(_w)], _add (_ld (&y[i+(_w)]), _mul (_ld (&a[i+(_w)]), _ld (&b[i+(_w)])))); \
+   }                                                                         \
+   for ( ; i<n ; ++i)                                                        \
+      y[i] += a[i] * b[i];                                                   \
+}
+#define  _vclamp_simd(_name, _target, _type, _vt, _w, _ld, _st, _set1, _min, _max) \
+_target static void _name (_type *y, _type *x, _type lo, _type hi, int n) {  \
+   _vt vl = _set1 (lo), vh = _set1 (hi);                                     \
+   int i;                                                                    \
+   for (i=0 ; i+2*(_w)<=n ; i+=2*(_w)) {                                     \
+      _st (&y[i], _min (_max (_ld (&x[i]), vl), vh));                        \
+      _st (&y[i+(_w)], _min (_max (_ld (&x[i+(_w)]), vl), vh));              \
+   }                                                                         \
+   for ( ; i<n ; ++i)                                                        \
+      y[i] = (x[i] < lo) ? lo : ((x[i] > hi) ? hi : x[i]);                   \
+}
+
+_vaxpy_simd (_vaxpy_f_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_add_ps, _mm_mul_ps)
+_vaxpy_simd (_vaxpy_d_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_add_pd, _mm_mul_pd)
+_vaxpy_simd (_vaxpy_f_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_add_ps, _mm256_mul_ps)
+_vaxpy_simd (_vaxpy_d_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_add_pd, _mm256_mul_pd)
+_vscale_simd (_vscale_f_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_add_ps, _mm_mul_ps)
+_vscale_simd (_vscale_d_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_add_pd, _mm_mul_pd)
+_vscale_simd (_vscale_f_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_add_ps, _mm256_mul_ps)
+_vscale_simd (_vscale_d_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_add_pd, _mm256_mul_pd)
+_vmac_simd (_vmac_f_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_mul_ps)
+_vmac_simd (_vmac_d_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_mul_pd)
+_vmac_simd (_vmac_f_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, _mm256_mul_ps)
+_vmac_simd (_vmac_d_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_add_pd, _mm256_mul_pd)
+_vclamp_simd (_vclamp_f_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_min_ps, _mm_max_ps)
+_vclamp_simd (_vclamp_d_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_min_pd, _mm_max_pd)
+_vclamp_simd (_vclamp_f_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_min_ps, _mm256_max_ps)
+_vclamp_simd (_vclamp_d_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_min_pd, _mm256_max_pd)
+
+/*
+ * Fused complex float kernels
+ */
+#define  _vset1_cf_sse2(_a)      _mm_setr_ps (crealf (_a), cimagf (_a), crealf (_a), cimagf (_a))
+#define  _vset1_cf_avx2(_a)      _mm256_setr_ps (crealf (_a), cimagf (_a), crealf (_a), cimagf (_a), \
+                                                 crealf (_a), cimagf (_a), crealf (_a), cimagf (_a))
+
+__target_sse2__ static void _vaxpy_cf_sse2 (complex_f_t *y, complex_f_t a, complex_f_t *x, int n) {
+   __m128 va = _vset1_cf_sse2 (a);
+   int i;
+   for (i=0 ; i+2<=n ; i+=2)
+      _mm_storeu_ps ((float*)&y[i], _mm_add_ps (_mm_loadu_ps ((float*)&y[i]),
+                                                _vcmul_sse2 (_mm_loadu_ps ((float*)&x[i]), va)));
+   _vaxpy_cf_scalar (&y[i], a, &x[i], n-i);
+}
+
+__target_avx2__ static void _vaxpy_cf_avx2 (complex_f_t *y, complex_f_t a, complex_f_t *x, int n) {
+   __m256 va = _vset1_cf_avx2 (a);
+   int i;
+   for (i=0 ; i+4<=n ; i+=4)
+      _mm256_storeu_ps ((float*)&y[i], _mm256_add_ps (_mm256_loadu_ps ((float*)&y[i]),
+                                                      _vcmul_avx2 (_mm256_loadu_ps ((float*)&x[i]), va)));
+   _vaxpy_cf_scalar (&y[i], a, &x[i], n-i);
+}
+
+__target_sse2__ static void _vscale_cf_sse2 (complex_f_t *y, complex_f_t *x, complex_f_t a, complex_f_t b, int n) {
+   __m128 va = _vset1_cf_sse2 (a), vb = _vset1_cf_sse2 (b);
+   int i;
+   for (i=0 ; i+2<=n ; i+=2)
+      _mm_storeu_ps ((float*)&y[i], _mm_add_ps (_vcmul_sse2 (_mm_loadu_ps ((float*)&x[i]), va), vb));
+   _vscale_cf_scalar (&y[i], &x[i], a, b, n-i);
+}
+
+__target_avx2__ static void _vscale_cf_avx2 (complex_f_t *y, complex_f_t *x, complex_f_t a, complex_f_t b, int n) {
+   __m256 va = _vset1_cf_avx2 (a), vb = _vset1_cf_avx2 (b);
+   int i;
+   for (i=0 ; i+4<=n ; i+=4)
+      _mm256_storeu_ps ((float*)&y[i], _mm256_add_ps (_vcmul_avx2 (_mm256_loadu_ps ((float*)&x[i]), va), vb));
+   _vscale_cf_scalar (&y[i], &x[i], a, b, n-i);
+}
+
+__target_sse2__ static void _vmac_cf_sse2 (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n) {
+   int i;
+   for (i=0 ; i+2<=n ; i+=2)
+      _mm_storeu_ps ((float*)&y[i], _mm_add_ps (_mm_loadu_ps ((float*)&y[i]),
+                     _vcmul_sse2 (_mm_loadu_ps ((float*)&a[i]), _mm_loadu_ps ((float*)&b[i]))));
+   _vmac_cf_scalar (&y[i], &a[i], &b[i], n-i);
+}
+
+__target_avx2__ static void _vmac_cf_avx2 (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n) {
+   int i;
+   for (i=0 ; i+4<=n ; i+=4)
+      _mm256_storeu_ps ((float*)&y[i], _mm256_add_ps (_mm256_loadu_ps ((float*)&y[i]),
+                        _vcmul_avx2 (_mm256_loadu_ps ((float*)&a[i]), _mm256_loadu_ps ((float*)&b[i]))));
+   _vmac_cf_scalar (&y[i], &a[i], &b[i], n-i);
+}
+
+__target_sse2__ static void _vcmac_cf_sse2 (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n) {
+   const __m128 neg_im = _mm_castsi128_ps (_mm_set_epi32 (0x80000000, 0, 0x80000000, 0));
+   int i;
+   for (i=0 ; i+2<=n ; i+=2)
+      _mm_storeu_ps ((float*)&y[i], _mm_add_ps (_mm_loadu_ps ((float*)&y[i]),
+                     _vcmul_sse2 (_mm_xor_ps (_mm_loadu_ps ((float*)&a[i]), neg_im), _mm_loadu_ps ((float*)&b[i]))));
+   _vcmac_cf_scalar (&y[i], &a[i], &b[i], n-i);
+}
+
+__target_avx2__ static void _vcmac_cf_avx2 (complex_f_t *y, complex_f_t *a, complex_f_t *b, int n) {
+   const __m256 neg_im = _mm256_castsi256_ps (_mm256_set_epi32 (0x80000000, 0, 0x80000000, 0,
+                                                                0x80000000, 0, 0x80000000, 0));
+   int i;
+   for (i=0 ; i+4<=n ; i+=4)
+      _mm256_storeu_ps ((float*)&y[i], _mm256_add_ps (_mm256_loadu_ps ((float*)&y[i]),
+                        _vcmul_avx2 (_mm256_xor_ps (_mm256_loadu_ps ((float*)&a[i]), neg_im), _mm256_loadu_ps ((float*)&b[i]))));
+   _vcmac_cf_scalar (&y[i], &a[i], &b[i], n-i);
+}
+
+/*!
+ * Split complex kernels. The real and imaginary parts are already in
+ * separate vectors, so there are no shuffles.
+ * \param   _name    Kernel name
+ * \param   _target  Target attribute
+ * \param   _type    Real data type
+ * \param   _ctype   Complex data type
+ * \param   _vt      Vector type
+ * \param   _w       Items per vector
+ * \param   _ld      Unaligned load
+ * \param   _st      Unaligned store
+ * \param   _add     Vector addition
+ * \param   _sub     Vector subtraction
+ * \param   _mul     Vector multiplication
+ * \param   _zero    Vector of zeros
+ * \param   _scalar  Scalar kernel for the tail
+ */
+#define  _vemul_split_simd(_name, _target, _type, _vt, _w, _ld, _st, _add, _sub, _mul, _scalar) \
+_target static void _name (_type *yr, _type *yi, _type *ar, _type *ai, _type *br, _type *bi, int n) { \
+   _vt var, vai, vbr, vbi;                                                   \
+   int i;                                                                    \
+   for (i=0 ; i+(_w)<=n ; i+=(_w)) {                                         \
+      var = _ld (&ar[i]);  vai = _ld (&ai[i]);                               \
+      vbr = _ld (&br[i]);  vbi = _ld (&bi[i]);                               \
+      _st (&yr[i], _sub (_mul (var, vbr), _mul (vai, vbi)));                 \
+      _st (&yi[i], _add (_mul (var, vbi), _mul (vai, vbr)));                 \
+   }                                                                         \
+   _scalar (&yr[i], &yi[i], &ar[i], &ai[i], &br[i], &bi[i], n-i);            \
+}
+#define  _vdot_split_simd(_name, _target, _type, _ctype, _vt, _w, _ld, _st, _add, _sub, _mul, _zero, _scalar) \
+_target static _ctype _name (const _type *restrict ar, const _type *restrict ai, \
+                             const _type *restrict br, const _type *restrict bi, int n) { \
+   _vt var, vai, vbr, vbi;                                                   \
+   _vt r0 = _zero (), r1 = _zero (), m0 = _zero (), m1 = _zero ();           \
+   _type tr[_w], tm[_w], sr = 0, sm = 0;                                     \
+   int i, j;                                                                 \
+   for (i=0 ; i+(_w)<=n ; i+=(_w)) {                                         \
+      var = _ld (&ar[i]);  vai = _ld (&ai[i]);                               \
+      vbr = _ld (&br[i]);  vbi = _ld (&bi[i]);                               \
+      r0 = _add (r0, _mul (var, vbr));                                       \
+      r1 = _add (r1, _mul (vai, vbi));                                       \
+      m0 = _add (m0, _mul (var, vbi));                                       \
+      m1 = _add (m1, _mul (vai, vbr));                                       \
+   }                                                                         \
+   _st (tr, _add (r0, r1));                                                  \
+   _st (tm, _sub (m0, m1));                                                  \
+   for (j=0 ; j<(_w) ; ++j) {                                                \
+      sr += tr[j];                                                           \
+      sm += tm[j];                                                           \
+   }                                                                         \
+   return (sr + I*sm) + _scalar (&ar[i], &ai[i], &br[i], &bi[i], n-i);       \
+}
+
+_vemul_split_simd (_vemul_sf_sse2, __target_sse2__, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _vemul_sf_scalar)
+_vemul_split_simd (_vemul_sd_sse2, __target_sse2__, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_sub_pd, _mm_mul_pd, _vemul_sd_scalar)
+_vemul_split_simd (_vemul_sf_avx2, __target_avx2__, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _vemul_sf_scalar)
+_vemul_split_simd (_vemul_sd_avx2, __target_avx2__, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_add_pd, _mm256_sub_pd, _mm256_mul_pd, _vemul_sd_scalar)
+_vdot_split_simd (_vdot_sf_sse2, __target_sse2__, float, complex_f_t, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_setzero_ps, _vdot_sf_scalar)
+_vdot_split_simd (_vdot_sd_sse2, __target_sse2__, double, complex_d_t, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_sub_pd, _mm_mul_pd, _mm_setzero_pd, _vdot_sd_scalar)
+_vdot_split_simd (_vdot_sf_avx2, __target_avx2__, float, complex_f_t, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_setzero_ps, _vdot_sf_scalar)
+_vdot_split_simd (_vdot_sd_avx2, __target_avx2__, double, complex_d_t, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_add_pd, _mm256_sub_pd, _mm256_mul_pd, _mm256_setzero_pd, _vdot_sd_scalar)
+#endif   // #ifdef TBX_SIMD_X86
+
+static const _vop_f_pt   _vadd_f[]   = TBX_ISA_KRN (_vadd_f);
+static const _vop_f_pt   _vsub_f[]   = TBX_ISA_KRN (_vsub_f);
+static const _vop_f_pt   _vemul_f[]  = TBX_ISA_KRN (_vemul_f);
+static const _vop_d_pt   _vadd_d[]   = TBX_ISA_KRN (_vadd_d);
+static const _vop_d_pt   _vsub_d[]   = TBX_ISA_KRN (_vsub_d);
+static const _vop_d_pt   _vemul_d[]  = TBX_ISA_KRN (_vemul_d);
+static const _vop_cf_pt  _vemul_cf[] = TBX_ISA_KRN (_vemul_cf);
+static const _vop_cd_pt  _vemul_cd[] = TBX_ISA_KRN (_vemul_cd);
+static const _vdiv_f_pt  _vediv_f[]  = TBX_ISA_KRN (_vediv_f);
+static const _vdiv_d_pt  _vediv_d[]  = TBX_ISA_KRN (_vediv_d);
+static const _vdiv_cf_pt _vediv_cf[] = TBX_ISA_KRN (_vediv_cf);
+static const _vdot_f_pt  _vdot_f[]   = TBX_ISA_KRN (_vdot_f);
+static const _vdot_d_pt  _vdot_d[]   = TBX_ISA_KRN (_vdot_d);
+static const _vdot_cf_pt _vdot_cf[]  = TBX_ISA_KRN (_vdot_cf);
+static const _vaxpy_f_pt  _vaxpy_f[]  = TBX_ISA_KRN (_vaxpy_f);
+static const _vaxpy_d_pt  _vaxpy_d[]  = TBX_ISA_KRN (_vaxpy_d);
+static const _vaxpy_cf_pt _vaxpy_cf[] = TBX_ISA_KRN (_vaxpy_cf);
+static const _vscale_f_pt  _vscale_f[]  = TBX_ISA_KRN (_vscale_f);
+static const _vscale_d_pt  _vscale_d[]  = TBX_ISA_KRN (_vscale_d);
+static const _vscale_cf_pt _vscale_cf[] = TBX_ISA_KRN (_vscale_cf);
+static const _vop_f_pt   _vmac_f[]   = TBX_ISA_KRN (_vmac_f);
+static const _vop_d_pt   _vmac_d[]   = TBX_ISA_KRN (_vmac_d);
+static const _vop_cf_pt  _vmac_cf[]  = TBX_ISA_KRN (_vmac_cf);
+static const _vop_cf_pt  _vcmac_cf[] = TBX_ISA_KRN (_vcmac_cf);
+static const _vclamp_f_pt _vclamp_f[] = TBX_ISA_KRN (_vclamp_f);
+static const _vclamp_d_pt _vclamp_d[] = TBX_ISA_KRN (_vclamp_d);
+static const _vemul_sf_pt _vemul_sf[] = TBX_ISA_KRN (_vemul_sf);
+static const _vemul_sd_pt _vemul_sd[] = TBX_ISA_KRN (_vemul_sd);
+static const _vdot_sf_pt  _vdot_sf[]  = TBX_ISA_KRN (_vdot_sf);
+static const _vdot_sd_pt  _vdot_sd[]  = TBX_ISA_KRN (_vdot_sd);
+
+#undef _vop_scalar
+#undef _vdiv_scalar
+#undef _vdot_scalar
+#undef _vop_simd
+#undef _vdiv_simd
+#undef _vdot_simd
+#undef _vaxpy_scalar
+#undef _vscale_scalar
+#undef _vmac_scalar
+#undef _vclamp_scalar
+#undef _vaxpy_simd
+#undef _vscale_simd
+#undef _vmac_simd
+#undef _vclamp_simd
+#undef _vemul_split_scalar
+#undef _vdot_split_scalar
+#undef _vemul_split_simd
+#undef _vdot_split_simd
+
 
 /*
  * ================== Public API ====================
@@ -47,11 +825,15 @@
    }                                                           \
 }
 void vadd_i (int *y, int *a, int *b, int length) { _vadd_body(); }
-void vadd_f (float *y, float *a, float *b, int length) {_vadd_body(); }
-void vadd_d (double *y, double *a, double *b, int length) { _vadd_body(); }
+void vadd_f (float *y, float *a, float *b, int length) { _vadd_f[tbx_isa ()] (y, a, b, length); }
+void vadd_d (double *y, double *a, double *b, int length) { _vadd_d[tbx_isa ()] (y, a, b, length); }
 void vadd_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vadd_body(); }
-void vadd_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vadd_body(); }
-void vadd_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vadd_body(); }
+void vadd_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) {
+   _vadd_f[tbx_isa ()] ((float*)y, (float*)a, (float*)b, 2*length);
+}
+void vadd_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) {
+   _vadd_d[tbx_isa ()] ((double*)y, (double*)a, (double*)b, 2*length);
+}
 #undef _vadd_body
 
 /*!
@@ -74,11 +856,15 @@ void vadd_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vad
    }                                                           \
 }
 void vsub_i (int *y, int *a, int *b, int length) { _vsub_body(); }
-void vsub_f (float *y, float *a, float *b, int length) { _vsub_body(); }
-void vsub_d (double *y, double *a, double *b, int length) { _vsub_body(); }
+void vsub_f (float *y, float *a, float *b, int length) { _vsub_f[tbx_isa ()] (y, a, b, length); }
+void vsub_d (double *y, double *a, double *b, int length) { _vsub_d[tbx_isa ()] (y, a, b, length); }
 void vsub_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vsub_body(); }
-void vsub_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vsub_body(); }
-void vsub_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vsub_body(); }
+void vsub_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) {
+   _vsub_f[tbx_isa ()] ((float*)y, (float*)a, (float*)b, 2*length);
+}
+void vsub_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) {
+   _vsub_d[tbx_isa ()] ((double*)y, (double*)a, (double*)b, 2*length);
+}
 #undef _vsub_body
 
 
@@ -102,11 +888,11 @@ void vsub_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vsu
    }                                                           \
 }
 void vemul_i (int *y, int *a, int *b, int length) { _vemul_body(); }
-void vemul_f (float *y, float *a, float *b, int length) {_vemul_body(); }
-void vemul_d (double *y, double *a, double *b, int length) { _vemul_body(); }
+void vemul_f (float *y, float *a, float *b, int length) { _vemul_f[tbx_isa ()] (y, a, b, length); }
+void vemul_d (double *y, double *a, double *b, int length) { _vemul_d[tbx_isa ()] (y, a, b, length); }
 void vemul_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vemul_body(); }
-void vemul_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vemul_body(); }
-void vemul_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vemul_body(); }
+void vemul_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vemul_cf[tbx_isa ()] (y, a, b, length); }
+void vemul_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vemul_cd[tbx_isa ()] (y, a, b, length); }
 #undef _vemul_body
 
 
@@ -123,7 +909,7 @@ void vemul_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _ve
  *
  * \return The status of operation
  *    \arg  0  Success
- *    \arg  1  Fail, divide by zero
+ *    \arg  1  Fail, divide by zero. y is only partly calculated.
  */
 #define  _vediv_body_r() {                                     \
    /* Calculate vadd */                                        \
@@ -146,15 +932,141 @@ void vemul_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _ve
    return 0;                                                   \
 }
 int vediv_i (int *y, int *a, int *b, int length) { _vediv_body_r(); }
-int vediv_f (float *y, float *a, float *b, int length) {_vediv_body_r(); }
-int vediv_d (double *y, double *a, double *b, int length) { _vediv_body_r(); }
+int vediv_f (float *y, float *a, float *b, int length) { return _vediv_f[tbx_isa ()] (y, a, b, length); }
+int vediv_d (double *y, double *a, double *b, int length) { return _vediv_d[tbx_isa ()] (y, a, b, length); }
 int vediv_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vediv_body_c(); }
-int vediv_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vediv_body_c(); }
+int vediv_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { return _vediv_cf[tbx_isa ()] (y, a, b, length); }
 int vediv_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vediv_body_c(); }
 #undef _vediv_body_r
 #undef _vediv_body_c
 
 
+/*!
+ * \brief
+ *    Adds a scaled vector to y, in place
+ *
+ *   y[n] += a * x[n]
+ *
+ * \param      y  Pointer to input/output vector
+ * \param      a  The scale factor
+ * \param      x  Pointer to vector x
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define  _vaxpy_body() {                                       \
+   for (--length ; length>=0 ; --length) {                     \
+      y[length] += a * x[length];                              \
+   }                                                           \
+}
+void vaxpy_i (int *y, int a, int *x, int length) { _vaxpy_body(); }
+void vaxpy_f (float *y, float a, float *x, int length) { _vaxpy_f[tbx_isa ()] (y, a, x, length); }
+void vaxpy_d (double *y, double a, double *x, int length) { _vaxpy_d[tbx_isa ()] (y, a, x, length); }
+void vaxpy_ci (complex_i_t *y, complex_i_t a, complex_i_t *x, int length) { _vaxpy_body(); }
+void vaxpy_cf (complex_f_t *y, complex_f_t a, complex_f_t *x, int length) { _vaxpy_cf[tbx_isa ()] (y, a, x, length); }
+void vaxpy_cd (complex_d_t *y, complex_d_t a, complex_d_t *x, int length) { _vaxpy_body(); }
+#undef _vaxpy_body
+
+/*!
+ * \brief
+ *    Scales and offsets a vector in one pass
+ *
+ *   y[n] = a * x[n] + b
+ *
+ * \param      y  Pointer to output vector, can be the same as x
+ * \param      x  Pointer to vector x
+ * \param      a  The scale factor
+ * \param      b  The offset
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define  _vscale_body() {                                      \
+   for (--length ; length>=0 ; --length) {                     \
+      y[length] = a * x[length] + b;                           \
+   }                                                           \
+}
+void vscale_i (int *y, int *x, int a, int b, int length) { _vscale_body(); }
+void vscale_f (float *y, float *x, float a, float b, int length) { _vscale_f[tbx_isa ()] (y, x, a, b, length); }
+void vscale_d (double *y, double *x, double a, double b, int length) { _vscale_d[tbx_isa ()] (y, x, a, b, length); }
+void vscale_ci (complex_i_t *y, complex_i_t *x, complex_i_t a, complex_i_t b, int length) { _vscale_body(); }
+void vscale_cf (complex_f_t *y, complex_f_t *x, complex_f_t a, complex_f_t b, int length) {
+   _vscale_cf[tbx_isa ()] (y, x, a, b, length);
+}
+void vscale_cd (complex_d_t *y, complex_d_t *x, complex_d_t a, complex_d_t b, int length) { _vscale_body(); }
+#undef _vscale_body
+
+/*!
+ * \brief
+ *    Element-wise multiply-accumulate
+ *
+ *   y[n] += a[n] .* b[n]
+ *
+ * \param      y  Pointer to input/output vector
+ * \param      a  Pointer to vector a
+ * \param      b  Pointer to vector b
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define  _vmac_body() {                                        \
+   for (--length ; length>=0 ; --length) {                     \
+      y[length] += a[length] * b[length];                      \
+   }                                                           \
+}
+void vmac_i (int *y, int *a, int *b, int length) { _vmac_body(); }
+void vmac_f (float *y, float *a, float *b, int length) { _vmac_f[tbx_isa ()] (y, a, b, length); }
+void vmac_d (double *y, double *a, double *b, int length) { _vmac_d[tbx_isa ()] (y, a, b, length); }
+void vmac_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vmac_body(); }
+void vmac_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vmac_cf[tbx_isa ()] (y, a, b, length); }
+void vmac_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vmac_body(); }
+#undef _vmac_body
+
+/*!
+ * \brief
+ *    Element-wise complex conjugate multiply-accumulate
+ *
+ *   y[n] += a'[n] .* b[n]
+ *
+ * \param      y  Pointer to input/output vector
+ * \param      a  Pointer to vector a, used conjugated
+ * \param      b  Pointer to vector b
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define  _vcmac_body() {                                       \
+   for (--length ; length>=0 ; --length) {                     \
+      y[length] += conj(a[length]) * b[length];                \
+   }                                                           \
+}
+void vcmac_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vcmac_body(); }
+void vcmac_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vcmac_cf[tbx_isa ()] (y, a, b, length); }
+void vcmac_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vcmac_body(); }
+#undef _vcmac_body
+
+/*!
+ * \brief
+ *    Limits a vector to [lo, hi]
+ *
+ *   y[n] = min (max (x[n], lo), hi)
+ *
+ * \param      y  Pointer to output vector, can be the same as x
+ * \param      x  Pointer to vector x
+ * \param     lo  The lower limit
+ * \param     hi  The upper limit
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+void vclamp_i (int *y, int *x, int lo, int hi, int length) {
+   for (--length ; length>=0 ; --length)
+      y[length] = (x[length] < lo) ? lo : ((x[length] > hi) ? hi : x[length]);
+}
+void vclamp_f (float *y, float *x, float lo, float hi, int length) { _vclamp_f[tbx_isa ()] (y, x, lo, hi, length); }
+void vclamp_d (double *y, double *x, double lo, double hi, int length) { _vclamp_d[tbx_isa ()] (y, x, lo, hi, length); }
+
+
 /*!
  * \brief
  *    Calculates the dot product of a and b
@@ -185,15 +1097,39 @@ int vediv_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _ved
    return res;                                                 \
 }
 int vdot_i (int *a, int *b, int length) { int res; _vdot_body_r(); }
-float vdot_f (float *a, float *b, int length) {float res;  _vdot_body_r(); }
-double vdot_d (double *a, double *b, int length) { double res; _vdot_body_r(); }
+float vdot_f (float *a, float *b, int length) { return _vdot_f[tbx_isa ()] (a, b, length); }
+double vdot_d (double *a, double *b, int length) { return _vdot_d[tbx_isa ()] (a, b, length); }
 complex_i_t vdot_ci (complex_i_t *a, complex_i_t *b, int length) {complex_i_t res; _vdot_body_c(); }
-complex_f_t vdot_cf (complex_f_t *a, complex_f_t *b, int length) {complex_f_t res; _vdot_body_c(); }
+complex_f_t vdot_cf (complex_f_t *a, complex_f_t *b, int length) { return _vdot_cf[tbx_isa ()] (a, b, length); }
 complex_d_t vdot_cd (complex_d_t *a, complex_d_t *b, int length) {complex_d_t res; _vdot_body_c(); }
 
 #undef _vdot_body_r
 #undef _vdot_body_c
 
+/*!
+ * \brief
+ *    The main body of the pairwise dot product.
+ *    Blocks of VEC_PW_BLK items are summed by the multi-accumulator
+ *    kernel, then the block sums are added pairwise, by splitting the
+ *    range in two halves on a block boundary. So the rounding error grows
+ *    with log2(n/VEC_PW_BLK) instead of n.
+ *
+ * \param _type   The data type
+ * \param _krn    The kernel table
+ * \param _self   This function, for the recursion
+ */
+#define  _vdot_pw_body(_type, _krn, _self) {                   \
+   int h;                                                      \
+   if (length <= VEC_PW_BLK)                                   \
+      return _krn[tbx_isa ()] (a, b, length);                 \
+   h = ((length / VEC_PW_BLK + 1) / 2) * VEC_PW_BLK;           \
+   return _self (a, b, h) + _self (&a[h], &b[h], length - h);  \
+}
+float vdot_pw_f (float *a, float *b, int length) { _vdot_pw_body (float, _vdot_f, vdot_pw_f); }
+double vdot_pw_d (double *a, double *b, int length) { _vdot_pw_body (double, _vdot_d, vdot_pw_d); }
+complex_f_t vdot_pw_cf (complex_f_t *a, complex_f_t *b, int length) { _vdot_pw_body (complex_f_t, _vdot_cf, vdot_pw_cf); }
+#undef _vdot_pw_body
+
 /*!
  * \brief
  *    Calculates the norm (length) of a vector
@@ -222,14 +1158,116 @@ complex_d_t vdot_cd (complex_d_t *a, complex_d_t *b, int length) {complex_d_t re
    return csqrt (res);                                         \
 }
 float vnorm_i (int *x, int length) { float res; _vnorm_body_r(); }
-float vnorm_f (float *x, int length) { float res; _vnorm_body_r(); }
-double vnorm_d (double *x, int length) { double res; _vnorm_body_r(); }
+float vnorm_f (float *x, int length) { return sqrt (_vdot_f[tbx_isa ()] (x, x, length)); }
+double vnorm_d (double *x, int length) { return sqrt (_vdot_d[tbx_isa ()] (x, x, length)); }
 complex_f_t vnorm_ci (complex_i_t *x, int length) { complex_f_t res; _vnorm_body_c(); }
-complex_f_t vnorm_cf (complex_f_t *x, int length) { complex_f_t res; _vnorm_body_c(); }
+complex_f_t vnorm_cf (complex_f_t *x, int length) {
+   return sqrt (_vdot_f[tbx_isa ()] ((float*)x, (float*)x, 2*length));
+}
 complex_d_t vnorm_cd (complex_d_t *x, int length) { complex_d_t res; _vnorm_body_c(); }
 #undef _vnorm_body_r
 #undef _vnorm_body_c
 
+/*!
+ * \brief
+ *    Calculates the norm (length) of a vector with pairwise summation,
+ *    see vdot_pw()
+ *
+ * \param      x  Pointer to target vector a
+ * \param length  Size of vector
+ *
+ * \return The norm of vector
+ */
+float vnorm_pw_f (float *x, int length) { return sqrt (vdot_pw_f (x, x, length)); }
+double vnorm_pw_d (double *x, int length) { return sqrt (vdot_pw_d (x, x, length)); }
+complex_f_t vnorm_pw_cf (complex_f_t *x, int length) { return sqrt (vdot_pw_f ((float*)x, (float*)x, 2*length)); }
+
+
+/*!
+ * \brief
+ *    Converts an interleaved complex vector to split (SoA) layout
+ *
+ *   y.re[n] = Re{x[n]},  y.im[n] = Im{x[n]}
+ *
+ * \param      y  The split output buffers
+ * \param      x  Pointer to the interleaved complex vector
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define  _vsplit_body() {                                      \
+   for (--length ; length>=0 ; --length) {                     \
+      y.re[length] = __real__ x[length];                       \
+      y.im[length] = __imag__ x[length];                       \
+   }                                                           \
+}
+void vsplit_cf (split_f_t y, complex_f_t *x, int length) { _vsplit_body(); }
+void vsplit_cd (split_d_t y, complex_d_t *x, int length) { _vsplit_body(); }
+#undef _vsplit_body
+
+/*!
+ * \brief
+ *    Converts a split (SoA) complex vector to interleaved layout
+ *
+ *   y[n] = x.re[n] + j*x.im[n]
+ *
+ * \param      y  Pointer to the interleaved complex output vector
+ * \param      x  The split input buffers
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+#define  _vmerge_body() {                                      \
+   for (--length ; length>=0 ; --length) {                     \
+      __real__ y[length] = x.re[length];                       \
+      __imag__ y[length] = x.im[length];                       \
+   }                                                           \
+}
+void vmerge_cf (complex_f_t *y, split_f_t x, int length) { _vmerge_body(); }
+void vmerge_cd (complex_d_t *y, split_d_t x, int length) { _vmerge_body(); }
+#undef _vmerge_body
+
+/*!
+ * \brief
+ *    Calculates the element-wise multiplication of split complex a and b
+ *
+ *   y[n] = a[n] .* b[n]
+ *
+ * \param      y  The split output buffers, can be the same as a or b
+ * \param      a  The split buffers of vector a
+ * \param      b  The split buffers of vector b
+ * \param length  Size of vectors
+ *
+ * \return none
+ */
+void vemul_sf (split_f_t y, split_f_t a, split_f_t b, int length) {
+   _vemul_sf[tbx_isa ()] (y.re, y.im, a.re, a.im, b.re, b.im, length);
+}
+void vemul_sd (split_d_t y, split_d_t a, split_d_t b, int length) {
+   _vemul_sd[tbx_isa ()] (y.re, y.im, a.re, a.im, b.re, b.im, length);
+}
+
+/*!
+ * \brief
+ *    Calculates the dot product of split complex a and b
+ *
+ *                     N-1
+ *   r = <a[n],b[n]> = Sum {a'[m]*b[n]}
+ *                     n=0
+ *
+ * \param      a  The split buffers of vector a
+ * \param      b  The split buffers of vector b
+ * \param length  Size of vectors
+ *
+ * \return The dot product of a and b
+ */
+complex_f_t vdot_sf (split_f_t a, split_f_t b, int length) {
+   return _vdot_sf[tbx_isa ()] (a.re, a.im, b.re, b.im, length);
+}
+complex_d_t vdot_sd (split_d_t a, split_d_t b, int length) {
+   return _vdot_sd[tbx_isa ()] (a.re, a.im, b.re, b.im, length);
+}
+
 
 /*!
  * \brief
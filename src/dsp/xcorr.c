@@ -54,6 +54,155 @@
   }                                                   \
 }
 
+/*
+ * Lag limited bodies. Same sums as above, only for the
+ * outputs n: [sx-1-maxlag .. sx-1+maxlag] around zero lag.
+ */
+#define  _corr_lag_body_r() {                         \
+   int n, k, sy, kmin, kmax, n0, n1;                  \
+                                                      \
+   sy = sx + st - 1;                                  \
+   n0 = sx - 1 - maxlag;                              \
+   n1 = sx - 1 + maxlag;                              \
+   --sx; --st; /* Convert to last point */            \
+   for (n=n0; n<=n1; ++n, ++y) {                      \
+      if (n < 0 || n >= sy) {                         \
+         *y = 0;                                      \
+         continue;                                    \
+      }                                               \
+      kmax = (n - st < 0)       ? n : st;             \
+      kmin = ((k = n - sx) > 0) ? k : 0;              \
+      for (*y=0, k=kmin; k<=kmax; ++k)                \
+         *y += t[k] * x[sx-(n-k)];                    \
+   }                                                  \
+}
+
+#define  _corr_lag_body_c() {                         \
+   int n, k, sy, kmin, kmax, n0, n1;                  \
+                                                      \
+   sy = sx + st - 1;                                  \
+   n0 = sx - 1 - maxlag;                              \
+   n1 = sx - 1 + maxlag;                              \
+   --sx; --st; /* Convert to last point */            \
+   for (n=n0; n<=n1; ++n, ++y) {                      \
+      if (n < 0 || n >= sy) {                         \
+         *y = 0;                                      \
+         continue;                                    \
+      }                                               \
+      kmax = (n - st < 0)       ? n : st;             \
+      kmin = ((k = n - sx) > 0) ? k : 0;              \
+      for (*y=0, k=kmin; k<=kmax; ++k)                \
+         *y += t[k] * conj(x[sx-(n-k)]);              \
+   }                                                  \
+}
+
+/*!
+ * \brief
+ *    The direct/FFT crossover of conv(), for st and sx
+ */
+#define  _corr_use_fft()                                 \
+   (st >= CONV_FFT_MIN && sx >= CONV_FFT_MIN &&          \
+    (int64_t)st*sx >= CONV_FFT_MIN_OPS)
+
+/*!
+ * \brief
+ *    The main body of the cross-correlation as convolution.
+ *
+ *    With y'[m] = y[sy-1-m] the correlation becomes the convolution
+ *    of the reversed and conjugated target with x:
+ *
+ *    y'[m] = (conj(t[st-1-m]) * x[m])'
+ *
+ *    So we reverse the target, run the convolution and reverse (and
+ *    conjugate) the result back in place. Below the FFT crossover the
+ *    direct body runs instead, with no reversed copy.
+ *
+ * \param _type     The data type
+ * \param _conj     Conjugate function, empty for real data
+ * \param _conv     The conv_xx() or conv_fft_xx() function to use
+ * \param _body     Direct body, used below the crossover or if there is no memory
+ * \param _fft      Non zero to take the convolution path
+ */
+#define  _corr_conv_body(_type, _conj, _conv, _body, _fft) { \
+   _type *tr, v;                                      \
+   int32_t i, sy;                                     \
+                                                      \
+   if (!(_fft) || (tr = (_type*)malloc (st*sizeof (_type))) == NULL) { \
+      _body();                                        \
+      return;                                         \
+   }                                                  \
+   for (i=0 ; i<st ; ++i)                             \
+      tr[i] = _conj (t[st-1-i]);                      \
+   _conv (y, tr, st, x, sx);                          \
+   free ((void*)tr);                                  \
+                                                      \
+   sy = sx + st - 1;                                  \
+   for (i=0 ; i<sy/2 ; ++i) {                         \
+      v = y[i];                                       \
+      y[i] = _conj (y[sy-1-i]);                       \
+      y[sy-1-i] = _conj (v);                          \
+   }                                                  \
+   if (sy & 1)                                        \
+      y[sy/2] = _conj (y[sy/2]);                      \
+}
+
+#define  _corr_abs2_r(_v)     ((double)(_v)*(_v))
+#define  _corr_abs2_c(_v)     (creal(_v)*creal(_v) + cimag(_v)*cimag(_v))
+
+/*!
+ * \brief
+ *    The main body of the normalized cross-correlation.
+ *
+ *    Only the sx-st+1 lags with the whole template over x are needed.
+ *    Below the FFT crossover they are direct sums. Above it the full
+ *    correlation comes from the convolution with the reversed template,
+ *    as in _corr_conv_body, in one scratch buffer. The window energy of x
+ *    is a running sum, re-anchored to an exact sum every st outputs to
+ *    keep the add/subtract rounding from accumulating.
+ *
+ * \param _type     The data type
+ * \param _conj     Conjugate function, empty for real data
+ * \param _conv     The conv_xx() function to use
+ * \param _abs2     The squared magnitude macro
+ */
+#define  _corr_norm_body(_type, _conj, _conv, _abs2) { \
+   _type *c = NULL, *tr, v;                           \
+   double et, ex, d;                                  \
+   int32_t n, k, sv;                                  \
+                                                      \
+   if (st <= 0 || sx < st)                            \
+      return 0;                                       \
+   sv = sx - st + 1;                                  \
+   if (_corr_use_fft ()) {                            \
+      if ((c = (_type*)malloc ((sx+2*st-1)*sizeof (_type))) == NULL) \
+         return 0;                                    \
+      tr = &c[sx+st-1];                               \
+      for (k=0 ; k<st ; ++k)                          \
+         tr[k] = _conj (t[st-1-k]);                   \
+      _conv (c, tr, st, x, sx);                       \
+   }                                                  \
+                                                      \
+   for (et=0, k=0 ; k<st ; ++k)                       \
+      et += _abs2 (t[k]);                             \
+   for (ex=0, n=0 ; n<sv ; ++n) {                     \
+      if (n % st == 0)                                \
+         for (ex=0, k=0 ; k<st ; ++k)                 \
+            ex += _abs2 (x[n+k]);                     \
+      else                                            \
+         ex += _abs2 (x[n+st-1]) - _abs2 (x[n-1]);    \
+      /* Zero lag of window n */                      \
+      if (c)                                          \
+         v = _conj (c[st-1+n]);                       \
+      else                                            \
+         for (v=0, k=0 ; k<st ; ++k)                  \
+            v += t[k] * _conj (x[n+k]);               \
+      d = (ex > 0) ? sqrt (et * ex) : 0;              \
+      y[n] = (d > 0) ? v / d : 0;                     \
+   }                                                  \
+   free ((void*)c);                                   \
+   return sv;                                         \
+}
+
 /*!
  * \brief
  *    Calculates the cross-correlation of int t and x
@@ -97,7 +246,7 @@ void xcorr_i (int *y, int *t, int32_t st, int *x, int32_t sx) {
  * \return none
  */
 void xcorr_f (float *y, float *t, int32_t st, float *x, int32_t sx) {
-   _corr_body_r();
+   _corr_conv_body (float, , conv_f, _corr_body_r, _corr_use_fft ());
 }
 
 /*!
@@ -120,7 +269,7 @@ void xcorr_f (float *y, float *t, int32_t st, float *x, int32_t sx) {
  * \return none
  */
 void xcorr_d (double *y, double *t, int32_t st, double *x, int32_t sx) {
-   _corr_body_r();
+   _corr_conv_body (double, , conv_d, _corr_body_r, _corr_use_fft ());
 }
 
 /*!
@@ -166,7 +315,7 @@ void xcorr_ci (complex_i_t *y, complex_i_t *t, int32_t st, complex_i_t *x, int32
  * \return none
  */
 void xcorr_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx) {
-   _corr_body_c();
+   _corr_conv_body (complex_f_t, conjf, conv_cf, _corr_body_c, _corr_use_fft ());
 }
 
 /*!
@@ -189,8 +338,281 @@ void xcorr_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32
  * \return none
  */
 void xcorr_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx) {
-   _corr_body_c();
+   _corr_conv_body (complex_d_t, conj, conv_cd, _corr_body_c, _corr_use_fft ());
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of int t and x only for
+ *    the lags [-maxlag .. maxlag] around zero lag.
+ *    y[j] is the xcorr_i() output y[sx-1-maxlag+j]
+ *
+ * \param   y  Pointer to output vector, size 2*maxlag+1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ * \param  maxlag  The maximum lag to calculate
+ *
+ * \return none
+ */
+void xcorr_lag_i (int *y, int *t, int32_t st, int *x, int32_t sx, int32_t maxlag) {
+   _corr_lag_body_r();
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of float t and x only for
+ *    the lags [-maxlag .. maxlag] around zero lag.
+ *    y[j] is the xcorr_f() output y[sx-1-maxlag+j]
+ *
+ * \param   y  Pointer to output vector, size 2*maxlag+1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ * \param  maxlag  The maximum lag to calculate
+ *
+ * \return none
+ */
+void xcorr_lag_f (float *y, float *t, int32_t st, float *x, int32_t sx, int32_t maxlag) {
+   _corr_lag_body_r();
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of double t and x only for
+ *    the lags [-maxlag .. maxlag] around zero lag.
+ *    y[j] is the xcorr_d() output y[sx-1-maxlag+j]
+ *
+ * \param   y  Pointer to output vector, size 2*maxlag+1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ * \param  maxlag  The maximum lag to calculate
+ *
+ * \return none
+ */
+void xcorr_lag_d (double *y, double *t, int32_t st, double *x, int32_t sx, int32_t maxlag) {
+   _corr_lag_body_r();
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of complex int t and x only for
+ *    the lags [-maxlag .. maxlag] around zero lag.
+ *    y[j] is the xcorr_ci() output y[sx-1-maxlag+j]
+ *
+ * \param   y  Pointer to output vector, size 2*maxlag+1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ * \param  maxlag  The maximum lag to calculate
+ *
+ * \return none
+ */
+void xcorr_lag_ci (complex_i_t *y, complex_i_t *t, int32_t st, complex_i_t *x, int32_t sx, int32_t maxlag) {
+   _corr_lag_body_c();
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of complex float t and x only for
+ *    the lags [-maxlag .. maxlag] around zero lag.
+ *    y[j] is the xcorr_cf() output y[sx-1-maxlag+j]
+ *
+ * \param   y  Pointer to output vector, size 2*maxlag+1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ * \param  maxlag  The maximum lag to calculate
+ *
+ * \return none
+ */
+void xcorr_lag_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx, int32_t maxlag) {
+   _corr_lag_body_c();
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of complex double t and x only for
+ *    the lags [-maxlag .. maxlag] around zero lag.
+ *    y[j] is the xcorr_cd() output y[sx-1-maxlag+j]
+ *
+ * \param   y  Pointer to output vector, size 2*maxlag+1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ * \param  maxlag  The maximum lag to calculate
+ *
+ * \return none
+ */
+void xcorr_lag_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx, int32_t maxlag) {
+   _corr_lag_body_c();
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of float t and x using the FFT.
+ *    Same output as xcorr_f().
+ *
+ * \param   y  Pointer to output vector, size st+sx-1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+void xcorr_fft_f (float *y, float *t, int32_t st, float *x, int32_t sx) {
+   _corr_conv_body (float, , conv_fft_f, _corr_body_r, 1);
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of double t and x using the FFT.
+ *    Same output as xcorr_d().
+ *
+ * \param   y  Pointer to output vector, size st+sx-1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+void xcorr_fft_d (double *y, double *t, int32_t st, double *x, int32_t sx) {
+   _corr_conv_body (double, , conv_fft_d, _corr_body_r, 1);
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of complex float t and x using the FFT.
+ *    Same output as xcorr_cf().
+ *
+ * \param   y  Pointer to output vector, size st+sx-1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+void xcorr_fft_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx) {
+   _corr_conv_body (complex_f_t, conjf, conv_fft_cf, _corr_body_c, 1);
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of complex double t and x using the FFT.
+ *    Same output as xcorr_cd().
+ *
+ * \param   y  Pointer to output vector, size st+sx-1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return none
+ */
+void xcorr_fft_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx) {
+   _corr_conv_body (complex_d_t, conj, conv_fft_cd, _corr_body_c, 1);
+}
+
+/*!
+ * \brief
+ *    Normalized cross-correlation of the float template t over x
+ *
+ *           st-1
+ *    y[n] = Sum {t[k]*x'[n+k]} / (||t|| * ||x[n .. n+st-1]||)
+ *           k=0
+ *    n: [0 .. sx-st]
+ *
+ * \param   y  Pointer to output vector, size sx-st+1
+ * \param   t  Pointer to the template
+ * \param  st  Size of the template
+ * \param   x  Pointer to input signal
+ * \param  sx  Size of input signal
+ *
+ * \return  The number of outputs, or 0 on failure
+ */
+int xcorr_norm_f (float *y, float *t, int32_t st, float *x, int32_t sx) {
+   _corr_norm_body (float, , conv_f, _corr_abs2_r);
+}
+
+/*!
+ * \brief
+ *    Normalized cross-correlation of the double template t over x
+ *
+ *           st-1
+ *    y[n] = Sum {t[k]*x'[n+k]} / (||t|| * ||x[n .. n+st-1]||)
+ *           k=0
+ *    n: [0 .. sx-st]
+ *
+ * \param   y  Pointer to output vector, size sx-st+1
+ * \param   t  Pointer to the template
+ * \param  st  Size of the template
+ * \param   x  Pointer to input signal
+ * \param  sx  Size of input signal
+ *
+ * \return  The number of outputs, or 0 on failure
+ */
+int xcorr_norm_d (double *y, double *t, int32_t st, double *x, int32_t sx) {
+   _corr_norm_body (double, , conv_d, _corr_abs2_r);
+}
+
+/*!
+ * \brief
+ *    Normalized cross-correlation of the complex float template t over x
+ *
+ *           st-1
+ *    y[n] = Sum {t[k]*x'[n+k]} / (||t|| * ||x[n .. n+st-1]||)
+ *           k=0
+ *    n: [0 .. sx-st]
+ *
+ * \param   y  Pointer to output vector, size sx-st+1
+ * \param   t  Pointer to the template
+ * \param  st  Size of the template
+ * \param   x  Pointer to input signal
+ * \param  sx  Size of input signal
+ *
+ * \return  The number of outputs, or 0 on failure
+ */
+int xcorr_norm_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx) {
+   _corr_norm_body (complex_f_t, conjf, conv_cf, _corr_abs2_c);
+}
+
+/*!
+ * \brief
+ *    Normalized cross-correlation of the complex double template t over x
+ *
+ *           st-1
+ *    y[n] = Sum {t[k]*x'[n+k]} / (||t|| * ||x[n .. n+st-1]||)
+ *           k=0
+ *    n: [0 .. sx-st]
+ *
+ * \param   y  Pointer to output vector, size sx-st+1
+ * \param   t  Pointer to the template
+ * \param  st  Size of the template
+ * \param   x  Pointer to input signal
+ * \param  sx  Size of input signal
+ *
+ * \return  The number of outputs, or 0 on failure
+ */
+int xcorr_norm_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx) {
+   _corr_norm_body (complex_d_t, conj, conv_cd, _corr_abs2_c);
 }
+#undef _corr_norm_body
+#undef _corr_abs2_r
+#undef _corr_abs2_c
+#undef _corr_conv_body
+#undef _corr_use_fft
+#undef _corr_lag_body_r
+#undef _corr_lag_body_c
 #undef _corr_body_r
 #undef _corr_body_c
 
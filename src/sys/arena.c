@@ -0,0 +1,126 @@
+/*
+ * \file arena.c
+ * \brief
+ *    A bump (arena) memory allocator
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2015 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <sys/arena.h>
+
+/*!
+ * \brief
+ *    Arena initialisation over a caller supplied memory block.
+ *    The block should be aligned to ARENA_ALIGN, so the sizes from
+ *    ARENA_SIZE() add up exactly.
+ *
+ * \param  a      Which arena to use
+ * \param  mem    Pointer to the memory block
+ * \param  size   The size of the block in bytes
+ * \return        None
+ */
+void arena_init (arena_t *a, void *mem, size_t size) {
+   a->mem = (byte_t*)mem;
+   a->size = (mem) ? size : 0;
+   a->used = 0;
+}
+
+/*!
+ * \brief
+ *    Allocate size bytes from the arena, aligned to ARENA_ALIGN.
+ *    The memory is not cleared.
+ *
+ * \param  a      Which arena to use
+ * \param  size   The number of bytes
+ * \return        Pointer to the memory, NULL if the arena has not enough space
+ */
+void* arena_alloc (arena_t *a, size_t size) {
+   uintptr_t p = (uintptr_t)(a->mem + a->used);
+   size_t pad = (size_t)(-p & (ARENA_ALIGN - 1));
+
+   if (pad + size > a->size - a->used)
+      return NULL;
+   a->used += pad + ARENA_SIZE (size);
+   if (a->used > a->size)
+      a->used = a->size;
+   return (void*)(p + pad);
+}
+
+/*!
+ * \brief
+ *    Allocate size bytes from the arena, aligned to ARENA_ALIGN
+ *    and cleared to zero.
+ *
+ * \param  a      Which arena to use
+ * \param  size   The number of bytes
+ * \return        Pointer to the memory, NULL if the arena has not enough space
+ */
+void* arena_calloc (arena_t *a, size_t size) {
+   void *p;
+
+   if ((p = arena_alloc (a, size)) != NULL)
+      memset (p, 0, size);
+   return p;
+}
+
+/*!
+ * \brief
+ *    Get the current allocation point, to release everything
+ *    allocated after it with arena_release().
+ *
+ * \param  a      Which arena to use
+ * \return        The mark
+ */
+size_t arena_mark (arena_t *a) {
+   return a->used;
+}
+
+/*!
+ * \brief
+ *    Release everything allocated after a mark.
+ *
+ * \param  a      Which arena to use
+ * \param  mark   The mark from arena_mark()
+ * \return        None
+ */
+void arena_release (arena_t *a, size_t mark) {
+   if (mark < a->used)
+      a->used = mark;
+}
+
+/*!
+ * \brief
+ *    Release all the allocations of the arena.
+ *
+ * \param  a      Which arena to use
+ * \return        None
+ */
+void arena_reset (arena_t *a) {
+   a->used = 0;
+}
+
+/*!
+ * \brief
+ *    Get the free space of the arena.
+ *
+ * \param  a      Which arena to use
+ * \return        The free bytes
+ */
+size_t arena_avail (arena_t *a) {
+   return a->size - a->used;
+}